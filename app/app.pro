@@ -73,6 +73,12 @@ SOURCES += main.cpp\
     audio/transport.cpp \
     audio/timepoint.cpp \
     audio/stretcherrate.cpp \
+    audio/stretcherwsola.cpp \
+    audio/interpolation.cpp \
+    audio/simd.cpp \
+    audio/sampleformat.cpp \
+    audio/pcmcache.cpp \
+    audio/mappedfile.cpp \
     audio/stretcher.cpp \
     audio/soundfile.cpp \
     audio/scheduler.cpp \
@@ -82,7 +88,15 @@ SOURCES += main.cpp\
     audio/pluginmanager.cpp \
     audio/master.cpp \
     audio/envelope.cpp \
+    audio/smoother.cpp \
     audio/command.cpp \
+    audio/commandpool.cpp \
+    audio/workerpool.cpp \
+    audio/bufferarena.cpp \
+    audio/mix.cpp \
+    audio/equalizer.cpp \
+    audio/profiler.cpp \
+    audio/enginestate.cpp \
     audio/audioio.cpp \
     audio/audiobuffer.cpp \
     audio/annotation.cpp \
@@ -101,6 +115,8 @@ SOURCES += main.cpp\
     renameabletabwidget.cpp \
     midirouter.cpp \
     oscsender.cpp \
+    profilemonitor.cpp \
+    profileview.cpp \
     tagmodel.cpp \
     historymanager.cpp \
     audiofiletag.cpp \
@@ -123,6 +139,13 @@ HEADERS  += mainwindow.h \
     audio/transport.hpp \
     audio/timepoint.hpp \
     audio/stretcherrate.hpp \
+    audio/stretcherwsola.hpp \
+    audio/interpolation.hpp \
+    audio/simd.hpp \
+    audio/sampleformat.hpp \
+    audio/pcmcache.hpp \
+    audio/mappedfile.hpp \
+    audio/alignedallocator.hpp \
     audio/stretcher.hpp \
     audio/soundfile.hpp \
     audio/scheduler.hpp \
@@ -133,8 +156,16 @@ HEADERS  += mainwindow.h \
     audio/pluginmanager.h \
     audio/master.hpp \
     audio/envelope.hpp \
-    audio/doublelinkedlist.h \
+    audio/smoother.hpp \
     audio/command.hpp \
+    audio/commandpool.hpp \
+    audio/workerpool.hpp \
+    audio/bufferarena.hpp \
+    audio/mix.hpp \
+    audio/equalizer.hpp \
+    audio/profiler.hpp \
+    audio/enginestate.hpp \
+    audio/mpscqueue.hpp \
     audio/audioio.hpp \
     audio/audiobuffer.hpp \
     audio/annotation.hpp \
@@ -154,6 +185,8 @@ HEADERS  += mainwindow.h \
     renameabletabwidget.h \
     midirouter.h \
     oscsender.h \
+    profilemonitor.h \
+    profileview.h \
     tagmodel.h \
     historymanager.h \
     audiofiletag.h \
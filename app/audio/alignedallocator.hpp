@@ -0,0 +1,56 @@
+#ifndef DATAJOCKEY_ALIGNED_ALLOCATOR_HPP
+#define DATAJOCKEY_ALIGNED_ALLOCATOR_HPP
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+//a standard allocator that returns memory aligned to Alignment bytes,
+//64 keeps a buffer on cache line boundaries which suits any of the vector loads
+#define DJ_CACHE_LINE 64
+
+namespace djaudio {
+  template <typename T, std::size_t Alignment = DJ_CACHE_LINE>
+  class aligned_allocator {
+    public:
+      typedef T value_type;
+      typedef T * pointer;
+      typedef const T * const_pointer;
+      typedef T& reference;
+      typedef const T& const_reference;
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      template <typename U>
+        struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+      aligned_allocator() { }
+      template <typename U>
+        aligned_allocator(const aligned_allocator<U, Alignment>&) { }
+
+      T * allocate(std::size_t n) {
+        if (n == 0)
+          return NULL;
+        void * p = NULL;
+        if (posix_memalign(&p, Alignment, n * sizeof(T)) != 0)
+          throw std::bad_alloc();
+        return static_cast<T *>(p);
+      }
+
+      void deallocate(T * p, std::size_t) { free(p); }
+
+      template <typename U>
+        bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+      template <typename U>
+        bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+  };
+
+  //round a count of T up so that the next item starts on an alignment boundary
+  template <typename T, std::size_t Alignment = DJ_CACHE_LINE>
+    std::size_t aligned_count(std::size_t n) {
+      const std::size_t per = Alignment / sizeof(T);
+      return ((n + per - 1) / per) * per;
+    }
+}
+
+#endif
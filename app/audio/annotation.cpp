@@ -8,6 +8,7 @@
 
 #include <yaml-cpp/yaml.h>
 #include <iostream>
+#include <algorithm>
 
 using namespace djaudio;
 
@@ -83,6 +84,105 @@ std::deque<int> BeatBuffer::distances() const {
   return v;
 }
 
+namespace {
+  //how far the hinted lookup walks before it falls back to a search
+  const int beat_walk_max = 4;
+}
+
+int BeatBuffer::beat_index(int frame, int hint) const {
+  const int count = static_cast<int>(size());
+  if (hint >= 0 && hint < count) {
+    //the play head moves a little between lookups so the answer is usually the hint or the beat after it
+    const int * beats = data();
+    if (beats[hint] <= frame) {
+      for (int i = 0; i < beat_walk_max; i++) {
+        if (hint + 1 == count || beats[hint + 1] > frame)
+          return hint;
+        hint++;
+      }
+    } else {
+      for (int i = 0; i < beat_walk_max; i++) {
+        if (hint == 0)
+          return 0;
+        hint--;
+        if (beats[hint] <= frame)
+          return hint;
+      }
+    }
+  }
+
+  //finds the first element which is greater than frame
+  const_iterator it = std::upper_bound(begin(), end(), frame);
+  if (it == end())
+    return count - 1;
+  if (it == begin())
+    return 0;
+  return it - begin() - 1;
+}
+
+int BeatBuffer::closest_index(int frame, int hint) const {
+  int beat = beat_index(frame, hint);
+  if (beat + 1 == static_cast<int>(size()))
+    return beat;
+  int diffs[2] = {frame - at(beat), at(beat + 1) - frame};
+  if (diffs[0] < diffs[1])
+    return beat;
+  return beat + 1;
+}
+
+int BeatBuffer::beat_frames(unsigned int beat) const {
+  if (size() < 2)
+    return 0;
+  if (beat + 1 >= size())
+    beat = size() - 2;
+  if (updated(beat))
+    return mBeatFrames[beat];
+  return at(beat + 1) - at(beat);
+}
+
+double BeatBuffer::pos_in_beat(int frame, unsigned int beat) const {
+  if (beat + 1 >= size())
+    return 0.0;
+  double inverse = 0.0;
+  if (updated(beat)) {
+    inverse = mBeatFramesInverse[beat];
+  } else {
+    const int frames = at(beat + 1) - at(beat);
+    if (frames > 0)
+      inverse = 1.0 / static_cast<double>(frames);
+  }
+  return static_cast<double>(frame - at(beat)) * inverse;
+}
+
+double BeatBuffer::bpm(unsigned int beat, unsigned int sample_rate) const {
+  if (size() < 2)
+    return 0.0;
+  if (beat + 1 >= size())
+    beat = size() - 2;
+  if (updated(beat))
+    return 60.0 * static_cast<double>(sample_rate) * mBeatFramesInverse[beat];
+  const int frames = beat_frames(beat);
+  if (frames <= 0)
+    return 0.0;
+  return 60.0 * static_cast<double>(sample_rate) / static_cast<double>(frames);
+}
+
+void BeatBuffer::update() {
+  mBeatFrames.resize(size());
+  mBeatFramesInverse.resize(size());
+  if (empty())
+    return;
+  for (unsigned int i = 1; i < size(); i++) {
+    const int frames = at(i) - at(i - 1);
+    mBeatFrames[i - 1] = frames;
+    mBeatFramesInverse[i - 1] = frames > 0 ? 1.0 / static_cast<double>(frames) : 0.0;
+  }
+  //the last beat has no next one, give it the length of the one before it
+  const unsigned int last = size() - 1;
+  mBeatFrames[last] = last > 0 ? mBeatFrames[last - 1] : 0;
+  mBeatFramesInverse[last] = last > 0 ? mBeatFramesInverse[last - 1] : 0.0;
+}
+
 bool Annotation::loadFile(QString& file_path) {
   //clear();
   if (mBeatBuffer) 
@@ -103,6 +203,7 @@ bool Annotation::loadFile(QString& file_path) {
       const YAML::Node& beats = (locs.Type() == YAML::NodeType::Sequence) ? locs[locs.size() - 1]["frames"] : locs["frames"];
       for (unsigned int i = 0; i < beats.size(); i++)
         mBeatBuffer->push_back(beats[i].as<int>());
+      mBeatBuffer->update();
     }
   } catch(...) {
     cerr << "problem loading " << qPrintable(file_path) << endl;
@@ -7,15 +7,43 @@
 #include <QHash>
 #include <QVariant>
 #include <deque>
+#include <vector>
 #include <QExplicitlySharedDataPointer>
 #include <QFileDevice>
 
 namespace djaudio {
   int median(const std::deque<int>& values);
 
-  class BeatBuffer : public std::deque<int>, public QSharedData {
+  //beat locations in frames, sorted and contiguous so the player can walk them
+  class BeatBuffer : public std::vector<int>, public QSharedData {
     public:
       std::deque<int> distances() const;
+      //the index of the last beat at or before frame, the first or last beat if frame is outside of them
+      //hint is a previous result, when frame is a few beats from it we walk there instead of searching
+      int beat_index(int frame, int hint = -1) const;
+      //the index of the beat nearest to frame
+      int closest_index(int frame, int hint = -1) const;
+
+      //frames from beat to the next one, the last beat uses the length of the one before it
+      //0 if there are fewer than 2 beats
+      int beat_frames(unsigned int beat) const;
+      //where frame is within beat, 0..1 inside of it
+      double pos_in_beat(int frame, unsigned int beat) const;
+      //the tempo at beat for audio played back at sample_rate frames per second, 0 if unknown
+      double bpm(unsigned int beat, unsigned int sample_rate) const;
+
+      //precompute the per beat lengths, call after changing the beats
+      //the lookups above still work on a stale buffer, just without the precomputed values
+      void update();
+    private:
+      //the precomputed values for beat, which has a next one, are current, checked against the beats
+      //themselves so that a beat moved without an update is caught too
+      bool updated(unsigned int beat) const {
+        return mBeatFrames.size() == size() && mBeatFrames[beat] == at(beat + 1) - at(beat);
+      }
+      std::vector<int> mBeatFrames;
+      //1 / mBeatFrames, so positions and tempos multiply instead of divide
+      std::vector<double> mBeatFramesInverse;
   };
 
   typedef QExplicitlySharedDataPointer<BeatBuffer> BeatBufferPtr;
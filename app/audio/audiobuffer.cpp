@@ -1,8 +1,18 @@
 #include "audiobuffer.hpp"
+#include "pcmcache.hpp"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <cmath>
 
 #define READ_FRAME_SIZE 32768
+//the first read is small so that playback can start as soon as possible
+#define READ_FIRST_FRAME_SIZE 4096
+//the number of frames that share an int16 scale factor
+#define COMPACT_BLOCK_FRAMES 1024
 
 template<typename Type>
 Type linear_interp(Type v0, Type v1, double dist){
@@ -11,14 +21,31 @@ Type linear_interp(Type v0, Type v1, double dist){
 
 using namespace djaudio;
 
-AudioBuffer::AudioBuffer(QString soundfileLocation)
+AudioBuffer::AudioBuffer(QString soundfileLocation, layout_t layout, sample_storage_t storage)
   throw(std::runtime_error) :
     mSoundFile(soundfileLocation),
+    mSamples(NULL),
+    mCompact(NULL),
+    mScales(NULL),
+    mCacheMaxBytes(0),
+    mResidentFrames(0),
+    mResidentFrame(0),
+    mResidentLoopStart(0),
+    mResidentLoopEnd(0),
+    mResident(false),
+    mCompactBlocks(0),
+    mLayout(storage == STORAGE_FLOAT ? layout : PLANAR),
+    mStorage(storage),
+    mFrames(0),
+    mDecodedFrames(0),
+    mCapacity(0),
+    mChannelOffset(0),
     mLoaded(false),
     mAbort(false),
     mNumChannels(0),
     mMaxSample(0.0),
-    mNormalize(true)
+    mNormalize(true),
+    mGain(1.0f)
 {
 
   //check to make sure soundfile exists
@@ -30,6 +57,7 @@ AudioBuffer::AudioBuffer(QString soundfileLocation)
 
   mSampleRate = mSoundFile.samplerate();
   mNumChannels = mSoundFile.channels();
+  mFrames = mSoundFile.frames();
 }
 
 AudioBuffer::~AudioBuffer() {
@@ -45,12 +73,11 @@ unsigned int AudioBuffer::channels() const {
 }
 
 unsigned int AudioBuffer::length() const{
-  if (!mLoaded)
-    return mSoundFile.frames();
-  unsigned int chans = channels();
-  if (chans)
-    return mAudioData.size() / chans;
-  return 0;
+  return mFrames.load(std::memory_order_acquire);
+}
+
+unsigned int AudioBuffer::decoded_frames() const {
+  return mDecodedFrames.load(std::memory_order_acquire);
 }
 
 double AudioBuffer::seconds() const {
@@ -62,15 +89,33 @@ double AudioBuffer::seconds() const {
   return static_cast<double>(frames) / static_cast<double>(mSampleRate);
 }
 
+AudioBuffer::layout_t AudioBuffer::layout() const { return mLayout; }
+sample_storage_t AudioBuffer::storage() const { return mStorage; }
+
 bool AudioBuffer::loaded() const { return mLoaded; }
 
+void AudioBuffer::normalize(bool v) { mNormalize = v; }
+
+void AudioBuffer::cache(const QString& directory, qint64 max_bytes, double resident_seconds) {
+  mCacheDir = directory;
+  mCacheMaxBytes = max_bytes;
+  mResidentFrames = resident_seconds > 0.0 ? static_cast<unsigned int>(resident_seconds * mSampleRate) : 0;
+}
+
+bool AudioBuffer::cached() const { return mCacheMap.is_open(); }
+
+float AudioBuffer::gain() const { return mGain.load(std::memory_order_relaxed); }
+
 float AudioBuffer::sample(unsigned int channel, unsigned int index) const{
-  index = channel + index * channels();
   //make sure we're in range
-  if(mAudioData.size() <= index)
+  if (index >= decoded_frames() || channel >= channels())
     return 0.0;
-  else
-    return mAudioData.at(index);
+  if (mStorage != STORAGE_FLOAT) {
+    float v;
+    read_compact(channel, index, &v, 1);
+    return v * gain();
+  }
+  return channel_data(channel)[index * stride()] * gain();
 }
 
 float AudioBuffer::sample(unsigned int channel, unsigned int index, double subsample) const {
@@ -88,25 +133,345 @@ using std::cerr;
 using std::endl;
 
 void AudioBuffer::fill_mono(data_buffer_t& buffer, unsigned int start_index) const {
+  if (buffer.size())
+    fill_mono(&buffer.front(), buffer.size(), start_index);
+}
+
+void AudioBuffer::fill_mono(float * buffer, unsigned int frames, unsigned int start_index) const {
   const unsigned int num_channels = channels();
   if (num_channels == 0) {
     cerr << "num_channels == 0" << endl;
+    memset(buffer, 0, sizeof(float) * frames);
+    return;
   }
-  const unsigned int frames = buffer.size();
-  const unsigned int frames_total = mAudioData.size() / num_channels;
-  const unsigned int valid_frames = ((frames + start_index) <= frames_total) ? frames : frames_total - start_index;
+  const unsigned int decoded = decoded_frames();
+  const unsigned int valid_frames = (start_index >= decoded) ? 0 : std::min(frames, decoded - start_index);
+  const unsigned int step = stride();
 
-  unsigned int i = 0;
-  float mult = 1.0f / (float)num_channels;
-  for (; i < valid_frames; i++) {
-    buffer[i] = 0.0f;
-    for (unsigned int j = 0; j < num_channels; j++)
-      buffer[i] += mAudioData[(start_index + i) * num_channels + j];
+  //sum one channel at a time so that planar data is read sequentially
+  memset(buffer, 0, sizeof(float) * frames);
+  std::vector<float> converted;
+  if (mStorage != STORAGE_FLOAT)
+    converted.resize(valid_frames);
+  for (unsigned int c = 0; c < num_channels; c++) {
+    if (converted.size()) {
+      read_compact(c, start_index, &converted.front(), valid_frames);
+      for (unsigned int i = 0; i < valid_frames; i++)
+        buffer[i] += converted[i];
+      continue;
+    }
+    if (valid_frames == 0)
+      break;
+    const float * src = channel_data(c) + start_index * step;
+    if (step == 1) {
+      for (unsigned int i = 0; i < valid_frames; i++)
+        buffer[i] += src[i];
+    } else {
+      for (unsigned int i = 0; i < valid_frames; i++)
+        buffer[i] += src[i * step];
+    }
+  }
+
+  const float mult = gain() / (float)num_channels;
+  for (unsigned int i = 0; i < valid_frames; i++)
     buffer[i] *= mult;
+}
+
+const float * AudioBuffer::channel_data(unsigned int channel) const {
+  if (!mSamples)
+    return NULL;
+  if (mLayout == PLANAR)
+    return mSamples + channel * mChannelOffset;
+  return mSamples + channel;
+}
+
+unsigned int AudioBuffer::stride() const {
+  return (mLayout == PLANAR) ? 1 : channels();
+}
+
+unsigned int AudioBuffer::read_block(unsigned int channel, unsigned int start_index, float * dest, unsigned int frames) const {
+  unsigned int valid_frames = 0;
+  const unsigned int decoded = decoded_frames();
+  if (channel < channels() && start_index < decoded) {
+    valid_frames = std::min(frames, decoded - start_index);
+    if (mStorage != STORAGE_FLOAT) {
+      read_compact(channel, start_index, dest, valid_frames);
+    } else {
+      const unsigned int step = stride();
+      const float * src = channel_data(channel) + start_index * step;
+      if (step == 1) {
+        memcpy(dest, src, sizeof(float) * valid_frames);
+      } else {
+        for (unsigned int i = 0; i < valid_frames; i++)
+          dest[i] = src[i * step];
+      }
+    }
+  }
+  if (valid_frames < frames)
+    memset(dest + valid_frames, 0, sizeof(float) * (frames - valid_frames));
+  return valid_frames;
+}
+
+void AudioBuffer::allocate(unsigned int frames) {
+  const unsigned int chans = channels();
+  mCapacity = frames;
+  if (mStorage != STORAGE_FLOAT) {
+    mChannelOffset = aligned_count<uint16_t>(frames);
+    mCompactBlocks = (frames + COMPACT_BLOCK_FRAMES - 1) / COMPACT_BLOCK_FRAMES;
+    mCompactData.assign(static_cast<size_t>(mChannelOffset) * chans, 0);
+    mCompact = mCompactData.empty() ? NULL : &mCompactData.front();
+    if (mStorage == STORAGE_INT16) {
+      mCompactScales.assign(static_cast<size_t>(mCompactBlocks) * chans, int16_scale(0.0f));
+      mScales = mCompactScales.empty() ? NULL : &mCompactScales.front();
+    }
+    return;
+  }
+
+  if (mLayout == PLANAR) {
+    mChannelOffset = aligned_count<float>(frames);
+    mAudioData.assign(static_cast<size_t>(mChannelOffset) * chans, 0.0f);
+  } else {
+    mAudioData.assign(static_cast<size_t>(frames) * chans, 0.0f);
+  }
+  mSamples = mAudioData.empty() ? NULL : &mAudioData.front();
+}
+
+void AudioBuffer::store(const float * interleaved, unsigned int start_index, unsigned int frames) {
+  const unsigned int chans = channels();
+
+  //find the peak for normalization
+  mMaxSample = std::max(mMaxSample, abs_peak(interleaved, frames * chans));
+
+  if (mStorage == STORAGE_FLOAT && mLayout == INTERLEAVED) {
+    memcpy(&mAudioData.front() + static_cast<size_t>(start_index) * chans, interleaved, sizeof(float) * frames * chans);
+    return;
+  }
+
+  if (mStorage == STORAGE_FLOAT) {
+    for (unsigned int c = 0; c < chans; c++) {
+      float * dest = &mAudioData.front() + c * mChannelOffset + start_index;
+      const float * src = interleaved + c;
+      for (unsigned int i = 0; i < frames; i++)
+        dest[i] = src[i * chans];
+    }
+    return;
+  }
+
+  //compact, start_index is always on a block boundary because the reads are a multiple of the block size
+  float block[COMPACT_BLOCK_FRAMES];
+  for (unsigned int c = 0; c < chans; c++) {
+    uint16_t * dest = &mCompactData.front() + c * mChannelOffset;
+    for (unsigned int offset = 0; offset < frames; offset += COMPACT_BLOCK_FRAMES) {
+      const unsigned int count = std::min(static_cast<unsigned int>(COMPACT_BLOCK_FRAMES), frames - offset);
+      const unsigned int index = start_index + offset;
+      for (unsigned int i = 0; i < count; i++)
+        block[i] = interleaved[(offset + i) * chans + c];
+      if (mStorage == STORAGE_INT16) {
+        const float scale = int16_scale(abs_peak(block, count));
+        mCompactScales[c * mCompactBlocks + index / COMPACT_BLOCK_FRAMES] = scale;
+        float_to_int16(block, reinterpret_cast<int16_t *>(dest + index), count, scale);
+      } else {
+        float_to_half(block, dest + index, count);
+      }
+    }
+  }
+}
+
+void AudioBuffer::read_compact(unsigned int channel, unsigned int start_index, float * dest, unsigned int frames) const {
+  const uint16_t * src = mCompact + channel * mChannelOffset;
+  if (mStorage == STORAGE_HALF) {
+    half_to_float(src + start_index, dest, frames);
+    return;
+  }
+
+  //convert up to each block boundary with that block's scale
+  const float * scales = mScales + channel * mCompactBlocks;
+  while (frames) {
+    const unsigned int block = start_index / COMPACT_BLOCK_FRAMES;
+    const unsigned int count = std::min(frames, (block + 1) * COMPACT_BLOCK_FRAMES - start_index);
+    int16_to_float(reinterpret_cast<const int16_t *>(src + start_index), dest, count, scales[block]);
+    start_index += count;
+    dest += count;
+    frames -= count;
+  }
+}
+
+bool AudioBuffer::load_cache(const QString& cache_file) {
+  if (!QFile::exists(cache_file) || !mCacheMap.open(cache_file, mResidentFrames == 0))
+    return false;
+
+  const char * base = mCacheMap.data();
+  const uint64_t size = mCacheMap.size();
+  const unsigned int chans = channels();
+  pcmcache::header_t header;
+  bool ok = size >= sizeof(header);
+  if (ok) {
+    memcpy(&header, base, sizeof(header));
+    const uint64_t sample_bytes = (mStorage == STORAGE_FLOAT) ? sizeof(float) : sizeof(uint16_t);
+    const uint64_t samples = static_cast<uint64_t>(mLayout == PLANAR ? header.channel_offset : header.frames) * chans;
+    ok = header.magic == pcmcache::MAGIC && header.version == pcmcache::VERSION &&
+      header.sample_rate == mSampleRate && header.channels == chans &&
+      header.storage == static_cast<uint32_t>(mStorage) && header.layout == static_cast<uint32_t>(mLayout) &&
+      header.frames > 0 && (mLayout != PLANAR || header.frames <= header.channel_offset) &&
+      header.data_offset % pcmcache::DATA_ALIGNMENT == 0 &&
+      header.data_bytes == samples * sample_bytes &&
+      header.data_offset + header.data_bytes <= size;
+    if (ok && mStorage == STORAGE_INT16) {
+      ok = static_cast<uint64_t>(header.compact_blocks) * COMPACT_BLOCK_FRAMES >= header.frames &&
+        header.scales_offset % sizeof(float) == 0 &&
+        header.scales_bytes == static_cast<uint64_t>(header.compact_blocks) * chans * sizeof(float) &&
+        header.scales_offset + header.scales_bytes <= size;
+    }
+  }
+  if (!ok) {
+    cerr << "removing invalid cache file: " << qPrintable(cache_file) << endl;
+    mCacheMap.close();
+    QFile::remove(cache_file);
+    return false;
+  }
+
+  mCapacity = header.frames;
+  mChannelOffset = header.channel_offset;
+  mCompactBlocks = header.compact_blocks;
+  mMaxSample = header.peak;
+  if (mStorage == STORAGE_FLOAT) {
+    mSamples = reinterpret_cast<const float *>(base + header.data_offset);
+  } else {
+    mCompact = reinterpret_cast<const uint16_t *>(base + header.data_offset);
+    if (mStorage == STORAGE_INT16)
+      mScales = reinterpret_cast<const float *>(base + header.scales_offset);
+  }
+
+  if (mNormalize && mMaxSample > 0.0 && mMaxSample < 1.0)
+    mGain.store(1.0f / mMaxSample, std::memory_order_relaxed);
+  keep_resident(0);
+  mDecodedFrames.store(header.frames, std::memory_order_release);
+  mFrames.store(header.frames, std::memory_order_release);
+  mLoaded = true;
+  return true;
+}
+
+void AudioBuffer::write_cache(const QString& cache_file) const {
+  const QString dir_name = QFileInfo(cache_file).absolutePath();
+  if (!QDir().mkpath(dir_name))
+    return;
+
+  const unsigned int chans = channels();
+  const unsigned int frames = decoded_frames();
+  pcmcache::header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = pcmcache::MAGIC;
+  header.version = pcmcache::VERSION;
+  header.sample_rate = mSampleRate;
+  header.channels = chans;
+  header.frames = frames;
+  header.storage = mStorage;
+  header.layout = mLayout;
+  header.channel_offset = mChannelOffset;
+  header.compact_blocks = mCompactBlocks;
+  header.peak = mMaxSample;
+  header.data_offset = pcmcache::DATA_ALIGNMENT;
+
+  const char * data;
+  if (mStorage == STORAGE_FLOAT) {
+    data = reinterpret_cast<const char *>(mSamples);
+    header.data_bytes = sizeof(float) * static_cast<uint64_t>(mLayout == PLANAR ? mChannelOffset : frames) * chans;
+  } else {
+    data = reinterpret_cast<const char *>(mCompact);
+    header.data_bytes = sizeof(uint16_t) * static_cast<uint64_t>(mChannelOffset) * chans;
+  }
+  if (mStorage == STORAGE_INT16) {
+    header.scales_offset = aligned_count<char>(header.data_offset + header.data_bytes);
+    header.scales_bytes = sizeof(float) * mCompactScales.size();
+  }
+
+  //write to a temporary file and rename it into place so a reader never sees a partial file
+  QTemporaryFile file(QDir(dir_name).filePath("XXXXXX.tmp"));
+  if (!file.open())
+    return;
+  bool ok = file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+  ok = ok && file.seek(header.data_offset);
+  const qint64 chunk = 1 << 20;
+  for (uint64_t offset = 0; ok && offset < header.data_bytes; offset += chunk) {
+    if (mAbort)
+      return;
+    const qint64 count = std::min(static_cast<uint64_t>(chunk), header.data_bytes - offset);
+    ok = file.write(data + offset, count) == count;
+  }
+  if (ok && header.scales_bytes) {
+    ok = file.seek(header.scales_offset) &&
+      file.write(reinterpret_cast<const char *>(&mCompactScales.front()), header.scales_bytes) == static_cast<qint64>(header.scales_bytes);
+  }
+  ok = ok && file.flush();
+  if (!ok) {
+    cerr << "problem writing cache file: " << qPrintable(cache_file) << endl;
+    return;
+  }
+
+  //another deck may have cached the same file meanwhile
+  if (QFile::exists(cache_file))
+    return;
+  //after a rename the temporary file would auto remove the new name
+  file.setAutoRemove(false);
+  if (!file.rename(cache_file)) {
+    file.remove();
+    return;
+  }
+  pcmcache::prune(mCacheDir, mCacheMaxBytes);
+}
+
+void AudioBuffer::keep_resident(unsigned int frame, unsigned int loop_start, unsigned int loop_end) {
+  if (mResidentFrames == 0 || !mCacheMap.is_open())
+    return;
+  if (loop_end <= loop_start)
+    loop_start = loop_end = 0;
+
+  //mostly ahead of the play head with a little behind it for short jumps back
+  const unsigned int behind = mResidentFrames / 4;
+  const unsigned int moved = std::max(frame, mResidentFrame) - std::min(frame, mResidentFrame);
+  if (mResident && moved < behind && loop_start == mResidentLoopStart && loop_end == mResidentLoopEnd)
+    return;
+  mResident = true;
+  mResidentFrame = frame;
+  mResidentLoopStart = loop_start;
+  mResidentLoopEnd = loop_end;
+
+  const unsigned int start = frame > behind ? frame - behind : 0;
+  const unsigned int end = std::min(mCapacity, frame + std::min(mResidentFrames, mCapacity));
+  std::vector<MappedFile::range_t> ranges;
+  mapped_ranges(ranges, start, end);
+  //the start of the track is the usual place to cue from
+  mapped_ranges(ranges, 0, std::min(behind, mCapacity));
+  if (loop_end)
+    mapped_ranges(ranges, loop_start, std::min(loop_end, mCapacity));
+  if (mScales) {
+    const char * scales = reinterpret_cast<const char *>(mScales);
+    ranges.push_back(MappedFile::range_t(scales - mCacheMap.data(), sizeof(float) * mCompactBlocks * channels()));
+  }
+  mCacheMap.lock(ranges);
+
+  //start reading the next window in the background
+  ranges.clear();
+  mapped_ranges(ranges, end, std::min(mCapacity, end + std::min(mResidentFrames, mCapacity)));
+  for (size_t i = 0; i < ranges.size(); i++)
+    mCacheMap.will_need(ranges[i]);
+}
+
+void AudioBuffer::mapped_ranges(std::vector<MappedFile::range_t>& ranges, unsigned int start, unsigned int end) const {
+  if (end <= start)
+    return;
+  const unsigned int chans = channels();
+  const size_t sample_bytes = (mStorage == STORAGE_FLOAT) ? sizeof(float) : sizeof(uint16_t);
+  const char * samples = (mStorage == STORAGE_FLOAT) ? reinterpret_cast<const char *>(mSamples) : reinterpret_cast<const char *>(mCompact);
+  const size_t base = samples - mCacheMap.data();
+  if (mLayout == INTERLEAVED) {
+    ranges.push_back(MappedFile::range_t(base + sample_bytes * start * chans, sample_bytes * (end - start) * chans));
+    return;
+  }
+  for (unsigned int c = 0; c < chans; c++) {
+    const size_t offset = static_cast<size_t>(c) * mChannelOffset + start;
+    ranges.push_back(MappedFile::range_t(base + sample_bytes * offset, sample_bytes * (end - start)));
   }
-  //zero pad
-  for (; i < frames; i++)
-    buffer[i] = 0.0f;
 }
 
 bool AudioBuffer::valid() const {
@@ -124,72 +489,119 @@ bool AudioBuffer::load(progress_callback_t progress_callback, void * user_data)
 
   float * inbuf = NULL;
   unsigned int frames_read;
-  unsigned int chans;
-
-  //read in the audio data
-  inbuf = new float[READ_FRAME_SIZE * channels()];
-  chans = channels();
-  double num_frames = (double)mSoundFile.frames();
+  const unsigned int chans = channels();
+  const unsigned int frames_expected = mSoundFile.frames();
   unsigned int total_read = 0;
   unsigned int percent_last = 0;
+  //if we don't know the length up front we have to read it all before we can store it
+  std::vector<float> unknown_length;
+  bool warned = false;
+
+  //a cached copy is mapped in without decoding anything
+  QString cache_file;
+  if (!mCacheDir.isEmpty())
+    cache_file = pcmcache::file_for(mCacheDir, mSoundFile.location(), mStorage, mLayout == PLANAR);
+  if (!cache_file.isEmpty() && load_cache(cache_file)) {
+    pcmcache::touch(cache_file);
+    if (progress_callback)
+      progress_callback(100, user_data);
+    return true;
+  }
 
   if (progress_callback)
     progress_callback(0, user_data);
 
   try {
-    while(!mAbort && (frames_read = mSoundFile.readf(inbuf, READ_FRAME_SIZE)) != 0){
-      for(unsigned int i = 0; i < frames_read; i++){
-        for(unsigned int j = 0; j < chans; j++){
-          float v = inbuf[i * chans + j];
-          mAudioData.push_back(v);
-          //find the max sample for normalization
-          mMaxSample = std::max(v, mMaxSample);
+    if (chans == 0)
+      throw std::runtime_error("soundfile has no channels");
+
+    //allocate everything up front so that the storage never moves, then readers can use
+    //whatever has been decoded while we keep going
+    if (frames_expected)
+      allocate(frames_expected);
+
+    //read in the audio data
+    inbuf = new float[READ_FRAME_SIZE * chans];
+    unsigned int read_size = READ_FIRST_FRAME_SIZE;
+    while(!mAbort && (frames_read = mSoundFile.readf(inbuf, read_size)) != 0){
+      read_size = READ_FRAME_SIZE;
+      const bool first_read = total_read == 0;
+      if (frames_expected == 0) {
+        unknown_length.insert(unknown_length.end(), inbuf, inbuf + frames_read * chans);
+      } else {
+        //length estimates for compressed files can be short, we can't grow so drop the extra
+        const unsigned int count = std::min(frames_read, mCapacity - total_read);
+        if (count < frames_read && !warned) {
+          cerr << "more frames than expected, dropping the extra, file name: " << qPrintable(mSoundFile.location()) << endl;
+          warned = true;
         }
+        store(inbuf, total_read, count);
+        frames_read = count;
       }
+      total_read += frames_read;
+
+      //publish what we've decoded
+      if (frames_expected)
+        mDecodedFrames.store(total_read, std::memory_order_release);
 
-      //report progress
-      if (progress_callback && num_frames != 0) {
-        total_read += frames_read;
-        unsigned int new_percent = (double)(100 * total_read) / num_frames;
-        if (new_percent != percent_last) {
+      //report progress, always after the first read so the caller can start using the data
+      if (progress_callback) {
+        unsigned int new_percent = frames_expected ? (100.0 * total_read) / frames_expected : 0;
+        new_percent = std::min(new_percent, 99u);
+        if (new_percent != percent_last || first_read) {
           percent_last = new_percent;
           progress_callback(percent_last, user_data);
         }
       }
+      if (frames_expected && total_read >= mCapacity)
+        break;
     }
     delete [] inbuf;
+    inbuf = NULL;
 
     if (!mAbort) {
-      if (mNormalize && mMaxSample > 0.0 && mMaxSample < 1.0) {
-        float mul = 1.0 / mMaxSample;
-        for (unsigned int i = 0; i < mAudioData.size(); i++)
-          mAudioData[i] *= mul;
+      if (frames_expected == 0) {
+        total_read = unknown_length.size() / chans;
+        allocate(total_read);
+        for (unsigned int offset = 0; offset < total_read; offset += READ_FRAME_SIZE)
+          store(&unknown_length.front() + static_cast<size_t>(offset) * chans, offset, std::min(static_cast<unsigned int>(READ_FRAME_SIZE), total_read - offset));
+        std::vector<float>().swap(unknown_length);
       }
 
+      //the samples may already be playing, so rather than rewrite them we provide a gain to apply
+      if (mNormalize && mMaxSample > 0.0 && mMaxSample < 1.0)
+        mGain.store(1.0f / mMaxSample, std::memory_order_relaxed);
+
+      mDecodedFrames.store(total_read, std::memory_order_release);
+      mFrames.store(total_read, std::memory_order_release);
       mLoaded = true;
       if (progress_callback)
         progress_callback(100, user_data);
+
+      //the data is already in use, so this only costs the loading thread
+      if (!cache_file.isEmpty() && total_read)
+        write_cache(cache_file);
       return true;
     }
     return false;
   } catch (std::bad_alloc& ba) {
     std::cerr << "bad_alloc caught: " << ba.what() << std::endl;
     std::cerr << "file name: " << qPrintable(mSoundFile.location()) << std::endl;
-    return false;
   } catch (std::runtime_error& e) {
     std::cerr << "exception caught: " << e.what() << std::endl;
     std::cerr << "file name: " << qPrintable(mSoundFile.location()) << std::endl;
-    return false;
   } catch (...) {
     std::cerr << "unknown exception caught" << std::endl;
     std::cerr << "file name: " << qPrintable(mSoundFile.location()) << std::endl;
-    return false;
   }
+  if (inbuf)
+    delete [] inbuf;
+  return false;
 }
 
 void AudioBuffer::abort_load(){ mAbort = true; }
 
-const AudioBuffer::data_buffer_t& AudioBuffer::raw_buffer() const {
+const AudioBuffer::sample_buffer_t& AudioBuffer::raw_buffer() const {
   return mAudioData;
 }
 
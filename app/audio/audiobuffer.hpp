@@ -3,7 +3,11 @@
 
 #include <stdexcept>
 #include <vector>
+#include <atomic>
 #include "soundfile.hpp"
+#include "alignedallocator.hpp"
+#include "sampleformat.hpp"
+#include "mappedfile.hpp"
 #include <QString>
 #include <QSharedData>
 #include <QExplicitlySharedDataPointer>
@@ -12,19 +16,52 @@ namespace djaudio {
   class AudioBuffer : public QSharedData {
     public:
       typedef std::vector<float > data_buffer_t; 
+      //the sample storage, cache line aligned
+      typedef std::vector<float, aligned_allocator<float> > sample_buffer_t;
+      //compact storage, int16 or half float bits
+      typedef std::vector<uint16_t, aligned_allocator<uint16_t> > compact_buffer_t;
       typedef void (* progress_callback_t)(int percent, void * user_data);
 
-      AudioBuffer(QString soundfileLocation) throw(std::runtime_error);
+      //interleaved stores frames together, planar stores each channel in its own contiguous array
+      enum layout_t { INTERLEAVED, PLANAR };
+
+      //compact storage always uses the planar layout
+      AudioBuffer(QString soundfileLocation, layout_t layout = INTERLEAVED, sample_storage_t storage = STORAGE_FLOAT) throw(std::runtime_error);
       virtual ~AudioBuffer();
       //returns true if completely loaded
+      //the samples can be read from other threads while this is running, up to decoded_frames()
       bool load(progress_callback_t progress_callback = NULL, void * user_data = NULL);
       void abort_load();
 
+      //keep the decoded audio in this directory so that loading the same file again maps it straight in
+      //prunes the least recently used files down to max_bytes after writing, 0 for no limit
+      //with resident_seconds a cached file is mapped without reading it in, see keep_resident,
+      //0 reads the whole file in on load
+      //call before load, an empty directory disables the cache
+      void cache(const QString& directory, qint64 max_bytes = 0, double resident_seconds = 0.0);
+      //true if the samples came from the cache
+      bool cached() const;
+      //for a lazily mapped cache file, lock the frames around the play head, the start and the loop into memory
+      //and read ahead beyond that, so that the audio thread doesn't fault on them
+      //call from a thread that can block, it returns right away until the play head has moved a fair bit
+      void keep_resident(unsigned int frame, unsigned int loop_start = 0, unsigned int loop_end = 0);
+
+      //compute a gain that brings the peak to full scale once loaded, on by default
+      void normalize(bool v);
+      //the normalization gain, 1 until the load completes
+      //the samples are stored as decoded, sample() and fill_mono() apply this, the raw accessors don't
+      float gain() const;
+
       //getters
       unsigned int sample_rate() const;
       unsigned int channels() const;
+      //the expected length until the load completes
       unsigned int length() const;
+      //the number of frames that are ready to read, reads past this give silence
+      unsigned int decoded_frames() const;
       double seconds() const;
+      layout_t layout() const;
+      sample_storage_t storage() const;
 
       bool loaded() const;
       //grab a sample
@@ -36,20 +73,64 @@ namespace djaudio {
       //expects the buffer to be resized to its desired fill size
       //zero pads the output buffer if you pass the end of the valid data
       void fill_mono(data_buffer_t& buffer, unsigned int start_index) const;
+      void fill_mono(float * buffer, unsigned int frames, unsigned int start_index) const;
 
       bool valid() const;
 
-      //get the data buffer
-      const data_buffer_t& raw_buffer() const;
+      //direct access to the samples, valid up to decoded_frames()
+      //frame i of channel c is at channel_data(c)[i * stride()]
+      //in the planar layout each channel starts on a cache line boundary and stride() is 1
+      //returns NULL with compact storage, use read_block to get float data
+      const float * channel_data(unsigned int channel) const;
+      unsigned int stride() const;
+
+      //copy frames of one channel starting at start_index into dest, without the gain
+      //zero pads past the end of the valid data, returns the number of valid frames copied
+      unsigned int read_block(unsigned int channel, unsigned int start_index, float * dest, unsigned int frames) const;
+
+      //get the data buffer, empty with compact storage or when the samples came from the cache
+      const sample_buffer_t& raw_buffer() const;
     private:
+      void allocate(unsigned int frames);
+      void store(const float * interleaved, unsigned int start_index, unsigned int frames);
+      void read_compact(unsigned int channel, unsigned int start_index, float * dest, unsigned int frames) const;
+      bool load_cache(const QString& cache_file);
+      void write_cache(const QString& cache_file) const;
+      //append the byte ranges of the mapping that hold frames [start, end)
+      void mapped_ranges(std::vector<MappedFile::range_t>& ranges, unsigned int start, unsigned int end) const;
+
       SoundFile mSoundFile;
-      data_buffer_t mAudioData;
+      sample_buffer_t mAudioData;
+      compact_buffer_t mCompactData;
+      //int16 scale factors, per channel per block
+      std::vector<float> mCompactScales;
+      //where the samples are read from, the vectors above or the cache mapping
+      const float * mSamples;
+      const uint16_t * mCompact;
+      const float * mScales;
+      QString mCacheDir;
+      qint64 mCacheMaxBytes;
+      MappedFile mCacheMap;
+      unsigned int mResidentFrames;
+      unsigned int mResidentFrame;
+      unsigned int mResidentLoopStart;
+      unsigned int mResidentLoopEnd;
+      bool mResident;
+      unsigned int mCompactBlocks;
+      layout_t mLayout;
+      sample_storage_t mStorage;
+      std::atomic<unsigned int> mFrames;
+      std::atomic<unsigned int> mDecodedFrames;
+      unsigned int mCapacity;
+      //distance between the start of each channel in mAudioData or mCompactData, for the planar layout
+      unsigned int mChannelOffset;
       unsigned int mSampleRate;
-      bool mLoaded;
-      bool mAbort;
+      std::atomic<bool> mLoaded;
+      std::atomic<bool> mAbort;
       unsigned int mNumChannels;
       float mMaxSample;
       bool mNormalize;
+      std::atomic<float> mGain;
   };
 
   typedef QExplicitlySharedDataPointer<AudioBuffer> AudioBufferPtr;
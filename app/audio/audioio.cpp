@@ -21,6 +21,7 @@
 #include <jack/transport.h>
 #include <cstring>
 #include "audioio.hpp"
+#include "config.hpp"
 
 using namespace djaudio;
 using JackCpp::MIDIPort;
@@ -53,12 +54,24 @@ void AudioIO::createClient(std::string name) {
   addOutPort("cue0");
   addOutPort("cue1");
   mMaster = Master::instance();
+  mMaster->scheduler()->frame_clock(AudioIO::frame_time, this);
+  jack_set_xrun_callback(client(), AudioIO::xrun, this);
   mMIDIIn.init(this, "midi_in");
 }
 
+unsigned int AudioIO::frame_time(void * audio_io) {
+  return jack_frame_time(static_cast<AudioIO *>(audio_io)->client());
+}
+
+int AudioIO::xrun(void * audio_io) {
+  static_cast<AudioIO *>(audio_io)->mMaster->profiler()->xrun();
+  return 0;
+}
+
 void AudioIO::run(bool doit){
   if (doit) {
-    mMaster->setup_audio(getSampleRate(), getBufferSize());
+    mMIDILatencyFrames = static_cast<uint32_t>(dj::Configuration::instance()->engine_midi_latency_ms() * static_cast<double>(getSampleRate()) / 1000.0);
+    mMaster->setup_audio(getSampleRate(), getBufferSize(), jack_client_real_time_priority(client()));
     JackCpp::AudioIO::start();
   } else {
     JackCpp::AudioIO::stop();
@@ -72,12 +85,15 @@ int AudioIO::audioCallback(jack_nframes_t nframes,
     audioBufVector outBufs){
 
   //compute the audio 
+  mMaster->scheduler()->period_start(jack_last_frame_time(client()), nframes);
   mMaster->audio_compute_and_fill(outBufs, nframes);
 
 
   //deal with midi
   void * midi_in_buffer = mMIDIIn.port_buffer(nframes);
   const uint32_t midi_in_cnt = mMIDIIn.event_count(midi_in_buffer);
+  //whole periods so the events keep their place in the period
+  const uint32_t midi_latency = ((mMIDILatencyFrames + nframes - 1) / nframes) * nframes;
 
   //push any note or cc events into the ring buffer
   for (uint32_t i = 0; i < midi_in_cnt; i++) {
@@ -91,6 +107,7 @@ int AudioIO::audioCallback(jack_nframes_t nframes,
           //if we have space, copy the event data and write it to our buffer
           if (mMIDIEventFromAudio.getWriteSpace()) {
             memcpy(buf.data, evt.buffer, 3);
+            buf.frame = jack_last_frame_time(client()) + evt.time + midi_latency;
             mMIDIEventFromAudio.write(buf);
           } else {
             //TODO report error
@@ -20,9 +20,14 @@ namespace djaudio {
       Master * master();
       void createClient(std::string name);
       void run(bool doit);
-      struct midi_event_buffer_t { uint8_t data[3]; };
+      //frame is the jack frame time the event came in at plus the midi latency, when its commands should run
+      struct midi_event_buffer_t { uint8_t data[3]; uint32_t frame; };
       typedef JackCpp::RingBuffer<midi_event_buffer_t> midi_ringbuff_t;
       midi_ringbuff_t * midi_input_ringbuffer();
+      //the jack frame clock, for stamping commands
+      static unsigned int frame_time(void * audio_io);
+      //jack's xrun notification, tells the profiler
+      static int xrun(void * audio_io);
     protected:
       virtual int audioCallback(
           jack_nframes_t nframes, 
@@ -32,6 +37,8 @@ namespace djaudio {
 
       JackCpp::MIDIInPort mMIDIIn;
       midi_ringbuff_t mMIDIEventFromAudio;
+      //added to midi stamps so they're still ahead of the audio thread once the router has queued the commands
+      uint32_t mMIDILatencyFrames = 0;
   };
 }
 
@@ -0,0 +1,70 @@
+#include "bufferarena.hpp"
+#include <sys/mman.h>
+#include <cstring>
+#include <new>
+
+using namespace djaudio;
+
+namespace {
+  const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+}
+
+BufferArena::BufferArena() : mData(NULL), mSize(0), mMapped(0), mUsed(0), mHugePages(false) { }
+
+BufferArena::~BufferArena() {
+  release();
+}
+
+void BufferArena::setup(std::size_t bytes) {
+  release();
+  if (bytes == 0)
+    return;
+
+  //huge pages have to be reserved by the admin, fall back to regular pages
+  void * data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  const std::size_t huge = ((bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+  data = mmap(NULL, huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (data != MAP_FAILED) {
+    mMapped = huge;
+    mHugePages = true;
+  }
+#endif
+  if (data == MAP_FAILED) {
+    data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+      throw std::bad_alloc();
+    mMapped = bytes;
+#ifdef MADV_HUGEPAGE
+    //transparent huge pages, if they're enabled
+    madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+  }
+
+  mData = static_cast<char *>(data);
+  mSize = bytes;
+  //it's fine if we can't lock it, jack usually locks all our memory anyway
+  mlock(mData, mMapped);
+  memset(mData, 0, mMapped);
+}
+
+void BufferArena::release() {
+  if (mData) {
+    munlock(mData, mMapped);
+    munmap(mData, mMapped);
+  }
+  mData = NULL;
+  mSize = mMapped = mUsed = 0;
+  mHugePages = false;
+}
+
+std::size_t BufferArena::size() const { return mSize; }
+bool BufferArena::huge_pages() const { return mHugePages; }
+
+void * BufferArena::take_bytes(std::size_t bytes) {
+  if (mUsed + bytes > mSize)
+    throw std::bad_alloc();
+  void * p = mData + mUsed;
+  mUsed += bytes;
+  return p;
+}
@@ -0,0 +1,44 @@
+#ifndef DATAJOCKEY_BUFFERARENA_HPP
+#define DATAJOCKEY_BUFFERARENA_HPP
+
+#include <cstddef>
+#include "alignedallocator.hpp"
+
+namespace djaudio {
+  //one contiguous block that the engine's per period buffers are carved out of, in the order they're taken,
+  //so the mix loop walks neighbouring memory, backed by huge pages when the system has them,
+  //locked and faulted in up front so the audio thread never takes a page fault on it
+  class BufferArena {
+    public:
+      BufferArena();
+      ~BufferArena();
+
+      //the space take<T>(count) uses, to size the arena with
+      template <typename T>
+        static std::size_t bytes_for(std::size_t count) { return aligned_count<char>(count * sizeof(T)); }
+
+      //throw away what was taken and make room for bytes, zeroed
+      void setup(std::size_t bytes);
+      void release();
+
+      //count zeroed Ts aligned to a cache line, throws std::bad_alloc if the arena is used up
+      template <typename T>
+        T * take(std::size_t count) { return static_cast<T *>(take_bytes(bytes_for<T>(count))); }
+
+      std::size_t size() const;
+      bool huge_pages() const;
+    private:
+      BufferArena(const BufferArena&);
+      BufferArena& operator=(const BufferArena&);
+
+      void * take_bytes(std::size_t bytes);
+
+      char * mData;
+      std::size_t mSize;
+      std::size_t mMapped;
+      std::size_t mUsed;
+      bool mHugePages;
+  };
+}
+
+#endif
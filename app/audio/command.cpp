@@ -1,14 +1,40 @@
 #include "command.hpp"
+#include "commandpool.hpp"
+#include <new>
 
 using namespace djaudio;
 
+Command::Command() : mFrameStamp(0), mFrameStamped(false) {
+}
+
 Command::~Command(){
 }
 
+void * Command::operator new(std::size_t size) {
+  CommandPool * pool = CommandPool::instance();
+  void * p = pool->allocate(size);
+  if (p)
+    return p;
+  pool->count_overflow();
+  return ::operator new(size);
+}
+
+void Command::operator delete(void * p) {
+  if (p && !CommandPool::instance()->release(p))
+    ::operator delete(p);
+}
+
 const TimePoint& Command::time_executed(){ return mTimeExecuted; }
 void Command::time_executed(TimePoint const & t){
    mTimeExecuted = t;
 }
 
+bool Command::frame_stamped() const { return mFrameStamped; }
+unsigned int Command::frame_stamp() const { return mFrameStamp; }
+void Command::frame_stamp(unsigned int frame_time) {
+  mFrameStamp = frame_time;
+  mFrameStamped = true;
+}
+
 void Command::execute_done(){
 }
@@ -3,14 +3,25 @@
 
 #include "timepoint.hpp"
 #include "types.hpp"
+#include <cstddef>
 
 namespace djaudio {
   class Transport;
   class Command {
     public:
       virtual ~Command();
+      //commands come out of the CommandPool so that creating and deleting them, from any thread,
+      //stays off the heap, the heap is only used if the pool runs out
+      static void * operator new(std::size_t size);
+      static void operator delete(void * p);
+      Command();
       const TimePoint& time_executed();
       void time_executed(TimePoint const & t);
+      //the audio frame clock when the command was handed to the scheduler, used to run it at the matching
+      //offset within a later period, commands without a stamp run as soon as possible
+      bool frame_stamped() const;
+      unsigned int frame_stamp() const;
+      void frame_stamp(unsigned int frame_time);
       virtual void execute(const Transport& transport) = 0;
       //this is executed back in the main thread
       //after the command has come back from the audio thread
@@ -26,6 +37,8 @@ namespace djaudio {
       virtual bool delete_after_done() { return true; }
     private:
       TimePoint mTimeExecuted;
+      unsigned int mFrameStamp;
+      bool mFrameStamped;
   };
 }
 
@@ -0,0 +1,85 @@
+#include "commandpool.hpp"
+#include "alignedallocator.hpp"
+#include <new>
+
+using namespace djaudio;
+
+namespace {
+  //block sizes and counts, a control change is one of the small ones
+  const std::size_t class_sizes[] = {64, 128, 256, 512};
+  const unsigned int class_blocks[] = {2048, 1024, 512, 128};
+}
+
+CommandPool * CommandPool::instance() {
+  //function local so that the first use from any thread sets it up safely
+  static CommandPool pool;
+  return &pool;
+}
+
+CommandPool::CommandPool() : mOverflows(0) {
+  for (unsigned int i = 0; i < SIZE_CLASSES; i++)
+    mClasses[i] = new SizeClass(class_sizes[i], class_blocks[i]);
+}
+
+void * CommandPool::allocate(std::size_t size) {
+  for (unsigned int i = 0; i < SIZE_CLASSES; i++) {
+    if (size <= mClasses[i]->block_size())
+      return mClasses[i]->pop();
+  }
+  return NULL;
+}
+
+bool CommandPool::release(void * p) {
+  for (unsigned int i = 0; i < SIZE_CLASSES; i++) {
+    if (mClasses[i]->owns(p)) {
+      mClasses[i]->push(p);
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned int CommandPool::overflows() const { return mOverflows.load(std::memory_order_relaxed); }
+void CommandPool::count_overflow() { mOverflows.fetch_add(1, std::memory_order_relaxed); }
+
+CommandPool::SizeClass::SizeClass(std::size_t block_size, unsigned int blocks) :
+  mMemory(NULL),
+  mBlockSize(block_size),
+  mBlocks(blocks),
+  mNext(new std::atomic<uint32_t>[blocks]),
+  mHead(blocks ? 1 : 0)
+{
+  mMemory = aligned_allocator<char>().allocate(block_size * blocks);
+  //every block starts out free, in order
+  for (unsigned int i = 0; i < blocks; i++)
+    mNext[i].store(i + 1 < blocks ? i + 2 : 0, std::memory_order_relaxed);
+}
+
+bool CommandPool::SizeClass::owns(const void * p) const {
+  const char * c = static_cast<const char *>(p);
+  return c >= mMemory && c < mMemory + mBlockSize * mBlocks;
+}
+
+void * CommandPool::SizeClass::pop() {
+  uint64_t head = mHead.load(std::memory_order_acquire);
+  for (;;) {
+    const uint32_t index = static_cast<uint32_t>(head);
+    if (index == 0)
+      return NULL;
+    //this may be stale if another thread popped it meanwhile, the tag makes the exchange fail then
+    const uint32_t next = mNext[index - 1].load(std::memory_order_relaxed);
+    const uint64_t desired = (((head >> 32) + 1) << 32) | next;
+    if (mHead.compare_exchange_weak(head, desired, std::memory_order_acq_rel, std::memory_order_acquire))
+      return mMemory + static_cast<std::size_t>(index - 1) * mBlockSize;
+  }
+}
+
+void CommandPool::SizeClass::push(void * p) {
+  const uint32_t index = static_cast<uint32_t>((static_cast<char *>(p) - mMemory) / mBlockSize) + 1;
+  uint64_t head = mHead.load(std::memory_order_relaxed);
+  uint64_t desired;
+  do {
+    mNext[index - 1].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    desired = (((head >> 32) + 1) << 32) | index;
+  } while (!mHead.compare_exchange_weak(head, desired, std::memory_order_release, std::memory_order_relaxed));
+}
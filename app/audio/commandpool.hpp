@@ -0,0 +1,51 @@
+#ifndef DATAJOCKEY_COMMANDPOOL_HPP
+#define DATAJOCKEY_COMMANDPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+namespace djaudio {
+  //preallocated blocks for commands, a few size classes each with a lock free free list,
+  //so any thread, the audio thread included, can create and delete commands without the heap
+  class CommandPool {
+    public:
+      static CommandPool * instance();
+
+      //a block of at least size bytes, NULL if size is too large or that size class is used up
+      void * allocate(std::size_t size);
+      //returns false if p didn't come from the pool
+      bool release(void * p);
+
+      //the number of allocations that didn't fit in the pool
+      unsigned int overflows() const;
+      void count_overflow();
+    private:
+      CommandPool();
+      CommandPool(const CommandPool&);
+      CommandPool& operator=(const CommandPool&);
+
+      class SizeClass {
+        public:
+          SizeClass(std::size_t block_size, unsigned int blocks);
+          std::size_t block_size() const { return mBlockSize; }
+          bool owns(const void * p) const;
+          void * pop();
+          void push(void * p);
+        private:
+          char * mMemory;
+          std::size_t mBlockSize;
+          unsigned int mBlocks;
+          //the next free block after each block, as index + 1 so that 0 ends the list
+          std::atomic<uint32_t> * mNext;
+          //the list head in the low 32 bits, the high 32 bits count pushes to avoid ABA
+          std::atomic<uint64_t> mHead;
+      };
+
+      enum { SIZE_CLASSES = 4 };
+      SizeClass * mClasses[SIZE_CLASSES];
+      std::atomic<unsigned int> mOverflows;
+  };
+}
+
+#endif
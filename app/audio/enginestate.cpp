@@ -0,0 +1,74 @@
+#include "enginestate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace djaudio;
+
+namespace {
+  //held peaks fall by 1/e over this long
+  const double PEAK_FALL_SECONDS = 0.05;
+}
+
+EngineState::EngineState() :
+  mSequence(0),
+  mSampleRate(44100)
+{
+  mMaster.bpm = 0.0;
+  mMaster.peak = 0.0f;
+}
+
+void EngineState::setup(unsigned int sample_rate, unsigned int players) {
+  mSampleRate = sample_rate;
+  player_t initial;
+  initial.frame = 0;
+  initial.play_speed = 1.0;
+  initial.bpm = 0.0;
+  initial.beat_index = 0;
+  initial.pos_in_beat = 0.0;
+  initial.peak = 0.0f;
+  initial.playing = false;
+  initial.syncing = false;
+  initial.audible = false;
+  initial.looping = false;
+  initial.loop_start_frame = 0;
+  initial.loop_end_frame = 0;
+  initial.starved = 0;
+  initial.audio_buffer = nullptr;
+  mPlayers.assign(players, initial);
+}
+
+void EngineState::begin_write() {
+  //odd while writing
+  mSequence.store(mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void EngineState::end_write() {
+  mSequence.store(mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+float EngineState::peak_decay(unsigned int frames) const {
+  return static_cast<float>(exp(-static_cast<double>(frames) / (PEAK_FALL_SECONDS * static_cast<double>(mSampleRate))));
+}
+
+unsigned long EngineState::read(master_t& master, std::vector<player_t>& players) const {
+  players.resize(mPlayers.size());
+  for (;;) {
+    const unsigned long sequence = mSequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      //the audio thread is writing, it'll be done shortly
+      std::this_thread::yield();
+      continue;
+    }
+    master = mMaster;
+    std::copy(mPlayers.begin(), mPlayers.end(), players.begin());
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mSequence.load(std::memory_order_relaxed) == sequence)
+      return sequence / 2;
+  }
+}
+
+unsigned long EngineState::periods() const {
+  return mSequence.load(std::memory_order_acquire) / 2;
+}
@@ -0,0 +1,69 @@
+#ifndef DATAJOCKEY_ENGINESTATE_HPP
+#define DATAJOCKEY_ENGINESTATE_HPP
+
+#include "timepoint.hpp"
+#include <atomic>
+#include <vector>
+
+namespace djaudio {
+  class AudioBuffer;
+
+  //a snapshot of the players and master that the audio thread publishes every period,
+  //any number of other threads can read the latest one at their own rate.
+  //a seqlock: the audio thread never waits, a reader that overlapped a write copies again
+  class EngineState {
+    public:
+      struct player_t {
+        unsigned int frame;
+        double play_speed;
+        double bpm;
+        unsigned int beat_index;
+        double pos_in_beat;
+        //held and falling off over time rather than reset, so readers at any rate see the peaks
+        float peak;
+        bool playing;
+        bool syncing;
+        bool audible;
+        bool looping;
+        unsigned int loop_start_frame;
+        unsigned int loop_end_frame;
+        //periods the player ran out of decoded audio in, only counts up
+        unsigned int starved;
+        //the buffer that was playing, it may be released once the command that swaps it out is done
+        AudioBuffer * audio_buffer;
+      };
+
+      struct master_t {
+        double bpm;
+        TimePoint position;
+        float peak;
+      };
+
+      EngineState();
+
+      //not while the audio thread runs or anything reads
+      void setup(unsigned int sample_rate, unsigned int players);
+
+      //audio thread, write the state between begin and end
+      void begin_write();
+      master_t& master() { return mMaster; }
+      player_t& player(unsigned int index) { return mPlayers[index]; }
+      void end_write();
+      //what to scale held peaks by for a period of frames
+      float peak_decay(unsigned int frames) const;
+
+      //any other thread
+      //copy the latest state, players is resized to fit so reuse it to avoid allocating,
+      //returns the number of periods published up to this state
+      unsigned long read(master_t& master, std::vector<player_t>& players) const;
+      //the number of periods published so far
+      unsigned long periods() const;
+    private:
+      std::atomic<unsigned long> mSequence;
+      unsigned int mSampleRate;
+      master_t mMaster;
+      std::vector<player_t> mPlayers;
+  };
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "equalizer.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <cstring>
+
+#ifdef DJ_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace djaudio;
+
+namespace {
+  const float BOOST_DB = 6.0f;
+  //gain changes settle over about this long
+  const double SMOOTHING_SECONDS = 0.01;
+  const double BUTTERWORTH_Q = 0.7071067811865476;
+
+  enum filter_t { LOWPASS, HIGHPASS, ALLPASS, THROUGH };
+
+  //rbj cookbook biquads, a 2nd order butterworth squared is a 4th order linkwitz-riley
+  //and the lowpass and highpass of one sum to the allpass at the same frequency
+  void set_lanes(Equalizer::section_t& section, unsigned int first, filter_t filter, double frequency, unsigned int sample_rate) {
+    double b[3] = {1.0, 0.0, 0.0};
+    double a[3] = {1.0, 0.0, 0.0};
+    if (filter != THROUGH) {
+      const double w0 = 2.0 * M_PI * frequency / static_cast<double>(sample_rate);
+      const double cosw = cos(w0);
+      const double alpha = sin(w0) / (2.0 * BUTTERWORTH_Q);
+      a[0] = 1.0 + alpha;
+      a[1] = -2.0 * cosw;
+      a[2] = 1.0 - alpha;
+      switch (filter) {
+        case LOWPASS:
+          b[0] = b[2] = (1.0 - cosw) / 2.0;
+          b[1] = 1.0 - cosw;
+          break;
+        case HIGHPASS:
+          b[0] = b[2] = (1.0 + cosw) / 2.0;
+          b[1] = -(1.0 + cosw);
+          break;
+        default:
+          b[0] = 1.0 - alpha;
+          b[1] = -2.0 * cosw;
+          b[2] = 1.0 + alpha;
+          break;
+      }
+    }
+    for (unsigned int i = first; i < first + 2; i++) {
+      section.b0[i] = static_cast<float>(b[0] / a[0]);
+      section.b1[i] = static_cast<float>(b[1] / a[0]);
+      section.b2[i] = static_cast<float>(b[2] / a[0]);
+      section.a1[i] = static_cast<float>(a[1] / a[0]);
+      section.a2[i] = static_cast<float>(a[2] / a[0]);
+    }
+  }
+
+  float band_gain(double value) {
+    value = dj::clamp(value, -1.0, 1.0);
+    if (value >= 0.0)
+      return static_cast<float>(dj::db2amp(BOOST_DB * value));
+    //squared so the cut is gradual near unity and still reaches a full kill
+    const float g = static_cast<float>(1.0 + value);
+    return g * g;
+  }
+
+  //transposed direct form 2
+  inline void run_scalar(Equalizer::section_t& s, float * v) {
+    for (unsigned int j = 0; j < 4; j++) {
+      const float out = s.b0[j] * v[j] + s.z1[j];
+      s.z1[j] = s.b1[j] * v[j] - s.a1[j] * out + s.z2[j];
+      s.z2[j] = s.b2[j] * v[j] - s.a2[j] * out;
+      v[j] = out;
+    }
+  }
+
+  //gains: low, mid, high at the start of the block and their change per frame
+  void compute_scalar(Equalizer::section_t * split, Equalizer::section_t * join,
+      float * left, float * right, unsigned int frames, const float * gains, const float * steps) {
+    float low = gains[0], mid = gains[1], high = gains[2];
+    for (unsigned int i = 0; i < frames; i++) {
+      low += steps[0];
+      mid += steps[1];
+      high += steps[2];
+
+      float v[4] = {left[i], right[i], left[i], right[i]};
+      run_scalar(split[0], v);
+      run_scalar(split[1], v);
+
+      //the low and high bands share the allpass, the mid comes out of the high crossover's lowpass
+      //and the high is the allpass less the mid
+      float w[4] = {low * v[0] + high * v[2], low * v[1] + high * v[3], v[2], v[3]};
+      run_scalar(join[0], w);
+      run_scalar(join[1], w);
+
+      left[i] = w[0] + (mid - high) * w[2];
+      right[i] = w[1] + (mid - high) * w[3];
+    }
+  }
+
+#ifdef DJ_SIMD_X86
+  struct section_sse2_t {
+    __m128 b0, b1, b2, a1, a2, z1, z2;
+  };
+
+  DJ_TARGET_SSE2
+  inline section_sse2_t load_section(const Equalizer::section_t& s) {
+    section_sse2_t r;
+    r.b0 = _mm_loadu_ps(s.b0);
+    r.b1 = _mm_loadu_ps(s.b1);
+    r.b2 = _mm_loadu_ps(s.b2);
+    r.a1 = _mm_loadu_ps(s.a1);
+    r.a2 = _mm_loadu_ps(s.a2);
+    r.z1 = _mm_loadu_ps(s.z1);
+    r.z2 = _mm_loadu_ps(s.z2);
+    return r;
+  }
+
+  DJ_TARGET_SSE2
+  inline __m128 run_sse2(section_sse2_t& s, __m128 v) {
+    const __m128 out = _mm_add_ps(_mm_mul_ps(s.b0, v), s.z1);
+    s.z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(s.b1, v), _mm_mul_ps(s.a1, out)), s.z2);
+    s.z2 = _mm_sub_ps(_mm_mul_ps(s.b2, v), _mm_mul_ps(s.a2, out));
+    return out;
+  }
+
+  DJ_TARGET_SSE2
+  void compute_sse2(Equalizer::section_t * split, Equalizer::section_t * join,
+      float * left, float * right, unsigned int frames, const float * gains, const float * steps) {
+    //the filter state stays in registers for the block
+    section_sse2_t s[4] = {load_section(split[0]), load_section(split[1]), load_section(join[0]), load_section(join[1])};
+
+    //lanes: low, low, high, high for the bands into the allpass, 0, 0, mid - high, mid - high for the mid
+    __m128 band_gains = _mm_setr_ps(gains[0], gains[0], gains[2], gains[2]);
+    const __m128 band_steps = _mm_setr_ps(steps[0], steps[0], steps[2], steps[2]);
+    __m128 mid_gain = _mm_setr_ps(0.0f, 0.0f, gains[1] - gains[2], gains[1] - gains[2]);
+    const __m128 mid_step = _mm_setr_ps(0.0f, 0.0f, steps[1] - steps[2], steps[1] - steps[2]);
+
+    for (unsigned int i = 0; i < frames; i++) {
+      band_gains = _mm_add_ps(band_gains, band_steps);
+      mid_gain = _mm_add_ps(mid_gain, mid_step);
+
+      __m128 v = _mm_setr_ps(left[i], right[i], left[i], right[i]);
+      v = run_sse2(s[0], v);
+      v = run_sse2(s[1], v);
+
+      //low * low band + high * rest into lanes 0 and 1, the rest stays in 2 and 3
+      __m128 w = _mm_mul_ps(v, band_gains);
+      w = _mm_add_ps(w, _mm_movehl_ps(w, w));
+      w = _mm_shuffle_ps(w, v, _MM_SHUFFLE(3, 2, 1, 0));
+      w = run_sse2(s[2], w);
+      w = run_sse2(s[3], w);
+
+      __m128 m = _mm_mul_ps(w, mid_gain);
+      w = _mm_add_ps(w, _mm_movehl_ps(m, m));
+      left[i] = _mm_cvtss_f32(w);
+      right[i] = _mm_cvtss_f32(_mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+
+    Equalizer::section_t * sections[4] = {&split[0], &split[1], &join[0], &join[1]};
+    for (unsigned int i = 0; i < 4; i++) {
+      _mm_storeu_ps(sections[i]->z1, s[i].z1);
+      _mm_storeu_ps(sections[i]->z2, s[i].z2);
+    }
+  }
+#endif
+}
+
+Equalizer::Equalizer() :
+  mSmoothing(0.0f)
+{
+  for (unsigned int i = 0; i < 3; i++)
+    mGain[i] = mTarget[i] = 1.0f;
+  setup(44100, 250.0f, 2500.0f);
+}
+
+void Equalizer::setup(unsigned int sample_rate, float low_crossover, float high_crossover) {
+  for (unsigned int i = 0; i < 2; i++) {
+    set_lanes(mSplit[i], 0, LOWPASS, low_crossover, sample_rate);
+    set_lanes(mSplit[i], 2, HIGHPASS, low_crossover, sample_rate);
+  }
+  //the allpass is one section of the two
+  set_lanes(mJoin[0], 0, ALLPASS, high_crossover, sample_rate);
+  set_lanes(mJoin[1], 0, THROUGH, high_crossover, sample_rate);
+  for (unsigned int i = 0; i < 2; i++)
+    set_lanes(mJoin[i], 2, LOWPASS, high_crossover, sample_rate);
+
+  mSmoothing = static_cast<float>(exp(-1.0 / (SMOOTHING_SECONDS * static_cast<double>(sample_rate))));
+  reset();
+}
+
+void Equalizer::band(dj::eq_band_t band, double value) {
+  mTarget[band] = band_gain(value);
+}
+
+void Equalizer::reset() {
+  section_t * sections[4] = {&mSplit[0], &mSplit[1], &mJoin[0], &mJoin[1]};
+  for (section_t * s: sections) {
+    memset(s->z1, 0, sizeof(s->z1));
+    memset(s->z2, 0, sizeof(s->z2));
+  }
+  for (unsigned int i = 0; i < 3; i++)
+    mGain[i] = mTarget[i];
+}
+
+void Equalizer::compute(unsigned int frames, float ** buffer) {
+  if (frames == 0)
+    return;
+
+  //the gains follow their targets a block at a time, ramping across each block
+  const float remaining = powf(mSmoothing, static_cast<float>(frames));
+  float gains[3];
+  float steps[3];
+  for (unsigned int i = 0; i < 3; i++) {
+    float end = mTarget[i] + (mGain[i] - mTarget[i]) * remaining;
+    if (fabsf(end - mTarget[i]) < 1e-5f)
+      end = mTarget[i];
+    gains[i] = mGain[i];
+    steps[i] = (end - mGain[i]) / static_cast<float>(frames);
+    mGain[i] = end;
+  }
+
+#ifdef DJ_SIMD_X86
+  if (simd::sse2())
+    return compute_sse2(mSplit, mJoin, buffer[0], buffer[1], frames, gains, steps);
+#endif
+  compute_scalar(mSplit, mJoin, buffer[0], buffer[1], frames, gains, steps);
+}
@@ -0,0 +1,48 @@
+#ifndef DATAJOCKEY_EQUALIZER_HPP
+#define DATAJOCKEY_EQUALIZER_HPP
+
+#include "defines.hpp"
+
+namespace djaudio {
+  //a three band dj isolator, linkwitz-riley crossovers split the audio into bands that sum back flat,
+  //each band's gain goes from a kill at -1 through unity at 0 to a boost at 1
+  class Equalizer {
+    public:
+      //four biquads side by side, a lane each, so both channels of two filters run in one vector
+      struct section_t {
+        float b0[4];
+        float b1[4];
+        float b2[4];
+        float a1[4];
+        float a2[4];
+        float z1[4];
+        float z2[4];
+      };
+
+      Equalizer();
+
+      //not in the audio thread
+      //the crossovers are the frequencies between the low and mid, and mid and high bands
+      void setup(unsigned int sample_rate, float low_crossover, float high_crossover);
+
+      //audio thread
+      //-1..1, the gain moves there over the next blocks
+      void band(dj::eq_band_t band, double value);
+      //clear the filters' history
+      void reset();
+      //filter a stereo buffer in place
+      void compute(unsigned int frames, float ** buffer);
+    private:
+      //low crossover, lanes: low left, low right, rest left, rest right
+      section_t mSplit[2];
+      //high crossover, lanes: allpassed low and high left and right, mid left and right
+      section_t mJoin[2];
+
+      float mGain[3];
+      float mTarget[3];
+      //the fraction of the distance to the target gain left per frame
+      float mSmoothing;
+  };
+}
+
+#endif
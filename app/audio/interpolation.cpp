@@ -0,0 +1,521 @@
+#include "interpolation.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <algorithm>
+
+#ifdef DJ_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace djaudio;
+
+#define SINC_TAPS 16
+#define SINC_TAPS_BEFORE 7
+#define SINC_PHASES 256
+#define SINC_CUTOFF 0.92
+
+namespace {
+  //the largest float below 1
+  const float FRAC_MAX = 0.99999994f;
+
+  //kernels compute output frames [begin, end), frame i is at index + (index_subsample + i * step)
+  //the caller guarantees that every tap they read is inside the source
+  typedef void (*kernel_t)(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step);
+
+  //the windowed sinc coefficients, row p holds the taps for a subsample of p / SINC_PHASES
+  //there is an extra row so we can interpolate between rows without wrapping
+  struct SincTable {
+#ifdef DJ_SIMD_X86
+    __attribute__((aligned(32)))
+#endif
+    float taps[(SINC_PHASES + 1) * SINC_TAPS];
+
+    SincTable() {
+      const double pi = 4.0 * atan(1.0);
+      for (unsigned int p = 0; p <= SINC_PHASES; p++) {
+        const double frac = static_cast<double>(p) / SINC_PHASES;
+        float * row = taps + p * SINC_TAPS;
+        double sum = 0.0;
+        for (int t = 0; t < SINC_TAPS; t++) {
+          //distance from the tap to the position we're computing
+          const double x = static_cast<double>(t - SINC_TAPS_BEFORE) - frac;
+          const double sinc = (x == 0.0) ? 1.0 : sin(pi * SINC_CUTOFF * x) / (pi * SINC_CUTOFF * x);
+          //blackman window over [-taps/2, taps/2]
+          const double w = (x + SINC_TAPS / 2) / SINC_TAPS;
+          const double window = 0.42 - 0.5 * cos(2.0 * pi * w) + 0.08 * cos(4.0 * pi * w);
+          row[t] = static_cast<float>(sinc * window);
+          sum += row[t];
+        }
+        //unity gain at dc
+        for (int t = 0; t < SINC_TAPS; t++)
+          row[t] = static_cast<float>(row[t] / sum);
+      }
+    }
+  };
+
+  const SincTable sinc_table;
+
+  inline unsigned int taps_before(interpolation_t mode) {
+    switch (mode) {
+      case INTERPOLATE_CUBIC: return 1;
+      case INTERPOLATE_SINC: return SINC_TAPS_BEFORE;
+      default: return 0;
+    }
+  }
+
+  inline unsigned int taps_after(interpolation_t mode) {
+    switch (mode) {
+      case INTERPOLATE_CUBIC: return 2;
+      case INTERPOLATE_SINC: return SINC_TAPS - SINC_TAPS_BEFORE - 1;
+      default: return 1;
+    }
+  }
+
+  inline void position(unsigned int i, unsigned int index, double index_subsample, double step, unsigned int& frame, float& frac) {
+    const double pos = index_subsample + static_cast<double>(i) * step;
+    const double whole = floor(pos);
+    frame = index + static_cast<unsigned int>(whole);
+    //just below 1 rounds up to 1 as a float, keep it below so the sinc row stays in the table
+    frac = std::min(static_cast<float>(pos - whole), FRAC_MAX);
+  }
+
+  inline float hermite(float ym1, float y0, float y1, float y2, float x) {
+    const float c1 = 0.5f * (y1 - ym1);
+    const float c2 = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+    const float c3 = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+    return ((c3 * x + c2) * x + c1) * x + y0;
+  }
+
+  inline const float * sinc_taps(float frac, float& phase_frac) {
+    const float row = frac * SINC_PHASES;
+    const unsigned int p = static_cast<unsigned int>(row);
+    //row p + 1 is read too, the last row is for a subsample of 1
+    if (p >= SINC_PHASES) {
+      phase_frac = 1.0f;
+      return sinc_table.taps + (SINC_PHASES - 1) * SINC_TAPS;
+    }
+    phase_frac = row - static_cast<float>(p);
+    return sinc_table.taps + p * SINC_TAPS;
+  }
+
+  //reads with bounds checking, for the edges of the source
+  inline float fetch(const float * data, const SampleSource& src, long frame) {
+    if (frame < 0 || frame >= static_cast<long>(src.frames))
+      return 0.0f;
+    return data[frame * src.stride];
+  }
+
+  void compute_checked(interpolation_t mode, const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac;
+      position(i, index, index_subsample, step, frame, frac);
+      const long f = static_cast<long>(frame);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c];
+        switch (mode) {
+          case INTERPOLATE_LINEAR:
+            {
+              const float y0 = fetch(d, src, f);
+              out[c][i] = y0 + (fetch(d, src, f + 1) - y0) * frac;
+            }
+            break;
+          case INTERPOLATE_CUBIC:
+            out[c][i] = hermite(fetch(d, src, f - 1), fetch(d, src, f), fetch(d, src, f + 1), fetch(d, src, f + 2), frac);
+            break;
+          case INTERPOLATE_SINC:
+            {
+              float pf;
+              const float * w = sinc_taps(frac, pf);
+              float v = 0.0f;
+              for (int t = 0; t < SINC_TAPS; t++)
+                v += fetch(d, src, f + t - SINC_TAPS_BEFORE) * (w[t] + (w[t + SINC_TAPS] - w[t]) * pf);
+              out[c][i] = v;
+            }
+            break;
+        }
+      }
+    }
+  }
+
+  void linear_scalar(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac;
+      position(i, index, index_subsample, step, frame, frac);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c] + frame * stride;
+        out[c][i] = d[0] + (d[stride] - d[0]) * frac;
+      }
+    }
+  }
+
+  void cubic_scalar(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac;
+      position(i, index, index_subsample, step, frame, frac);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c] + frame * stride;
+        out[c][i] = hermite(d[-static_cast<long>(stride)], d[0], d[stride], d[2 * stride], frac);
+      }
+    }
+  }
+
+  void sinc_scalar(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac, pf;
+      position(i, index, index_subsample, step, frame, frac);
+      const float * w = sinc_taps(frac, pf);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c] + (frame - SINC_TAPS_BEFORE) * stride;
+        float v = 0.0f;
+        for (int t = 0; t < SINC_TAPS; t++)
+          v += d[t * stride] * (w[t] + (w[t + SINC_TAPS] - w[t]) * pf);
+        out[c][i] = v;
+      }
+    }
+  }
+
+#ifdef DJ_SIMD_X86
+  //the sse2 versions compute 4 output frames at a time for linear and cubic,
+  //the sinc computes 4 taps at a time
+  DJ_TARGET_SSE2
+  void linear_sse2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+      unsigned int o[4];
+      float frac[4];
+      for (unsigned int k = 0; k < 4; k++) {
+        position(i + k, index, index_subsample, step, o[k], frac[k]);
+        o[k] *= stride;
+      }
+      const __m128 x = _mm_loadu_ps(frac);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c];
+        const __m128 y0 = _mm_set_ps(d[o[3]], d[o[2]], d[o[1]], d[o[0]]);
+        const __m128 y1 = _mm_set_ps(d[o[3] + stride], d[o[2] + stride], d[o[1] + stride], d[o[0] + stride]);
+        _mm_storeu_ps(out[c] + i, _mm_add_ps(y0, _mm_mul_ps(_mm_sub_ps(y1, y0), x)));
+      }
+    }
+    linear_scalar(src, out, i, end, index, index_subsample, step);
+  }
+
+  DJ_TARGET_SSE2
+  inline __m128 hermite_sse2(__m128 ym1, __m128 y0, __m128 y1, __m128 y2, __m128 x) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(y1, ym1));
+    const __m128 c2 = _mm_sub_ps(
+        _mm_add_ps(ym1, _mm_add_ps(y1, y1)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.5f), y0), _mm_mul_ps(half, y2)));
+    const __m128 c3 = _mm_add_ps(
+        _mm_mul_ps(half, _mm_sub_ps(y2, ym1)),
+        _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(y0, y1)));
+    __m128 v = _mm_add_ps(_mm_mul_ps(c3, x), c2);
+    v = _mm_add_ps(_mm_mul_ps(v, x), c1);
+    return _mm_add_ps(_mm_mul_ps(v, x), y0);
+  }
+
+  DJ_TARGET_SSE2
+  void cubic_sse2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+      unsigned int o[4];
+      float frac[4];
+      for (unsigned int k = 0; k < 4; k++) {
+        position(i + k, index, index_subsample, step, o[k], frac[k]);
+        o[k] = (o[k] - 1) * stride;
+      }
+      const __m128 x = _mm_loadu_ps(frac);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c];
+        __m128 y[4];
+        for (unsigned int t = 0; t < 4; t++) {
+          const unsigned int s = t * stride;
+          y[t] = _mm_set_ps(d[o[3] + s], d[o[2] + s], d[o[1] + s], d[o[0] + s]);
+        }
+        _mm_storeu_ps(out[c] + i, hermite_sse2(y[0], y[1], y[2], y[3], x));
+      }
+    }
+    cubic_scalar(src, out, i, end, index, index_subsample, step);
+  }
+
+  DJ_TARGET_SSE2
+  inline float hsum_sse2(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+  }
+
+  DJ_TARGET_SSE2
+  void sinc_sse2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    //the taps are contiguous if the data is planar, if it is interleaved stereo we split the channels with shuffles
+    const bool interleaved = src.stride == 2 && src.channel[1] == src.channel[0] + 1;
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac, pf;
+      position(i, index, index_subsample, step, frame, frac);
+      const float * w = sinc_taps(frac, pf);
+      const __m128 vpf = _mm_set1_ps(pf);
+      const unsigned int first = (frame - SINC_TAPS_BEFORE) * src.stride;
+      const float * l = src.channel[0] + first;
+      const float * r = src.channel[1] + first;
+
+      __m128 suml = _mm_setzero_ps();
+      __m128 sumr = _mm_setzero_ps();
+      for (unsigned int t = 0; t < SINC_TAPS; t += 4) {
+        const __m128 w0 = _mm_load_ps(w + t);
+        const __m128 w1 = _mm_load_ps(w + t + SINC_TAPS);
+        const __m128 wt = _mm_add_ps(w0, _mm_mul_ps(_mm_sub_ps(w1, w0), vpf));
+        __m128 vl, vr;
+        if (interleaved) {
+          const __m128 a = _mm_loadu_ps(l + 2 * t);
+          const __m128 b = _mm_loadu_ps(l + 2 * t + 4);
+          vl = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+          vr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        } else {
+          vl = _mm_loadu_ps(l + t);
+          vr = _mm_loadu_ps(r + t);
+        }
+        suml = _mm_add_ps(suml, _mm_mul_ps(vl, wt));
+        sumr = _mm_add_ps(sumr, _mm_mul_ps(vr, wt));
+      }
+      out[0][i] = hsum_sse2(suml);
+      out[1][i] = hsum_sse2(sumr);
+    }
+  }
+
+  //the avx2 versions compute 8 output frames at a time for linear and cubic using gathers,
+  //the sinc computes 8 taps at a time
+  DJ_TARGET_AVX2
+  inline __m256i offsets_avx2(unsigned int i, unsigned int index, double index_subsample, double step,
+      unsigned int stride, int tap_offset, __m256& x) {
+    int o[8];
+    float frac[8];
+    for (unsigned int k = 0; k < 8; k++) {
+      unsigned int frame;
+      position(i + k, index, index_subsample, step, frame, frac[k]);
+      o[k] = (static_cast<int>(frame) + tap_offset) * static_cast<int>(stride);
+    }
+    x = _mm256_loadu_ps(frac);
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(o));
+  }
+
+  DJ_TARGET_AVX2
+  void linear_avx2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    const __m256i vstride = _mm256_set1_epi32(static_cast<int>(stride));
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+      __m256 x;
+      const __m256i o0 = offsets_avx2(i, index, index_subsample, step, stride, 0, x);
+      const __m256i o1 = _mm256_add_epi32(o0, vstride);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c];
+        const __m256 y0 = _mm256_i32gather_ps(d, o0, 4);
+        const __m256 y1 = _mm256_i32gather_ps(d, o1, 4);
+        _mm256_storeu_ps(out[c] + i, _mm256_fmadd_ps(_mm256_sub_ps(y1, y0), x, y0));
+      }
+    }
+    linear_scalar(src, out, i, end, index, index_subsample, step);
+  }
+
+  DJ_TARGET_AVX2
+  void cubic_avx2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const unsigned int stride = src.stride;
+    const __m256i vstride = _mm256_set1_epi32(static_cast<int>(stride));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 onehalf = _mm256_set1_ps(1.5f);
+    const __m256 twohalf = _mm256_set1_ps(2.5f);
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+      __m256 x;
+      const __m256i om1 = offsets_avx2(i, index, index_subsample, step, stride, -1, x);
+      const __m256i o0 = _mm256_add_epi32(om1, vstride);
+      const __m256i o1 = _mm256_add_epi32(o0, vstride);
+      const __m256i o2 = _mm256_add_epi32(o1, vstride);
+      for (unsigned int c = 0; c < 2; c++) {
+        const float * d = src.channel[c];
+        const __m256 ym1 = _mm256_i32gather_ps(d, om1, 4);
+        const __m256 y0 = _mm256_i32gather_ps(d, o0, 4);
+        const __m256 y1 = _mm256_i32gather_ps(d, o1, 4);
+        const __m256 y2 = _mm256_i32gather_ps(d, o2, 4);
+
+        const __m256 c1 = _mm256_mul_ps(half, _mm256_sub_ps(y1, ym1));
+        const __m256 c2 = _mm256_sub_ps(
+            _mm256_add_ps(ym1, _mm256_add_ps(y1, y1)),
+            _mm256_fmadd_ps(twohalf, y0, _mm256_mul_ps(half, y2)));
+        const __m256 c3 = _mm256_fmadd_ps(half, _mm256_sub_ps(y2, ym1), _mm256_mul_ps(onehalf, _mm256_sub_ps(y0, y1)));
+        __m256 v = _mm256_fmadd_ps(c3, x, c2);
+        v = _mm256_fmadd_ps(v, x, c1);
+        _mm256_storeu_ps(out[c] + i, _mm256_fmadd_ps(v, x, y0));
+      }
+    }
+    cubic_scalar(src, out, i, end, index, index_subsample, step);
+  }
+
+  DJ_TARGET_AVX2
+  inline float hsum_avx2(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 shuf = _mm_movehdup_ps(s);
+    __m128 sums = _mm_add_ps(s, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+  }
+
+  DJ_TARGET_AVX2
+  void sinc_avx2(const SampleSource& src, float ** out, unsigned int begin, unsigned int end,
+      unsigned int index, double index_subsample, double step) {
+    const bool interleaved = src.stride == 2 && src.channel[1] == src.channel[0] + 1;
+    for (unsigned int i = begin; i < end; i++) {
+      unsigned int frame;
+      float frac, pf;
+      position(i, index, index_subsample, step, frame, frac);
+      const float * w = sinc_taps(frac, pf);
+      const __m256 vpf = _mm256_set1_ps(pf);
+      const unsigned int first = (frame - SINC_TAPS_BEFORE) * src.stride;
+      const float * l = src.channel[0] + first;
+      const float * r = src.channel[1] + first;
+
+      __m256 suml = _mm256_setzero_ps();
+      __m256 sumr = _mm256_setzero_ps();
+      for (unsigned int t = 0; t < SINC_TAPS; t += 8) {
+        const __m256 w0 = _mm256_load_ps(w + t);
+        const __m256 w1 = _mm256_load_ps(w + t + SINC_TAPS);
+        const __m256 wt = _mm256_fmadd_ps(_mm256_sub_ps(w1, w0), vpf, w0);
+        __m256 vl, vr;
+        if (interleaved) {
+          const __m256 a = _mm256_loadu_ps(l + 2 * t);
+          const __m256 b = _mm256_loadu_ps(l + 2 * t + 8);
+          //shuffle_ps works within 128 bit lanes, so the result is ordered 0 1 4 5 2 3 6 7, fix that up
+          vl = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+          vr = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+        } else {
+          vl = _mm256_loadu_ps(l + t);
+          vr = _mm256_loadu_ps(r + t);
+        }
+        suml = _mm256_fmadd_ps(vl, wt, suml);
+        sumr = _mm256_fmadd_ps(vr, wt, sumr);
+      }
+      out[0][i] = hsum_avx2(suml);
+      out[1][i] = hsum_avx2(sumr);
+    }
+  }
+#endif
+
+  struct Kernels {
+    kernel_t kernel[3];
+
+    Kernels() {
+      kernel[INTERPOLATE_LINEAR] = linear_scalar;
+      kernel[INTERPOLATE_CUBIC] = cubic_scalar;
+      kernel[INTERPOLATE_SINC] = sinc_scalar;
+#ifdef DJ_SIMD_X86
+      if (simd::avx2()) {
+        kernel[INTERPOLATE_LINEAR] = linear_avx2;
+        kernel[INTERPOLATE_CUBIC] = cubic_avx2;
+        kernel[INTERPOLATE_SINC] = sinc_avx2;
+      } else if (simd::sse2()) {
+        kernel[INTERPOLATE_LINEAR] = linear_sse2;
+        kernel[INTERPOLATE_CUBIC] = cubic_sse2;
+        kernel[INTERPOLATE_SINC] = sinc_sse2;
+      }
+#endif
+    }
+  };
+
+  const Kernels& kernels() {
+    static const Kernels k;
+    return k;
+  }
+
+  //the frame index that output frame i reads from
+  inline unsigned int frame_at(unsigned int i, unsigned int index, double index_subsample, double step) {
+    unsigned int frame;
+    float frac;
+    position(i, index, index_subsample, step, frame, frac);
+    return frame;
+  }
+}
+
+namespace djaudio {
+  void interpolate_block(interpolation_t mode, const SampleSource& source, float ** out, unsigned int frames,
+      unsigned int index, double index_subsample, double step) {
+    if (frames == 0)
+      return;
+
+    const unsigned int before = taps_before(mode);
+    const unsigned int after = taps_after(mode);
+
+    //we can only skip the bounds checks for frames whose taps are all inside the source
+    //positions only grow with a positive step, so the unchecked frames are at the front and the back
+    if (step <= 0.0 || source.frames <= before + after) {
+      compute_checked(mode, source, out, 0, frames, index, index_subsample, step);
+      return;
+    }
+    const unsigned int last_safe = source.frames - after - 1;
+
+    unsigned int begin = 0;
+    if (index < before) {
+      const double count = ceil((static_cast<double>(before - index) - index_subsample) / step);
+      begin = count <= 0.0 ? 0 : (count >= frames ? frames : static_cast<unsigned int>(count));
+      //make sure we agree with the kernel's rounding
+      while (begin < frames && frame_at(begin, index, index_subsample, step) < before)
+        begin++;
+      while (begin > 0 && frame_at(begin - 1, index, index_subsample, step) >= before)
+        begin--;
+    }
+
+    unsigned int end = begin;
+    if (index <= last_safe) {
+      const double count = ceil((static_cast<double>(last_safe + 1 - index) - index_subsample) / step);
+      end = count <= 0.0 ? 0 : (count >= frames ? frames : static_cast<unsigned int>(count));
+      while (end < frames && frame_at(end, index, index_subsample, step) <= last_safe)
+        end++;
+      while (end > 0 && frame_at(end - 1, index, index_subsample, step) > last_safe)
+        end--;
+      if (end < begin)
+        end = begin;
+    }
+
+    compute_checked(mode, source, out, 0, begin, index, index_subsample, step);
+    if (end > begin) {
+      kernel_t kernel = kernels().kernel[mode];
+      //the vector sinc only deals with planar and interleaved stereo layouts
+      if (mode == INTERPOLATE_SINC && !(source.stride == 1 || (source.stride == 2 && source.channel[1] == source.channel[0] + 1)))
+        kernel = sinc_scalar;
+      kernel(source, out, begin, end, index, index_subsample, step);
+    }
+    compute_checked(mode, source, out, end, frames, index, index_subsample, step);
+  }
+
+  unsigned int interpolation_taps_before(interpolation_t mode) { return taps_before(mode); }
+  unsigned int interpolation_taps_after(interpolation_t mode) { return taps_after(mode); }
+
+  interpolation_t interpolation_from_string(const QString& name, interpolation_t default_mode) {
+    if (name == "linear")
+      return INTERPOLATE_LINEAR;
+    if (name == "cubic")
+      return INTERPOLATE_CUBIC;
+    if (name == "sinc")
+      return INTERPOLATE_SINC;
+    return default_mode;
+  }
+}
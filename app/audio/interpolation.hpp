@@ -0,0 +1,37 @@
+#ifndef DATAJOCKEY_INTERPOLATION_HPP
+#define DATAJOCKEY_INTERPOLATION_HPP
+
+#include <QString>
+
+namespace djaudio {
+  enum interpolation_t {
+    INTERPOLATE_LINEAR,
+    INTERPOLATE_CUBIC, //4 point hermite
+    INTERPOLATE_SINC //16 point blackman windowed sinc
+  };
+
+  //a view of stereo sample data
+  //frame i of channel c is at channel[c][i * stride]
+  //mono data simply points both channels at the same data
+  struct SampleSource {
+    const float * channel[2];
+    unsigned int stride;
+    unsigned int frames;
+  };
+
+  //resample frames of stereo audio from source into out[0] and out[1]
+  //the first output frame is at index + index_subsample, each following frame is step further along
+  //reads outside of the source data are treated as zero
+  //the vector code used is picked at runtime based on the cpu
+  void interpolate_block(interpolation_t mode, const SampleSource& source, float ** out, unsigned int frames,
+      unsigned int index, double index_subsample, double step);
+
+  //the number of source frames read before and after the frame at or just before each output position
+  unsigned int interpolation_taps_before(interpolation_t mode);
+  unsigned int interpolation_taps_after(interpolation_t mode);
+
+  //parse a mode name, "linear", "cubic" or "sinc", returns the default for anything else
+  interpolation_t interpolation_from_string(const QString& name, interpolation_t default_mode = INTERPOLATE_CUBIC);
+}
+
+#endif
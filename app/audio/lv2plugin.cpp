@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
 
 using std::cerr;
 using std::endl;
@@ -15,6 +16,7 @@ namespace {
   LilvNode * lv2PortAudio = nullptr;
   LilvNode * lv2PortInput = nullptr;
   LilvNode * lv2PortOutput = nullptr;
+  LilvNode * lv2InPlaceBroken = nullptr;
 
   LilvWorld * cLV2World = nullptr;
   const LilvPlugins * cLV2Plugins = nullptr;
@@ -36,6 +38,7 @@ namespace {
     lv2PortControl = lilv_new_uri(cLV2World, LILV_URI_CONTROL_PORT);
     lv2PortInput = lilv_new_uri(cLV2World, LILV_URI_INPUT_PORT);
     lv2PortOutput = lilv_new_uri(cLV2World, LILV_URI_OUTPUT_PORT);
+    lv2InPlaceBroken = lilv_new_uri(cLV2World, LV2_CORE__inPlaceBroken);
     sym_map = symap_new();
     urid_sem_init();
   }
@@ -75,6 +78,8 @@ Lv2Plugin::Lv2Plugin(QString uri) throw (std::runtime_error)
   if (lilv_plugin_get_num_ports_of_class(mLilvPlugin, lv2PortAudio, lv2PortInput, nullptr) != 2)
     throw std::runtime_error("not a stereo input plugin: " + uri.toStdString());
 
+  mInPlace = !lilv_plugin_has_feature(mLilvPlugin, lv2InPlaceBroken);
+
   mNumPorts = lilv_plugin_get_num_ports(mLilvPlugin);
   mPortValueMin.resize(mNumPorts, 0.0f);
   mPortValueMax.resize(mNumPorts, 0.0f);
@@ -99,8 +104,13 @@ Lv2Plugin::~Lv2Plugin() {
 void Lv2Plugin::setup(unsigned int sample_rate, unsigned int max_buffer_length) {
   mLilvInstance = lilv_plugin_instantiate(mLilvPlugin, sample_rate, NULL);
 
-  mComputeBuffer[0].resize(max_buffer_length, 0.0f);
-  mComputeBuffer[1].resize(max_buffer_length, 0.0f);
+  if (!mInPlace) {
+    mComputeBuffer[0].resize(max_buffer_length, 0.0f);
+    mComputeBuffer[1].resize(max_buffer_length, 0.0f);
+  }
+  //a new instance has nothing connected
+  for (uint32_t i = 0; i < 2; i++)
+    mConnectedInputs[i] = mConnectedOutputs[i] = nullptr;
 
   for (uint32_t i = 0; i < mNumPorts; i++) {
     const LilvPort * port = lilv_plugin_get_port_by_index(mLilvPlugin, i);
@@ -186,17 +196,24 @@ void Lv2Plugin::load_preset_from_file(QString file_path) throw(std::runtime_erro
 }
 
 void Lv2Plugin::compute(unsigned int nframes, float ** mixBuffer) {
-  memset(&mComputeBuffer[0].front(), 0, sizeof(float) * nframes);
-  memset(&mComputeBuffer[1].front(), 0, sizeof(float) * nframes);
-
+  //the engine's buffers don't move between periods, so this is usually just a compare
   for (uint32_t i = 0; i < 2; i++) {
-    lilv_instance_connect_port(mLilvInstance, mAudioInputs[i], mixBuffer[i]);
-    lilv_instance_connect_port(mLilvInstance, mAudioOutputs[i], &mComputeBuffer[i].front());
+    float * output = mInPlace ? mixBuffer[i] : &mComputeBuffer[i].front();
+    if (mConnectedInputs[i] != mixBuffer[i]) {
+      lilv_instance_connect_port(mLilvInstance, mAudioInputs[i], mixBuffer[i]);
+      mConnectedInputs[i] = mixBuffer[i];
+    }
+    if (mConnectedOutputs[i] != output) {
+      lilv_instance_connect_port(mLilvInstance, mAudioOutputs[i], output);
+      mConnectedOutputs[i] = output;
+    }
   }
   lilv_instance_run(mLilvInstance, nframes);
 
-  memcpy(mixBuffer[0], &mComputeBuffer[0].front(), sizeof(float) * nframes);
-  memcpy(mixBuffer[1], &mComputeBuffer[1].front(), sizeof(float) * nframes);
+  if (!mInPlace) {
+    memcpy(mixBuffer[0], &mComputeBuffer[0].front(), sizeof(float) * nframes);
+    memcpy(mixBuffer[1], &mComputeBuffer[1].front(), sizeof(float) * nframes);
+  }
 }
 
 void Lv2Plugin::stop() {
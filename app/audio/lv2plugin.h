@@ -35,6 +35,11 @@ class Lv2Plugin : public AudioPlugin {
     std::vector<uint32_t> mAudioInputs;
     std::vector<uint32_t> mAudioOutputs;
 
+    //what the audio ports are connected to, we only reconnect when the buffers change
+    float * mConnectedInputs[2] = {nullptr, nullptr};
+    float * mConnectedOutputs[2] = {nullptr, nullptr};
+    //plugins that declare lv2:inPlaceBroken write their output into these and we copy it back
+    bool mInPlace = true;
     std::vector<float> mComputeBuffer[2];
 
     std::vector<float> mPortValueMin;
@@ -0,0 +1,112 @@
+#include "mappedfile.hpp"
+#include <QFile>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+using namespace djaudio;
+
+MappedFile::MappedFile() : mData(NULL), mSize(0) { }
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const QString& path, bool populate) {
+  close();
+
+  int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (populate)
+    flags |= MAP_POPULATE;
+#endif
+  void * data = mmap(NULL, static_cast<std::size_t>(info.st_size), PROT_READ, flags, fd, 0);
+  //the mapping keeps its own reference to the file
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+#ifndef MAP_POPULATE
+  //touch every page instead
+  if (populate) {
+    const long page = sysconf(_SC_PAGESIZE);
+    volatile const char * bytes = static_cast<const char *>(data);
+    for (off_t offset = 0; offset < info.st_size; offset += page)
+      (void)bytes[offset];
+  }
+#endif
+
+  mData = data;
+  mSize = static_cast<std::size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::close() {
+  unlock();
+  if (mData)
+    munmap(mData, mSize);
+  mData = NULL;
+  mSize = 0;
+}
+
+bool MappedFile::is_open() const { return mData != NULL; }
+const char * MappedFile::data() const { return static_cast<const char *>(mData); }
+std::size_t MappedFile::size() const { return mSize; }
+
+void MappedFile::will_need(const range_t& range) {
+  range_t pages = page_range(range);
+  if (pages.second)
+    madvise(static_cast<char *>(mData) + pages.first, pages.second, MADV_WILLNEED);
+}
+
+bool MappedFile::lock(const std::vector<range_t>& ranges) {
+  //locks don't nest, so unlock everything first, the pages stay resident in between
+  unlock();
+  bool ok = true;
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    range_t pages = page_range(ranges[i]);
+    if (!pages.second)
+      continue;
+    char * start = static_cast<char *>(mData) + pages.first;
+    madvise(start, pages.second, MADV_WILLNEED);
+    if (mlock(start, pages.second) == 0) {
+      mLocked.push_back(pages);
+    } else {
+      //at least read it in now, it may be evicted again under memory pressure
+      ok = false;
+      const long page = sysconf(_SC_PAGESIZE);
+      volatile const char * bytes = start;
+      for (std::size_t offset = 0; offset < pages.second; offset += page)
+        (void)bytes[offset];
+    }
+  }
+  return ok;
+}
+
+void MappedFile::unlock() {
+  for (std::size_t i = 0; i < mLocked.size(); i++)
+    munlock(static_cast<char *>(mData) + mLocked[i].first, mLocked[i].second);
+  mLocked.clear();
+}
+
+MappedFile::range_t MappedFile::page_range(const range_t& range) const {
+  if (!mData || range.first >= mSize)
+    return range_t(0, 0);
+  const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t start = (range.first / page) * page;
+  const std::size_t end = std::min(mSize, range.first + range.second);
+  return range_t(start, end - start);
+}
@@ -0,0 +1,47 @@
+#ifndef DATAJOCKEY_MAPPEDFILE_HPP
+#define DATAJOCKEY_MAPPEDFILE_HPP
+
+#include <QString>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+namespace djaudio {
+  //a read only memory mapping of a whole file
+  class MappedFile {
+    public:
+      MappedFile();
+      ~MappedFile();
+
+      //populate reads the whole file in and sets up the page tables now, from the calling thread,
+      //so that later reads, from the audio thread for instance, don't fault
+      bool open(const QString& path, bool populate = true);
+      void close();
+
+      bool is_open() const;
+      const char * data() const;
+      std::size_t size() const;
+
+      //byte offset and length within the mapping, rounded out to whole pages when used
+      typedef std::pair<std::size_t, std::size_t> range_t;
+
+      //a readahead hint, this doesn't block
+      void will_need(const range_t& range);
+      //lock these ranges into memory, unlocking whatever was locked before, this reads in what isn't resident
+      //so call it from a thread that can block, returns false if a lock fails, usually because of RLIMIT_MEMLOCK,
+      //the ranges are still read in that case
+      bool lock(const std::vector<range_t>& ranges);
+      void unlock();
+    private:
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+
+      range_t page_range(const range_t& range) const;
+
+      void * mData;
+      std::size_t mSize;
+      std::vector<range_t> mLocked;
+  };
+}
+
+#endif
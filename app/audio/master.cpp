@@ -1,11 +1,17 @@
 #include "master.hpp"
 #include "defines.hpp"
+#include "config.hpp"
+#include "mix.hpp"
 #include <math.h>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <iostream>
 
 using namespace djaudio;
 
 #define DEFAULT_NUM_PLAYERS 2
-#define DEFAULT_NUM_SENDS 2
+#define SCHEDULE_PERIOD 64u
 Master * Master::cInstance = NULL;
 
 Master * Master::instance(){
@@ -24,6 +30,7 @@ Master::Master(){
   mCueVolume = 1.0;
   mCueBuffer = NULL;
   mMasterVolumeBuffer = NULL;
+  mCueVolumeBuffer = NULL;
   mCrossFadeBuffer = NULL;
   mCrossFadePosition = 0.5;
   mCrossFade = false;
@@ -34,30 +41,8 @@ Master::Master(){
 
 Master::~Master(){
   cInstance = NULL;
-  //clean up!
-  if(mCueBuffer != NULL){
-    delete [] mCueBuffer[0];
-    delete [] mCueBuffer[1];
-    delete [] mCueBuffer;
-  }
-  for(unsigned int i = 0; i < mPlayerBuffers.size(); i++){
-    delete [] mPlayerBuffers[i][0];
-    delete [] mPlayerBuffers[i][1];
-    delete [] mPlayerBuffers[i];
-  }
-  for(unsigned int i = 0; i < mSendBuffers.size(); i++){
-    delete [] mSendBuffers[i][0];
-    delete [] mSendBuffers[i][1];
-    delete [] mSendBuffers[i];
-  }
-
-  if(mMasterVolumeBuffer)
-    delete [] mMasterVolumeBuffer;
-  if(mCrossFadeBuffer){
-    delete [] mCrossFadeBuffer[0];
-    delete [] mCrossFadeBuffer[1];
-    delete [] mCrossFadeBuffer;
-  }
+  mWorkers.stop();
+  //clean up! the buffers belong to the arena
   for(unsigned int i = 0; i < mPlayers.size(); i++){
     delete mPlayers[i];
   }
@@ -65,81 +50,83 @@ Master::~Master(){
 
 void Master::setup_audio(
     unsigned int sampleRate,
-    unsigned int maxBufferLen){
-  if(mCueBuffer != NULL){
-    delete [] mCueBuffer[0];
-    delete [] mCueBuffer[1];
-    delete [] mCueBuffer;
-  }
-  mCueBuffer = new float*[2];
-  mCueBuffer[0] = new float[maxBufferLen];
-  mCueBuffer[1] = new float[maxBufferLen];
-
-  if(mPlayerBuffers.size()) {
-    for(unsigned int i = 0; i < mPlayerBuffers.size(); i++){
-      delete [] mPlayerBuffers[i][0];
-      delete [] mPlayerBuffers[i][1];
-      delete [] mPlayerBuffers[i];
-    }
-    mPlayerBuffers.clear();
-  }
+    unsigned int maxBufferLen,
+    int realtimePriority){
+  const unsigned int sends = dj::Configuration::instance()->engine_sends();
+  const std::size_t buffer = BufferArena::bytes_for<float>(maxBufferLen);
+  const std::size_t stereo = BufferArena::bytes_for<float *>(2) + 2 * buffer;
+
+  //every buffer we use in a period comes from one arena, players first as they're the bulk of the mix loop
+  std::size_t bytes = mPlayers.size() * (stereo + Player::audio_buffer_bytes(maxBufferLen, sends));
+  bytes += sends * stereo; //sends
+  bytes += 2 * stereo; //cue and crossfade
+  bytes += 2 * buffer; //master and cue volume
+  mArena.setup(bytes);
+
+  auto take_stereo = [this, maxBufferLen]() {
+    float ** b = mArena.take<float *>(2);
+    b[0] = mArena.take<float>(maxBufferLen);
+    b[1] = mArena.take<float>(maxBufferLen);
+    return b;
+  };
 
-  if (mSendBuffers.size()) {
-    for(unsigned int i = 0; i < mSendBuffers.size(); i++){
-      delete [] mSendBuffers[i][0];
-      delete [] mSendBuffers[i][1];
-      delete [] mSendBuffers[i];
-    }
-    mSendBuffers.clear();
+  //set up the players and their buffers
+  mPlayerBuffers.clear();
+  for(unsigned int i = 0; i < mPlayers.size(); i++){
+    mPlayerBuffers.push_back(take_stereo());
+    mPlayers[i]->setup_audio(sampleRate, maxBufferLen, sends, mArena);
   }
 
-  mSendPlugins.resize(DEFAULT_NUM_SENDS);
-  for (unsigned int i = 0; i < DEFAULT_NUM_SENDS; i++) {
-    float ** sampleBuffer = new float*[2];
-    sampleBuffer[0] = new float[maxBufferLen];
-    sampleBuffer[1] = new float[maxBufferLen];
-    memset(sampleBuffer[0], 0, sizeof(float) * maxBufferLen);
-    memset(sampleBuffer[1], 0, sizeof(float) * maxBufferLen);
-    mSendBuffers.push_back(sampleBuffer);
+  mSendBuffers.clear();
+  mSendPlugins.resize(sends);
+  for (unsigned int i = 0; i < sends; i++) {
+    mSendBuffers.push_back(take_stereo());
     mSendPlugins[i].setup(sampleRate, maxBufferLen);
   }
 
-  //set up the players and their buffers
-  for(unsigned int i = 0; i < mPlayers.size(); i++){
-    float ** sampleBuffer = new float*[2];
-    sampleBuffer[0] = new float[maxBufferLen];
-    sampleBuffer[1] = new float[maxBufferLen];
-    memset(sampleBuffer[0], 0, sizeof(float) * maxBufferLen);
-    memset(sampleBuffer[1], 0, sizeof(float) * maxBufferLen);
-    mPlayers[i]->setup_audio(sampleRate, maxBufferLen, mSendBuffers.size());
-    mPlayerBuffers.push_back(sampleBuffer);
+  mCueBuffer = take_stereo();
+  mCrossFadeBuffer = take_stereo();
+  mMasterVolumeBuffer = mArena.take<float>(maxBufferLen);
+  mCueVolumeBuffer = mArena.take<float>(maxBufferLen);
+
+  //the gains ramp to new values, starting where they are now
+  const unsigned int smoothing = static_cast<double>(sampleRate) * GAIN_SMOOTHING_SECONDS;
+  mMasterVolumeSmoother.length(smoothing);
+  mMasterVolumeSmoother.jump(mMasterVolume);
+  mCueVolumeSmoother.length(smoothing);
+  mCueVolumeSmoother.jump(mCueVolume);
+  for (unsigned int i = 0; i < 2; i++) {
+    mCrossFadeSmoothers[i].length(smoothing);
+    mCrossFadeSmoothers[i].jump(1.0f);
   }
 
-  if(mMasterVolumeBuffer)
-    delete [] mMasterVolumeBuffer;
-  mMasterVolumeBuffer = new float[maxBufferLen];
-
-  if(mCrossFadeBuffer){
-    delete [] mCrossFadeBuffer[0];
-    delete [] mCrossFadeBuffer[1];
-    delete [] mCrossFadeBuffer;
-  }
-  mCrossFadeBuffer = new float*[2];
-  mCrossFadeBuffer[0] = new float[maxBufferLen];
-  mCrossFadeBuffer[1] = new float[maxBufferLen];
   mTransport.setup(sampleRate);
+  mProfiler.setup(sampleRate, mPlayers.size());
+  mState.setup(sampleRate, mPlayers.size());
+
+  //the audio thread renders one player itself, the workers take the rest, at most one per spare core
+  int threads = dj::Configuration::instance()->engine_worker_threads();
+  if (threads < 0) {
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::min(cores - 1, static_cast<int>(mPlayers.size()) - 1);
+  }
+  mWorkers.stop();
+  if (threads > 0) {
+    unsigned int started = mWorkers.start(threads, realtimePriority);
+    if (started < static_cast<unsigned int>(threads))
+      std::cerr << "rendering players with " << started << " of " << threads << " worker threads" << std::endl;
+  }
 
 #if 0
   //XXX tmp
   
   Lv2Plugin * sendPlugin = new Lv2Plugin(
       "http://calf.sourceforge.net/plugins/VintageDelay");
-  sendPlugin->setup(sampleRate, maxBufferLen);
-  sendPlugin->load_preset_from_file("/home/alex/lv2presets/delay_lv2.lv2/delay_lv2.ttl");
-
   AudioPluginPtr shared(sendPlugin);
-  AudioPluginNode * node = new AudioPluginNode(shared);
-  add_send_plugin(0, node);
+  //the command sets the plugin up
+  Command * add = new MasterAddPluginCommand(0, 0, shared);
+  sendPlugin->load_preset_from_file("/home/alex/lv2presets/delay_lv2.lv2/delay_lv2.ttl");
+  mScheduler.execute(add);
 
   mPlayers[0]->send_volume(0, 1.0);
 #endif
@@ -154,24 +141,37 @@ Player * Master::add_player(){
 void Master::audio_compute_and_fill(
     JackCpp::AudioIO::audioBufVector outBufferVector,
     unsigned int numFrames) {
+  mProfiler.begin_period(numFrames);
 
-  //clear out our sends
+  //clear out our sends and the cue bus, the players mix into them
   for (unsigned int i = 0; i < mSendBuffers.size(); i++) {
     memset(mSendBuffers[i][0], 0, sizeof(float) * numFrames);
     memset(mSendBuffers[i][1], 0, sizeof(float) * numFrames);
   }
+  memset(mCueBuffer[0], 0, sizeof(float) * numFrames);
+  memset(mCueBuffer[1], 0, sizeof(float) * numFrames);
 
   //execute the schedule
+  uint64_t start = Profiler::now();
   mScheduler.execute_schedule(mTransport);
+  uint64_t schedule_nanos = Profiler::now() - start;
 
   //set up players
   for(unsigned int p = 0; p < mPlayers.size(); p++)
     mPlayers[p]->audio_pre_compute(numFrames, mPlayerBuffers[p], mTransport);
 
+  //zero out the output buffers
+  for(unsigned int chan = 0; chan < 4; chan++)
+    memset(outBufferVector[chan], 0, sizeof(float) * numFrames);
+
   //compute their samples [and do other stuff]
-  for(unsigned int frame = 0; frame < numFrames; frame++){
+  //we compute in blocks, splitting at beats, schedule executions and the frames commands are due at
+  unsigned int frame = 0;
+  bool late_beat = false;
+  while (frame < numFrames) {
     //tick the transport
-    bool beat = mTransport.tick();
+    bool beat = mTransport.tick() || late_beat;
+    start = Profiler::now();
     if (beat) {
       for (unsigned int i = 0; i < mNextBeatCommandBufferIndex; i++) {
         Command * cmd = mNextBeatCommandBuffer[i];
@@ -180,49 +180,59 @@ void Master::audio_compute_and_fill(
       }
       mNextBeatCommandBufferIndex = 0;
     }
+    //execute the schedule and any commands due by this frame
     //XXX this should be a setting
-    //only execute every 64 samples, at 44.1khz this is every 1.45ms
-    if(frame % 64 == 0){
-      //execute the schedule
-      mScheduler.execute_schedule(mTransport);
-    }
-    for(unsigned int chan = 0; chan < 2; chan++){
-      //zero out the cue buffer
-      mCueBuffer[chan][frame] = 0.0;
-      //calculate the crossfade
-      if(mCrossFade){
-        if(mCrossFadePosition >= 1.0f){
-          mCrossFadeBuffer[0][frame] = 0.0;
-          mCrossFadeBuffer[1][frame] = 1.0;
-        } else if (mCrossFadePosition <= 0.0f){
-          mCrossFadeBuffer[0][frame] = 1.0;
-          mCrossFadeBuffer[1][frame] = 0.0;
-        } else {
-          mCrossFadeBuffer[0][frame] = (float)sin((M_PI / 2) * (1.0f + mCrossFadePosition));
-          mCrossFadeBuffer[1][frame] = (float)sin((M_PI / 2) * mCrossFadePosition);
-        }
+    //blocks are at most 64 samples, at 44.1khz this is every 1.45ms
+    mScheduler.execute_schedule(mTransport, frame);
+    schedule_nanos += Profiler::now() - start;
+
+    //the block runs until the next schedule execution, the next beat or the next command, whichever is first
+    unsigned int frames = std::min(numFrames - frame, SCHEDULE_PERIOD - frame % SCHEDULE_PERIOD);
+    frames = std::min(frames, mTransport.ticks_till_next_beat());
+    frames = std::min(frames, mScheduler.next_command_frame(frame) - frame);
+
+    //calculate the crossfade, this only changes with commands, the smoothers ramp to it
+    float xfade[2] = {1.0f, 1.0f};
+    if(mCrossFade){
+      if(mCrossFadePosition >= 1.0f){
+        xfade[0] = 0.0;
+        xfade[1] = 1.0;
+      } else if (mCrossFadePosition <= 0.0f){
+        xfade[0] = 1.0;
+        xfade[1] = 0.0;
       } else {
-        mCrossFadeBuffer[0][frame] = mCrossFadeBuffer[1][frame] = 1.0;
+        xfade[0] = (float)sin((M_PI / 2) * (1.0f + mCrossFadePosition));
+        xfade[1] = (float)sin((M_PI / 2) * mCrossFadePosition);
       }
     }
-    //zero out the output buffers
-    for(unsigned int chan = 0; chan < 4; chan++)
-      outBufferVector[chan][frame] = 0.0;
-    for(unsigned int p = 0; p < mPlayers.size(); p++)
-      mPlayers[p]->audio_compute_frame(frame, mPlayerBuffers[p], mTransport, beat);
+    for(unsigned int chan = 0; chan < 2; chan++) {
+      mCrossFadeSmoothers[chan].target(xfade[chan]);
+      mCrossFadeSmoothers[chan].fill(mCrossFadeBuffer[chan] + frame, frames);
+    }
+
+    mBlockOffset = frame;
+    mBlockFrames = frames;
+    mBlockBeat = beat;
+    mWorkers.run(&Master::compute_block_job, this, mPlayers.size());
     //set volume
-    mMasterVolumeBuffer[frame] = mMasterVolume;
+    mMasterVolumeSmoother.target(mMasterVolume);
+    mMasterVolumeSmoother.fill(mMasterVolumeBuffer + frame, frames);
+    mCueVolumeSmoother.target(mCueVolume);
+    mCueVolumeSmoother.fill(mCueVolumeBuffer + frame, frames);
+
+    //we've already ticked for the first frame of the block
+    //rounding could land us on a beat a tick early, if so report it with the next block
+    late_beat = mTransport.tick(frames - 1);
+    frame += frames;
   }
 
-  auto compute_player_audio = [this, &outBufferVector](unsigned int player, unsigned int chan, unsigned int frame, float xfade_mul) {
-    outBufferVector[chan][frame] += 
-      xfade_mul * mPlayerBuffers[player][chan][frame];
-    outBufferVector[chan + 2][frame] += mCueVolume * mCueBuffer[chan][frame];
-  };
+  mProfiler.record_nanos(Profiler::SCHEDULE, schedule_nanos);
 
-  //finalize each player, and copy its data out
+  //finalize each player in parallel, then copy its data out, the cue and send buffers are shared so that is serial
+  mBlockFrames = numFrames;
+  mWorkers.run(&Master::post_compute_job, this, mPlayers.size());
+  start = Profiler::now();
   for(unsigned int p = 0; p < mPlayers.size(); p++){
-    mPlayers[p]->audio_post_compute(numFrames, mPlayerBuffers[p]);
     mPlayers[p]->audio_fill_output_buffers(numFrames, mPlayerBuffers[p], mCueBuffer, mSendBuffers);
     int xfade_index = -1;
     if (p == mCrossFadeMixers[0]) {
@@ -230,31 +240,81 @@ void Master::audio_compute_and_fill(
     } else if (p == mCrossFadeMixers[1]) {
       xfade_index = 1;
     }
-    for(unsigned int frame = 0; frame < numFrames; frame++) {
-      for(unsigned int chan = 0; chan < 2; chan++) {
-        float xfade_mul = xfade_index < 0 ? 1.0f : mCrossFadeBuffer[xfade_index][frame];
-        compute_player_audio(p, chan, frame, xfade_mul);
-      }
+    for(unsigned int chan = 0; chan < 2; chan++) {
+      if (xfade_index < 0)
+        mix_add(outBufferVector[chan], mPlayerBuffers[p][chan], 1.0f, numFrames);
+      else
+        mix_add(outBufferVector[chan], mPlayerBuffers[p][chan], mCrossFadeBuffer[xfade_index], numFrames);
     }
   }
 
+  for(unsigned int chan = 0; chan < 2; chan++)
+    mix_add(outBufferVector[chan + 2], mCueBuffer[chan], mCueVolumeBuffer, numFrames);
+  uint64_t mix_nanos = Profiler::now() - start;
+
   //mix in the effects
+  start = Profiler::now();
   for (unsigned int i = 0; i < mSendPlugins.size(); i++) {
     float ** buf = mSendBuffers[i];
     mSendPlugins[i].compute(numFrames, buf);
-    for (unsigned int j = 0; j < numFrames; j++) {
-      outBufferVector[0][j] += buf[0][j];
-      outBufferVector[1][j] += buf[1][j];
-    }
+    mix_add(outBufferVector[0], buf[0], 1.0f, numFrames);
+    mix_add(outBufferVector[1], buf[1], 1.0f, numFrames);
   }
-
-  //XXX do a vector multiply?
-  for (unsigned int i = 0; i < numFrames; i++) {
-    outBufferVector[0][i] *= mMasterVolumeBuffer[i];
-    outBufferVector[1][i] *= mMasterVolumeBuffer[i];
-    mMaxSampleValue = std::max(mMaxSampleValue, fabsf(outBufferVector[0][i]));
-    mMaxSampleValue = std::max(mMaxSampleValue, fabsf(outBufferVector[1][i]));
+  mProfiler.record(Profiler::SENDS, start);
+
+  start = Profiler::now();
+  for(unsigned int chan = 0; chan < 2; chan++)
+    mMaxSampleValue = std::max(mMaxSampleValue, apply_gain_peak(outBufferVector[chan], mMasterVolumeBuffer, numFrames));
+  mProfiler.record_nanos(Profiler::MIX, mix_nanos + Profiler::now() - start);
+
+  publish_state(numFrames);
+  mProfiler.end_period();
+}
+
+void Master::compute_block_job(void * master, unsigned int index) {
+  Master * m = static_cast<Master *>(master);
+  const uint64_t start = Profiler::now();
+  m->mPlayers[index]->audio_compute_block(m->mBlockOffset, m->mBlockFrames, m->mPlayerBuffers[index], m->mTransport, m->mBlockBeat);
+  m->mProfiler.add_player(Profiler::RENDER, index, start);
+}
+
+void Master::post_compute_job(void * master, unsigned int index) {
+  Master * m = static_cast<Master *>(master);
+  const uint64_t start = Profiler::now();
+  m->mPlayers[index]->audio_post_compute(m->mBlockFrames, m->mPlayerBuffers[index]);
+  m->mProfiler.add_player(Profiler::EQ, index, start);
+}
+
+void Master::publish_state(unsigned int frames) {
+  const float decay = mState.peak_decay(frames);
+  mState.begin_write();
+
+  EngineState::master_t& master = mState.master();
+  master.bpm = mTransport.bpm();
+  master.position = mTransport.position();
+  master.peak = std::max(max_sample_value_reset(), master.peak * decay);
+
+  for (unsigned int i = 0; i < mPlayers.size(); i++) {
+    Player * p = mPlayers[i];
+    EngineState::player_t& state = mState.player(i);
+    state.frame = p->frame();
+    state.play_speed = p->play_speed();
+    state.bpm = p->bpm();
+    state.beat_index = p->beat_index();
+    state.pos_in_beat = p->pos_in_beat();
+    state.peak = std::max(p->max_sample_value_reset(), state.peak * decay);
+    state.playing = p->play_state() == Player::PLAY;
+    state.syncing = p->syncing();
+    state.audible = p->audible();
+    state.looping = p->looping();
+    state.loop_start_frame = p->loop_start_frame();
+    state.loop_end_frame = p->loop_end_frame();
+    if (p->starved_reset())
+      state.starved++;
+    state.audio_buffer = p->audio_buffer();
   }
+
+  mState.end_write();
 }
 
 bool Master::execute_next_beat(Command * cmd) {
@@ -304,12 +364,14 @@ void Master::sync_to_player(unsigned int player_index) {
 
 const std::vector<Player *>& Master::players() const { return mPlayers; }
 Scheduler * Master::scheduler(){ return &mScheduler; }
+Profiler * Master::profiler(){ return &mProfiler; }
+const EngineState * Master::state() const { return &mState; }
 Transport * Master::transport(){ return &mTransport; }
 
-void Master::add_send_plugin(unsigned int send, unsigned int location_index, AudioPluginNode * plugin_node) {
+AudioPluginCollection * Master::send_plugins(unsigned int send) {
   if (send >= mSendPlugins.size())
-    return; //XXX error
-  mSendPlugins[send].insert(location_index, plugin_node);
+    return NULL;
+  return &mSendPlugins[send];
 }
 
 float Master::max_sample_value() const { return mMaxSampleValue; }
@@ -461,16 +523,50 @@ bool MasterNextBeatCommand::store(CommandIOData& /* data */) const {
   return false;
 }
 
-MasterAddPluginCommand::MasterAddPluginCommand(unsigned int send, unsigned int location_index, AudioPluginNode * plugin_node) :
-  mSend(send), mLocationIndex(location_index), mPlugin(plugin_node)
+namespace {
+  //the chain is filled in the audio thread, so it has to have room for the plugins already there
+  const unsigned int SEND_PLUGINS_MAX = 64;
+}
+
+MasterAddPluginCommand::MasterAddPluginCommand(unsigned int send, unsigned int location_index, AudioPluginPtr plugin) :
+  mSend(send),
+  mIndex(location_index),
+  mPlugin(plugin),
+  mBaseVersion(0),
+  mAdded(false)
 {
+  AudioPluginCollection * plugins = master()->send_plugins(send);
+  if (!plugins || !plugin)
+    return; //XXX error
+  plugins->setup_plugin(plugin.data());
+  mBase = plugins->latest();
+  mBaseVersion = mBase->version();
+  mChain = AudioPluginChainPtr(new AudioPluginChain(SEND_PLUGINS_MAX));
+  if (mChain->insert(*mBase, mIndex, mPlugin))
+    plugins->latest(mChain);
+  else
+    mChain.clear();
 }
 
 MasterAddPluginCommand::~MasterAddPluginCommand() {
 }
 
 void MasterAddPluginCommand::execute(const Transport& /*transport*/) {
-  master()->add_send_plugin(mSend, mLocationIndex, mPlugin);
+  if (!mChain)
+    return;
+  AudioPluginCollection * plugins = master()->send_plugins(mSend);
+  //only if an add before this one was dropped, or was rebuilt because of one, rebuild on what is running,
+  //mBase and mPlugin hold on to everything in mChain so nothing is freed here
+  const AudioPluginChain& running = plugins->running();
+  if ((&running != mBase.data() || running.version() != mBaseVersion) && !mChain->insert(running, mIndex, mPlugin))
+    return;
+  plugins->swap(mChain);
+  mAdded = true;
+}
+
+void MasterAddPluginCommand::execute_done() {
+  if (!mAdded)
+    std::cerr << "could not add the plugin to send " << mSend << std::endl;
 }
 
 bool MasterAddPluginCommand::store(CommandIOData& /* data */) const {
@@ -6,6 +6,11 @@
 #include "transport.hpp"
 #include "scheduler.hpp"
 #include "types.hpp"
+#include "workerpool.hpp"
+#include "bufferarena.hpp"
+#include "smoother.hpp"
+#include "profiler.hpp"
+#include "enginestate.hpp"
 #include <vector>
 #include <array>
 
@@ -23,9 +28,11 @@ namespace djaudio {
       //this creates internal buffers
       //** must be called BEFORE the audio callback starts 
       //but after all the players are added
+      //realtimePriority is the audio thread's, the worker threads that render players run at it
       void setup_audio(
           unsigned int sampleRate,
-          unsigned int maxBufferLen);
+          unsigned int maxBufferLen,
+          int realtimePriority = -1);
       //cannot be called while audio callback is running
       Player * add_player();
       //actually compute nframes of audio
@@ -44,12 +51,15 @@ namespace djaudio {
       unsigned int cross_fade_mixer(unsigned int index) const;
       const std::vector<Player *>& players() const;
       Scheduler * scheduler();
+      Profiler * profiler();
+      //the players' and master's state, published every period
+      const EngineState * state() const;
       Transport * transport();
       float max_sample_value() const;
       bool player_audible(unsigned int player_index) const;
 
-      //add at index given [if its greater than size just add to end]
-      void add_send_plugin(unsigned int send, unsigned int location_index, AudioPluginNode * plugin_node);
+      //a send's effects, NULL if there is no such send
+      AudioPluginCollection * send_plugins(unsigned int send);
 
       //setters
       void master_volume(float val);
@@ -60,14 +70,24 @@ namespace djaudio {
       void sync_to_player(unsigned int player_index);
       float max_sample_value_reset();
     private:
-      //internal buffers
+      //jobs for mWorkers, index is the player
+      static void compute_block_job(void * master, unsigned int index);
+      static void post_compute_job(void * master, unsigned int index);
+      void publish_state(unsigned int frames);
+
+      //internal buffers, all in mArena
+      BufferArena mArena;
       std::vector<float **> mPlayerBuffers;
       std::vector<float **> mSendBuffers;
       std::vector<AudioPluginCollection> mSendPlugins;
 
       float ** mCueBuffer;
       float * mMasterVolumeBuffer;
+      float * mCueVolumeBuffer;
       float ** mCrossFadeBuffer;
+      Smoother mMasterVolumeSmoother;
+      Smoother mCueVolumeSmoother;
+      Smoother mCrossFadeSmoothers[2];
 
       std::vector<Player *> mPlayers;
       std::array<Command *, 256> mNextBeatCommandBuffer;
@@ -80,6 +100,15 @@ namespace djaudio {
       bool mCrossFade;
       float mCrossFadePosition;
       float mMaxSampleValue;
+
+      Profiler mProfiler;
+      EngineState mState;
+
+      //players render in parallel, each into its own buffer, the block being rendered
+      WorkerPool mWorkers;
+      unsigned int mBlockOffset = 0;
+      unsigned int mBlockFrames = 0;
+      bool mBlockBeat = false;
   };
   class MasterCommand : public Command {
     public:
@@ -143,16 +172,26 @@ namespace djaudio {
       Command * mCommand;
   };
 
+  //adds plugin to a send's effects at the index given [if its greater than size just add to end]
+  //the plugin is set up and the new chain built on the send's latest when the command is created,
+  //the audio thread only swaps it in, the chain it replaces is freed with the command
   class MasterAddPluginCommand : public MasterCommand {
     public:
-      MasterAddPluginCommand(unsigned int send, unsigned int location_index, AudioPluginNode * plugin_node);
+      MasterAddPluginCommand(unsigned int send, unsigned int location_index, AudioPluginPtr plugin);
       virtual ~MasterAddPluginCommand();
       virtual void execute(const Transport& transport);
+      virtual void execute_done();
       virtual bool store(CommandIOData& data) const;
     private:
       unsigned int mSend;
-      unsigned int mLocationIndex;
-      AudioPluginNode * mPlugin;
+      unsigned int mIndex;
+      AudioPluginPtr mPlugin;
+      //what should be running when this executes, and its version then
+      AudioPluginChainPtr mBase;
+      unsigned int mBaseVersion;
+      //the new chain, once executed the one it replaced
+      AudioPluginChainPtr mChain;
+      bool mAdded;
   };
 }
 
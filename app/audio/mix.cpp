@@ -0,0 +1,210 @@
+#include "mix.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <algorithm>
+
+#ifdef DJ_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+  void mix_add_scalar(float * dest, const float * src, float gain, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] += src[i] * gain;
+  }
+
+  void mix_add_scalar(float * dest, const float * src, const float * gain, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] += src[i] * gain[i];
+  }
+
+  float apply_gain_peak_scalar(float * dest, const float * gain, unsigned int count, float peak) {
+    for (unsigned int i = 0; i < count; i++) {
+      dest[i] *= gain[i];
+      peak = std::max(peak, fabsf(dest[i]));
+    }
+    return peak;
+  }
+
+  void fill_ramp_scalar(float * dest, float start, float step, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] = start + step * static_cast<float>(i + 1);
+  }
+
+  void fill_decay_scalar(float * dest, float target, float diff, float coeff, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+      diff *= coeff;
+      dest[i] = target + diff;
+    }
+  }
+
+#ifdef DJ_SIMD_X86
+  DJ_TARGET_SSE2
+  void fill_ramp_sse2(float * dest, float start, float step, unsigned int count) {
+    //computed from the index rather than accumulated so long ramps don't drift
+    const __m128 s = _mm_set1_ps(start);
+    const __m128 st = _mm_set1_ps(step);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4) {
+      _mm_storeu_ps(dest + i, _mm_add_ps(s, _mm_mul_ps(st, index)));
+      index = _mm_add_ps(index, four);
+    }
+    for (; i < count; i++)
+      dest[i] = start + step * static_cast<float>(i + 1);
+  }
+
+  DJ_TARGET_SSE2
+  void fill_decay_sse2(float * dest, float target, float diff, float coeff, unsigned int count) {
+    //four steps at a time, each lane multiplied by coeff^4 per step
+    const float c2 = coeff * coeff;
+    const __m128 t = _mm_set1_ps(target);
+    const __m128 c4 = _mm_set1_ps(c2 * c2);
+    __m128 d = _mm_mul_ps(_mm_set1_ps(diff), _mm_setr_ps(coeff, c2, c2 * coeff, c2 * c2));
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4) {
+      _mm_storeu_ps(dest + i, _mm_add_ps(t, d));
+      d = _mm_mul_ps(d, c4);
+    }
+    if (i < count) {
+      float last[4];
+      _mm_storeu_ps(last, d);
+      //d holds the next four steps, continue from the one before them
+      fill_decay_scalar(dest + i, target, last[0] / coeff, coeff, count - i);
+    }
+  }
+
+  DJ_TARGET_SSE2
+  void mix_add_sse2(float * dest, const float * src, float gain, unsigned int count) {
+    const __m128 g = _mm_set1_ps(gain);
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+      _mm_storeu_ps(dest + i + 4, _mm_add_ps(_mm_loadu_ps(dest + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), g)));
+    }
+    mix_add_scalar(dest + i, src + i, gain, count - i);
+  }
+
+  DJ_TARGET_SSE2
+  void mix_add_sse2(float * dest, const float * src, const float * gain, unsigned int count) {
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(gain + i))));
+      _mm_storeu_ps(dest + i + 4, _mm_add_ps(_mm_loadu_ps(dest + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), _mm_loadu_ps(gain + i + 4))));
+    }
+    mix_add_scalar(dest + i, src + i, gain + i, count - i);
+  }
+
+  DJ_TARGET_SSE2
+  float apply_gain_peak_sse2(float * dest, const float * gain, unsigned int count) {
+    const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peak0 = _mm_setzero_ps();
+    __m128 peak1 = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m128 a = _mm_mul_ps(_mm_loadu_ps(dest + i), _mm_loadu_ps(gain + i));
+      const __m128 b = _mm_mul_ps(_mm_loadu_ps(dest + i + 4), _mm_loadu_ps(gain + i + 4));
+      _mm_storeu_ps(dest + i, a);
+      _mm_storeu_ps(dest + i + 4, b);
+      peak0 = _mm_max_ps(peak0, _mm_and_ps(mask, a));
+      peak1 = _mm_max_ps(peak1, _mm_and_ps(mask, b));
+    }
+    float p[4];
+    _mm_storeu_ps(p, _mm_max_ps(peak0, peak1));
+    const float peak = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+    return apply_gain_peak_scalar(dest + i, gain + i, count - i, peak);
+  }
+
+  DJ_TARGET_AVX2
+  void mix_add_avx2(float * dest, const float * src, float gain, unsigned int count) {
+    const __m256 g = _mm256_set1_ps(gain);
+    unsigned int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      _mm256_storeu_ps(dest + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), g, _mm256_loadu_ps(dest + i)));
+      _mm256_storeu_ps(dest + i + 8, _mm256_fmadd_ps(_mm256_loadu_ps(src + i + 8), g, _mm256_loadu_ps(dest + i + 8)));
+    }
+    mix_add_scalar(dest + i, src + i, gain, count - i);
+  }
+
+  DJ_TARGET_AVX2
+  void mix_add_avx2(float * dest, const float * src, const float * gain, unsigned int count) {
+    unsigned int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      _mm256_storeu_ps(dest + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), _mm256_loadu_ps(gain + i), _mm256_loadu_ps(dest + i)));
+      _mm256_storeu_ps(dest + i + 8, _mm256_fmadd_ps(_mm256_loadu_ps(src + i + 8), _mm256_loadu_ps(gain + i + 8), _mm256_loadu_ps(dest + i + 8)));
+    }
+    mix_add_scalar(dest + i, src + i, gain + i, count - i);
+  }
+
+  DJ_TARGET_AVX2
+  float apply_gain_peak_avx2(float * dest, const float * gain, unsigned int count) {
+    const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak0 = _mm256_setzero_ps();
+    __m256 peak1 = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      const __m256 a = _mm256_mul_ps(_mm256_loadu_ps(dest + i), _mm256_loadu_ps(gain + i));
+      const __m256 b = _mm256_mul_ps(_mm256_loadu_ps(dest + i + 8), _mm256_loadu_ps(gain + i + 8));
+      _mm256_storeu_ps(dest + i, a);
+      _mm256_storeu_ps(dest + i + 8, b);
+      peak0 = _mm256_max_ps(peak0, _mm256_and_ps(mask, a));
+      peak1 = _mm256_max_ps(peak1, _mm256_and_ps(mask, b));
+    }
+    float p[8];
+    _mm256_storeu_ps(p, _mm256_max_ps(peak0, peak1));
+    float peak = 0.0f;
+    for (unsigned int k = 0; k < 8; k++)
+      peak = std::max(peak, p[k]);
+    return apply_gain_peak_scalar(dest + i, gain + i, count - i, peak);
+  }
+#endif
+}
+
+namespace djaudio {
+  void mix_add(float * dest, const float * src, float gain, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::avx2())
+      return mix_add_avx2(dest, src, gain, count);
+    if (simd::sse2())
+      return mix_add_sse2(dest, src, gain, count);
+#endif
+    mix_add_scalar(dest, src, gain, count);
+  }
+
+  void mix_add(float * dest, const float * src, const float * gain, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::avx2())
+      return mix_add_avx2(dest, src, gain, count);
+    if (simd::sse2())
+      return mix_add_sse2(dest, src, gain, count);
+#endif
+    mix_add_scalar(dest, src, gain, count);
+  }
+
+  void fill_ramp(float * dest, float start, float step, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::sse2())
+      return fill_ramp_sse2(dest, start, step, count);
+#endif
+    fill_ramp_scalar(dest, start, step, count);
+  }
+
+  void fill_decay(float * dest, float target, float diff, float coeff, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::sse2() && coeff != 0.0f)
+      return fill_decay_sse2(dest, target, diff, coeff, count);
+#endif
+    fill_decay_scalar(dest, target, diff, coeff, count);
+  }
+
+  float apply_gain_peak(float * dest, const float * gain, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::avx2())
+      return apply_gain_peak_avx2(dest, gain, count);
+    if (simd::sse2())
+      return apply_gain_peak_sse2(dest, gain, count);
+#endif
+    return apply_gain_peak_scalar(dest, gain, count, 0.0f);
+  }
+}
@@ -0,0 +1,20 @@
+#ifndef DATAJOCKEY_MIX_HPP
+#define DATAJOCKEY_MIX_HPP
+
+namespace djaudio {
+  //the vector kernels the mixing stages are built from, picked at runtime like the sample format conversions
+
+  //dest[i] += src[i] * gain
+  void mix_add(float * dest, const float * src, float gain, unsigned int count);
+  //dest[i] += src[i] * gain[i]
+  void mix_add(float * dest, const float * src, const float * gain, unsigned int count);
+  //dest[i] *= gain[i], returns the largest absolute value of the result
+  float apply_gain_peak(float * dest, const float * gain, unsigned int count);
+
+  //dest[i] = start + step * (i + 1)
+  void fill_ramp(float * dest, float start, float step, unsigned int count);
+  //dest[i] = target + diff * pow(coeff, i + 1), a one pole filter settling on target
+  void fill_decay(float * dest, float target, float diff, float coeff, unsigned int count);
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef DATAJOCKEY_MPSCQUEUE_HPP
+#define DATAJOCKEY_MPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include "alignedallocator.hpp"
+
+namespace djaudio {
+  //a bounded lock free queue that any number of threads can push to and one thread pops from,
+  //after Dmitry Vyukov's bounded queue, each slot carries a sequence number so producers claim
+  //slots with a single compare and swap and never wait on each other
+  //the capacity is rounded up to a power of two
+  template <typename T>
+    class MPSCQueue {
+      public:
+        explicit MPSCQueue(std::size_t capacity) : mCells(NULL), mMask(0), mEnqueuePos(0), mDequeuePos(0) {
+          std::size_t size = 2;
+          while (size < capacity)
+            size <<= 1;
+          mMask = size - 1;
+          mCells = new cell_t[size];
+          for (std::size_t i = 0; i < size; i++)
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ~MPSCQueue() { delete [] mCells; }
+
+        std::size_t capacity() const { return mMask + 1; }
+
+        //returns false if the queue is full
+        bool push(const T& value) {
+          std::size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+          for (;;) {
+            cell_t * cell = &mCells[pos & mMask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+              if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell->data = value;
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+              }
+            } else if (diff < 0) {
+              return false;
+            } else {
+              pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+          }
+        }
+
+        //only from the consumer thread, returns false if the queue is empty
+        bool pop(T& value) {
+          cell_t * cell = &mCells[mDequeuePos & mMask];
+          const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+          if (static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(mDequeuePos + 1) < 0)
+            return false;
+          value = cell->data;
+          cell->sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+          mDequeuePos++;
+          return true;
+        }
+      private:
+        MPSCQueue(const MPSCQueue&);
+        MPSCQueue& operator=(const MPSCQueue&);
+
+        struct cell_t {
+          std::atomic<std::size_t> sequence;
+          T data;
+        };
+
+        cell_t * mCells;
+        std::size_t mMask;
+        //keep the producers' and the consumer's positions on their own cache lines
+        char mPad0[DJ_CACHE_LINE];
+        std::atomic<std::size_t> mEnqueuePos;
+        char mPad1[DJ_CACHE_LINE];
+        std::size_t mDequeuePos;
+    };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "pcmcache.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <sys/time.h>
+
+namespace djaudio {
+  namespace pcmcache {
+    QString file_for(const QString& cache_dir, const QString& audio_file, sample_storage_t storage, bool planar) {
+      QFileInfo info(audio_file);
+      if (!info.exists())
+        return QString();
+
+      QByteArray key = QFile::encodeName(info.absoluteFilePath());
+      key.append('\n');
+      key.append(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+      key.append('\n');
+      key.append(QByteArray::number(info.size()));
+
+      QString suffix;
+      switch (storage) {
+        case STORAGE_INT16: suffix = "int16"; break;
+        case STORAGE_HALF: suffix = "half"; break;
+        default: suffix = "float"; break;
+      }
+
+      QString hash = QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+      if (planar)
+        suffix += "-planar";
+      return QDir(cache_dir).filePath(hash + "." + suffix + ".pcm");
+    }
+
+    void touch(const QString& cache_file) {
+      utimes(QFile::encodeName(cache_file).constData(), NULL);
+    }
+
+    void prune(const QString& cache_dir, qint64 max_bytes) {
+      if (max_bytes <= 0)
+        return;
+      QDir dir(cache_dir);
+      //oldest first
+      QFileInfoList files = dir.entryInfoList(QStringList() << "*.pcm", QDir::Files, QDir::Time | QDir::Reversed);
+      qint64 total = 0;
+      foreach (const QFileInfo& info, files)
+        total += info.size();
+      for (int i = 0; i < files.size() && total > max_bytes; i++) {
+        if (QFile::remove(files[i].absoluteFilePath()))
+          total -= files[i].size();
+      }
+    }
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef DATAJOCKEY_PCMCACHE_HPP
+#define DATAJOCKEY_PCMCACHE_HPP
+
+#include <QString>
+#include <stdint.h>
+#include "sampleformat.hpp"
+
+//decoded audio kept on disk so that loading a track again is just a memory map
+namespace djaudio {
+  namespace pcmcache {
+    const uint32_t MAGIC = 0x4d43504a; //"JPCM"
+    const uint32_t VERSION = 1;
+    //the sample data starts on a page boundary so that it is aligned once mapped
+    const uint64_t DATA_ALIGNMENT = 4096;
+
+    //the file starts with this, the sample data and the int16 scales follow at the given offsets
+    //the sample data is laid out exactly as AudioBuffer keeps it in memory
+    struct header_t {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t sample_rate;
+      uint32_t channels;
+      uint32_t frames;
+      uint32_t storage;
+      uint32_t layout;
+      //distance between channels for the planar layout
+      uint32_t channel_offset;
+      //int16 scale blocks per channel
+      uint32_t compact_blocks;
+      float peak;
+      uint64_t data_offset;
+      uint64_t data_bytes;
+      uint64_t scales_offset;
+      uint64_t scales_bytes;
+    };
+
+    //the cache file for an audio file, named by a hash of its path, modification time and size
+    //so that a changed file never matches, returns an empty string if the audio file doesn't exist
+    QString file_for(const QString& cache_dir, const QString& audio_file, sample_storage_t storage, bool planar);
+
+    //mark a cache file as recently used
+    void touch(const QString& cache_file);
+
+    //remove the least recently used cache files until the directory holds at most max_bytes
+    void prune(const QString& cache_dir, qint64 max_bytes);
+  }
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "stretcherrate.hpp"
 #include "defines.hpp"
 #include "config.hpp"
+#include "mix.hpp"
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
 #include <algorithm>
@@ -16,33 +17,11 @@ using std::endl;
 
 using namespace djaudio;
 
-namespace {
-
-  int beat_index(BeatBuffer * beat_buffer, int frame) {
-    //finds the first element which is greater than frame
-    auto it = std::upper_bound(beat_buffer->begin(), beat_buffer->end(), frame);
-    if (it == beat_buffer->end())
-      return beat_buffer->size() - 1;
-    if (it == beat_buffer->begin())
-      return 0;
-    return it - beat_buffer->begin() - 1;
-  }
-
-  int closest_index(BeatBuffer * beat_buffer, int frame) {
-    int beat = beat_index(beat_buffer, frame);
-    if (beat + 1 == static_cast<int>(beat_buffer->size()))
-      return beat;
-    int diffs[2] = {frame - beat_buffer->at(beat), beat_buffer->at(beat + 1) - frame};
-    if (diffs[0] < diffs[1])
-      return beat;
-    return beat + 1;
-  }
-}
-
 Player::Player() : 
   mBeatIndex(0),
   mLoopStartFrame(0),
   mLoopEndFrame(0),
+  mStretcherRate(dj::Configuration::instance()->playback_interpolation()),
   mMaxSampleValue(0.0),
   mEnvelope(djaudio::quarter_sin, 4410),
   mBumpEnvelope(djaudio::ramp_down, 44100 * 10),
@@ -67,19 +46,16 @@ Player::Player() :
   mVolumeBuffer = NULL;
   mBeatBuffer = NULL;
 
-  //XXX who should keep track of these stretchers?
-  mStretcher = new StretcherRate();
+  if (dj::Configuration::instance()->playback_keylock())
+    mStretcher = &mStretcherKeyLock;
+  else
+    mStretcher = &mStretcherRate;
 
   mSetup = false;
 }
 
 Player::~Player(){
-  //cleanup
-  if(mVolumeBuffer)
-    delete [] mVolumeBuffer;
-  for (unsigned int i = 0; i < mSendVolumeBuffers.size(); i++)
-    delete [] mSendVolumeBuffers[i];
-  mSendVolumeBuffers.clear();
+  //cleanup, our buffers belong to the arena
 #ifdef USE_LV2
   if(mEqPlugin)
     delete mEqPlugin;
@@ -91,16 +67,17 @@ Player::~Player(){
 void Player::setup_audio(
     unsigned int sampleRate,
     unsigned int maxBufferLen,
-    unsigned int sendBufferCount) {
+    unsigned int sendBufferCount,
+    BufferArena& arena) {
   //set the sample rate, create our internal audio buffers
   mSampleRate = sampleRate;
   mBumpEnvelope.length(mSampleRate * 10);
-  if(mVolumeBuffer)
-    delete [] mVolumeBuffer;
-  mVolumeBuffer = new float[maxBufferLen];
-  for (unsigned int i = 0; i < mSendVolumeBuffers.size(); i++)
-    delete [] mSendVolumeBuffers[i];
+  mVolumeBuffer = arena.take<float>(maxBufferLen);
   mSendVolumeBuffers.clear();
+  const unsigned int smoothing = static_cast<double>(sampleRate) * GAIN_SMOOTHING_SECONDS;
+  mVolumeSmoother.length(smoothing);
+  mVolumeSmoother.jump(mMute ? 0.0f : static_cast<float>(mVolume));
+  mSendVolumeSmoothers.assign(sendBufferCount, Smoother(Smoother::LINEAR, smoothing, 0.0f));
   mSendVolumes.clear();
 
   unsigned int fade_length = static_cast<double>(sampleRate) * 0.020; //seconds
@@ -109,42 +86,53 @@ void Player::setup_audio(
   mFadeoutIndex = mFadeoutBuffer.size();
 
   for (unsigned int i = 0; i < sendBufferCount; i++) {
-    float * v = new float[maxBufferLen];
-    memset(v, 0, sizeof(float) * maxBufferLen);
-    mSendVolumeBuffers.push_back(v);
+    mSendVolumeBuffers.push_back(arena.take<float>(maxBufferLen));
     mSendVolumes.push_back(0.0f);
   }
 
-#ifdef USE_LV2
+  mStretcherKeyLock.setup(sampleRate);
+
   dj::Configuration * config = dj::Configuration::instance();
-  try {
-    mEqPlugin = new Lv2Plugin(config->eq_uri());
-    mEqPlugin->setup(sampleRate, maxBufferLen);
-    for (int i = 0; i < 3; i++) {
-      dj::eq_band_t band = static_cast<dj::eq_band_t>(i);
-      mEqBandPortMapping[i] = mEqPlugin->port_index(config->eq_port_symbol(band));
-      mEqBandValueMax[i] = mEqPlugin->port_value_max(mEqBandPortMapping[i]);
-      mEqBandValueMin[i] = mEqPlugin->port_value_min(mEqBandPortMapping[i]);
-      mEqBandValueDefault[i] = mEqPlugin->port_value_default(mEqBandPortMapping[i]);
-      mEqBandValueDBScale[i] = config->eq_band_db_scale(band);
-    }
-    QString preset = config->eq_plugin_preset_file();
-    if (preset.size())
-      mEqPlugin->load_preset_from_file(preset);
-  } catch (std::runtime_error& e) {
-    if (mEqPlugin) {
-      delete mEqPlugin;
-      mEqPlugin = nullptr;
+  mEq.setup(sampleRate, config->eq_crossover(0), config->eq_crossover(1));
+#ifdef USE_LV2
+  mEqBuiltin = config->eq_builtin();
+  if (!mEqBuiltin) {
+    try {
+      mEqPlugin = new Lv2Plugin(config->eq_uri());
+      mEqPlugin->setup(sampleRate, maxBufferLen);
+      for (int i = 0; i < 3; i++) {
+        dj::eq_band_t band = static_cast<dj::eq_band_t>(i);
+        mEqBandPortMapping[i] = mEqPlugin->port_index(config->eq_port_symbol(band));
+        mEqBandValueMax[i] = mEqPlugin->port_value_max(mEqBandPortMapping[i]);
+        mEqBandValueMin[i] = mEqPlugin->port_value_min(mEqBandPortMapping[i]);
+        mEqBandValueDefault[i] = mEqPlugin->port_value_default(mEqBandPortMapping[i]);
+        mEqBandValueDBScale[i] = config->eq_band_db_scale(band);
+      }
+      QString preset = config->eq_plugin_preset_file();
+      if (preset.size())
+        mEqPlugin->load_preset_from_file(preset);
+    } catch (std::runtime_error& e) {
+      if (mEqPlugin) {
+        delete mEqPlugin;
+        mEqPlugin = nullptr;
+      }
+      cerr << "error loading plugin: " << e.what() << endl;
+      cerr << "do you have it installed?:" << endl;
+      cerr << "\t\t" << qPrintable(config->eq_uri()) << endl;
+      cerr << "using the builtin eq instead" << endl;
+      mEqBuiltin = true;
     }
-    cerr << "error loading plugin: " << e.what() << endl;
-    cerr << "do you have it installed?:" << endl;
-    cerr << "\t\t" << qPrintable(config->eq_uri()) << endl;
   }
 #endif
 
   mSetup = true;
 }
 
+std::size_t Player::audio_buffer_bytes(unsigned int maxBufferLen, unsigned int sendBufferCount) {
+  //the volume buffer and one per send
+  return (1 + sendBufferCount) * BufferArena::bytes_for<float>(maxBufferLen);
+}
+
 //the audio computation methods
 //setup for audio computation
 void Player::audio_pre_compute(unsigned int /* numFrames */, float ** /* mixBuffer */, const Transport& /* transport */){ 
@@ -154,66 +142,100 @@ void Player::audio_pre_compute(unsigned int /* numFrames */, float ** /* mixBuff
     return;
 }
 
-//actually compute one frame, filling an internal buffer
+//compute a block of frames, filling an internal buffer
 //syncing to the transport if mSync == true
-void Player::audio_compute_frame(unsigned int frame, float ** mixBuffer, 
+void Player::audio_compute_block(unsigned int offset, unsigned int frames, float ** mixBuffer, 
     const Transport& transport, bool inbeat){
-  //zero out the frame;
-  mixBuffer[0][frame] = mixBuffer[1][frame] = 0.0;
+  float * left = mixBuffer[0] + offset;
+  float * right = mixBuffer[1] + offset;
+
+  //zero out the block
+  memset(left, 0, sizeof(float) * frames);
+  memset(right, 0, sizeof(float) * frames);
 
   if(!mStretcher->audio_buffer())
     return;
 
-  //compute the volume
-  mVolumeBuffer[frame] = mMute ? 0.0 : mVolume;
+  //compute the volume, ramping to any new values
+  mVolumeSmoother.target(mMute ? 0.0f : static_cast<float>(mVolume));
+  mVolumeSmoother.fill(mVolumeBuffer + offset, frames);
 
-  for (unsigned int i = 0; i < mSendVolumes.size(); i++)
-    mSendVolumeBuffers[i][frame] = mSendVolumes[i];
+  for (unsigned int i = 0; i < mSendVolumes.size(); i++) {
+    mSendVolumeSmoothers[i].target(mSendVolumes[i]);
+    mSendVolumeSmoothers[i].fill(mSendVolumeBuffers[i] + offset, frames);
+  }
 
-  //compute the actual frame
-  if(mPlayState == PLAY) {
-    //only update the rate on the beat.
-    if (inbeat && mSync && mBeatBuffer) {
-      mBeatIndex = ::beat_index(mBeatBuffer, mStretcher->frame());
-      update_play_speed(&transport);
+  if(mPlayState != PLAY) {
+    //mix in any fade out we have left
+    for (unsigned int i = 0; i < frames && (mFadeoutIndex + 1) < mFadeoutBuffer.size(); i++) {
+      left[i] += mFadeoutBuffer[mFadeoutIndex];
+      right[i] += mFadeoutBuffer[mFadeoutIndex + 1];
+      mFadeoutIndex += 2;
     }
+    return;
+  }
+
+  //only update the rate on the beat.
+  if (inbeat && mSync && mBeatBuffer) {
+    update_beat_index();
+    update_play_speed(&transport);
+  }
+
+  //compute in chunks, splitting at the loop end so we can jump back to the start
+  unsigned int done = 0;
+  while (done < frames) {
+    unsigned int count = frames - done;
+    float * chunk[2] = { left + done, right + done };
 
-    float buffer[2];
     if (mBumpState == BUMP_OFF) {
-      mStretcher->next_frame(buffer);
+      if (mLoop)
+        count = frames_till_loop_end(count);
+      mStretcher->next_block(chunk, 0, count);
     } else {
+      //the rate changes every frame while bumping, so we go frame by frame
+      count = 1;
+      float buffer[2];
       double rate_offset = mBumpState == BUMP_REV ? mBumpEnvelope.value() : (1.0 + mBumpEnvelope.reversed_value()) ;
       mBumpEnvelope.step();
       mStretcher->next_frame(buffer, rate_offset);
+      chunk[0][0] = buffer[0];
+      chunk[1][0] = buffer[1];
     }
+    apply_gain(chunk, count);
 
-    if (!mEnvelope.at_end()) {
-      double v = mEnvelope.value_step();
-      buffer[0] *= v;
-      buffer[1] *= v;
+    //fade in
+    for (unsigned int i = 0; i < count && !mEnvelope.at_end(); i++) {
+      float v = mEnvelope.value_step();
+      chunk[0][i] *= v;
+      chunk[1][i] *= v;
     }
 
-    mixBuffer[0][frame] = buffer[0];
-    mixBuffer[1][frame] = buffer[1];
-
-  }
+    for (unsigned int i = 0; i < count && (mFadeoutIndex + 1) < mFadeoutBuffer.size(); i++) {
+      chunk[0][i] += mFadeoutBuffer[mFadeoutIndex];
+      chunk[1][i] += mFadeoutBuffer[mFadeoutIndex + 1];
+      mFadeoutIndex += 2;
+    }
 
-  if ((mFadeoutIndex + 1) < mFadeoutBuffer.size()) {
-    mixBuffer[0][frame] += mFadeoutBuffer[mFadeoutIndex];
-    mixBuffer[1][frame] += mFadeoutBuffer[mFadeoutIndex + 1];
-    mFadeoutIndex += 2;
+    if (mLoop) {
+      if(mLoopEndFrame > mLoopStartFrame && mStretcher->frame() >= mLoopEndFrame)
+        position_at_frame(mLoopStartFrame);
+    }
+    done += count;
   }
 
-  if (mLoop && mPlayState == PLAY) {
-    if(mLoopEndFrame > mLoopStartFrame && mStretcher->frame() >= mLoopEndFrame)
-      position_at_frame(mLoopStartFrame);
-  }
+  //follow the stretcher so beat lookups start from where we are
+  if (mBeatBuffer)
+    update_beat_index();
 }
 
 //finalize audio computation, apply effects, etc.
 void Player::audio_post_compute(unsigned int numFrames, float ** mixBuffer){
   if(!mStretcher->audio_buffer())
     return;
+  if (mEqBuiltin) {
+    mEq.compute(numFrames, mixBuffer);
+    return;
+  }
 #ifdef USE_LV2
   if(mEqPlugin)
     mEqPlugin->compute(numFrames, mixBuffer);
@@ -223,24 +245,24 @@ void Player::audio_post_compute(unsigned int numFrames, float ** mixBuffer){
 //actually fill the output vectors
 void Player::audio_fill_output_buffers(unsigned int numFrames,
     float ** mixBuffer, float ** cueBuffer, std::vector<float **>& sendBuffers){
-  if(!mStretcher->audio_buffer()) {
-    mMaxSampleValue = std::max(mMaxSampleValue, 0.0f);
+  if(!mStretcher->audio_buffer())
     return;
-  }
 
-  //send the data out, copying to the cue buffer before volume if needed
+  //send the data out, adding to the cue bus before volume if needed
   const bool cueing = (mOutState == CUE);
   const bool mute_main = cueing && mCueMutesMain;
+  const unsigned int sends = std::min(mSendVolumeBuffers.size(), sendBuffers.size());
   for (unsigned int i = 0; i < 2; i++){
-    for (unsigned int j = 0; j < numFrames; j++){
-      float sample_with_volume = mixBuffer[i][j] * mVolumeBuffer[j];
-
-      cueBuffer[i][j] = cueing ? mixBuffer[i][j] : 0.0f;
-      mMaxSampleValue = std::max(mMaxSampleValue, fabsf(sample_with_volume));
-      mixBuffer[i][j] = mute_main ? 0.0f : sample_with_volume;
-      for (unsigned int k = 0; k < std::min(mSendVolumeBuffers.size(), sendBuffers.size()); k++)
-        sendBuffers[k][i][j] += mixBuffer[i][j] * mSendVolumeBuffers[k][j];
+    if (cueing)
+      mix_add(cueBuffer[i], mixBuffer[i], 1.0f, numFrames);
+    mMaxSampleValue = std::max(mMaxSampleValue, apply_gain_peak(mixBuffer[i], mVolumeBuffer, numFrames));
+    if (mute_main) {
+      //the sends are fed from the main mix so they're muted too
+      memset(mixBuffer[i], 0, sizeof(float) * numFrames);
+      continue;
     }
+    for (unsigned int k = 0; k < sends; k++)
+      mix_add(sendBuffers[k][i], mixBuffer[i], mSendVolumeBuffers[k], numFrames);
   }
 }
 
@@ -250,6 +272,7 @@ Player::out_state_t Player::out_state() const { return mOutState; }
 bool Player::muted() const { return mMute; }
 bool Player::syncing() const { return mSync; }
 bool Player::looping() const { return mLoop; }
+bool Player::keylock() const { return mStretcher == &mStretcherKeyLock; }
 double Player::volume() const { return mVolume; }
 float Player::send_volume(unsigned int index) const {
   if (index >= mSendVolumes.size())
@@ -269,22 +292,15 @@ double Player::bpm() {
   if (!mBeatBuffer)
     return 0.0;
 
-  mBeatIndex = ::beat_index(mBeatBuffer, mStretcher->frame());
-  unsigned int beat = mBeatIndex;
-  if (beat + 1 >= mBeatBuffer->size())
-    beat = mBeatBuffer->size() - 2;
-
-  const double seconds = static_cast<double>(mBeatBuffer->at(beat + 1) - mBeatBuffer->at(beat)) / static_cast<double>(mSampleRate);
-  const double s_per_beat = seconds / mStretcher->speed();
-
-  return 60.0 / s_per_beat; //becomes beats per min
+  update_beat_index();
+  return mBeatBuffer->bpm(mBeatIndex, mSampleRate) * mStretcher->speed();
 }
 
 double Player::pos_in_beat() const {
   if (!mBeatBuffer || !mStretcher->audio_buffer())
     return 0.0;
 
-  int beat = ::beat_index(mBeatBuffer, mStretcher->frame());
+  int beat = mBeatBuffer->beat_index(mStretcher->frame(), mBeatIndex);
   return pos_in_beat(mStretcher->frame(), beat);
 }
 
@@ -307,7 +323,7 @@ void Player::play_state(play_state_t val, Transport * transport) {
       if (transport && mSync && mPlayState == PLAY)
         update_play_speed(transport);
       else
-        mBeatIndex = ::beat_index(mBeatBuffer, mStretcher->frame());
+        update_beat_index();
     }
 
     //render our fadeout
@@ -318,6 +334,8 @@ void Player::play_state(play_state_t val, Transport * transport) {
       mFadeoutIndex = 0;
     } else if (mPlayState == PLAY) {
       mEnvelope.reset();
+      //a load that completes while we play would jump the level, so the gain only changes here and on load
+      mGain = audio_buffer() ? audio_buffer()->gain() : 1.0f;
     }
   }
 }
@@ -342,6 +360,27 @@ void Player::loop(bool val){
   mLoop = val;
 }
 
+void Player::keylock(bool val) {
+  Stretcher * next = val ? static_cast<Stretcher *>(&mStretcherKeyLock) : &mStretcherRate;
+  if (next == mStretcher)
+    return;
+
+  AudioBuffer * buffer = mStretcher->audio_buffer();
+  const unsigned int frame = mStretcher->frame();
+  const double frame_subsample = mStretcher->frame_subsample();
+  const double speed = mStretcher->speed();
+
+  //fade out what the old one was playing while the new one picks up where it was
+  if (buffer && mPlayState == PLAY)
+    setup_seek_fade();
+  mStretcher->audio_buffer(NULL);
+
+  next->audio_buffer(buffer);
+  next->frame(frame, frame_subsample);
+  next->speed(speed);
+  mStretcher = next;
+}
+
 void Player::bump_start(bool forward) {
   mBumpEnvelope.reset();
   mBumpState = forward ? BUMP_FWD : BUMP_REV;
@@ -377,7 +416,7 @@ void Player::position_at_frame(unsigned long frame, Transport * transport) {
     if (transport && mSync && mPlayState == PLAY)
       sync_to_transport(transport);
     else
-      mBeatIndex = ::beat_index(mBeatBuffer, mStretcher->frame());
+      update_beat_index();
   }
 }
 
@@ -394,7 +433,7 @@ void Player::position_at_beat_relative(int offset, Transport * transport) {
     return;
 
   //find our current position
-  const unsigned int current_beat = ::beat_index(mBeatBuffer, mStretcher->frame());
+  const unsigned int current_beat = mBeatBuffer->beat_index(mStretcher->frame(), mBeatIndex);
   unsigned long frame = 0;
 
   if (offset < 0 && current_beat < static_cast<unsigned int>(-offset)) {
@@ -404,11 +443,10 @@ void Player::position_at_beat_relative(int offset, Transport * transport) {
     unsigned int new_beat = current_beat + offset;
 
     if (new_beat + 1 < mBeatBuffer->size()) {
-      int beat_frames[2] = { mBeatBuffer->at(new_beat), mBeatBuffer->at(new_beat + 1) };
       int frame_offset = static_cast<int>(
-          static_cast<double>(beat_frames[1] - beat_frames[0]) * pos_in_beat(mStretcher->frame(), current_beat));
+          static_cast<double>(mBeatBuffer->beat_frames(new_beat)) * pos_in_beat(mStretcher->frame(), current_beat));
 
-      frame = beat_frames[0] + frame_offset;
+      frame = mBeatBuffer->at(new_beat) + frame_offset;
     } else {
       new_beat = mBeatBuffer->size() - 1;
       frame = mBeatBuffer->at(new_beat);
@@ -435,6 +473,7 @@ void Player::audio_buffer(AudioBuffer * buf){
   }
   mStretcher->audio_buffer(buf);
   mStretcher->frame(0);
+  mGain = buf ? buf->gain() : 1.0f;
 }
 
 void Player::beat_buffer(BeatBuffer * buf){
@@ -444,6 +483,10 @@ void Player::beat_buffer(BeatBuffer * buf){
 }
 
 void Player::eq(dj::eq_band_t band, double value) {
+  if (mEqBuiltin) {
+    mEq.band(band, value);
+    return;
+  }
 #ifdef USE_LV2
   if (!mEqPlugin)
     return;
@@ -473,6 +516,10 @@ float Player::max_sample_value_reset() {
   return v;
 };
 
+bool Player::starved_reset() {
+  return mStretcher->starved_reset();
+}
+
 void Player::position_at_frame_relative(long offset){
   if (offset < 0 && -offset > mStretcher->frame())
     position_at_frame(0);
@@ -495,7 +542,7 @@ void Player::update_play_speed(const Transport * transport) {
 
   //find the closest index
   int frame = mStretcher->frame();
-  int beat_closest = closest_index(mBeatBuffer, frame);
+  int beat_closest = mBeatBuffer->closest_index(frame, mBeatIndex);
 
   if (beat_closest + 2 >= static_cast<int>(mBeatBuffer->size())) {
     beat_closest = mBeatBuffer->size() - 3;
@@ -513,9 +560,9 @@ void Player::update_play_speed(const Transport * transport) {
       static_cast<unsigned int>(frame) >= mLoopStartFrame &&
       static_cast<unsigned int>(frame) < mLoopEndFrame) {
     int loop_frames = mLoopEndFrame - mLoopStartFrame;
-    int loop_beat_start = ::beat_index(mBeatBuffer, frame);
+    int loop_beat_start = mBeatBuffer->beat_index(frame, mBeatIndex);
     if (loop_beat_start + 1 < static_cast<int>(mBeatBuffer->size()) && loop_frames > 0) {
-      int beat_frames = mBeatBuffer->at(loop_beat_start + 1) - mBeatBuffer->at(loop_beat_start);
+      int beat_frames = mBeatBuffer->beat_frames(loop_beat_start);
       double loop_size = static_cast<double>(loop_frames) / static_cast<double>(beat_frames);
       //adjust frame that we're computing against to wrap at loop size
       if (loop_size < 0.8) {
@@ -541,7 +588,7 @@ void Player::sync_to_transport(const Transport * transport) {
     return;
 
   //XXX revisit, should it be closest_index ?
-  unsigned int beat = ::beat_index(mBeatBuffer, mStretcher->frame());
+  unsigned int beat = mBeatBuffer->beat_index(mStretcher->frame(), mBeatIndex);
   if (trans_pos.pos_in_beat() > 0.5 && beat > 1)
     beat -= 1;
 
@@ -550,9 +597,8 @@ void Player::sync_to_transport(const Transport * transport) {
     mBeatIndex = beat;
 
     //update position
-    const int beat_frames[2] = {mBeatBuffer->at(beat), mBeatBuffer->at(beat + 1) };
-    double frames_in_beat = beat_frames[1] - beat_frames[0];
-    int frame = beat_frames[0] + frames_in_beat * trans_pos.pos_in_beat();
+    double frames_in_beat = mBeatBuffer->beat_frames(beat);
+    int frame = mBeatBuffer->at(beat) + frames_in_beat * trans_pos.pos_in_beat();
     mStretcher->frame(frame);
 
     //update rate
@@ -562,18 +608,36 @@ void Player::sync_to_transport(const Transport * transport) {
 }
 
 double Player::pos_in_beat(int frame, unsigned int beat) const {
-  if (beat + 1 >= mBeatBuffer->size())
-    return 0.0;
+  return mBeatBuffer->pos_in_beat(frame, beat);
+}
 
-  int beat_times[2] = { mBeatBuffer->at(beat), mBeatBuffer->at(beat + 1) };
+void Player::update_beat_index() {
+  const int beat = mBeatBuffer->beat_index(mStretcher->frame(), mBeatIndex);
+  mBeatIndex = beat < 0 ? 0 : beat;
+}
 
-  double div = static_cast<double>(beat_times[1] - beat_times[0]);
-  if (div <= 0.0)
-    return 0.0;
 
-  return static_cast<double>(frame - beat_times[0]) / div;
+unsigned int Player::frames_till_loop_end(unsigned int frames) const {
+  const double step = mStretcher->speed();
+  if (mLoopEndFrame <= mLoopStartFrame || step <= 0.0)
+    return frames;
+
+  //we jump after computing the first frame that lands at or past the loop end
+  const double pos = static_cast<double>(mStretcher->frame()) + mStretcher->frame_subsample();
+  const double remaining = ceil((static_cast<double>(mLoopEndFrame) - pos) / step);
+  if (remaining < 1.0)
+    return 1;
+  if (remaining < static_cast<double>(frames))
+    return static_cast<unsigned int>(remaining);
+  return frames;
 }
 
+void Player::apply_gain(float ** chunk, unsigned int frames) {
+  for (unsigned int i = 0; i < frames; i++) {
+    chunk[0][i] *= mGain;
+    chunk[1][i] *= mGain;
+  }
+}
 
 void Player::fill_fade_buffer() {
   const unsigned int channels = audio_buffer()->channels();
@@ -584,7 +648,7 @@ void Player::fill_fade_buffer() {
 
   //apply envelope
   for (unsigned int i = 0; i < fade_frames; i++) {
-    double e = mEnvelope.reversed_value_at(i);
+    double e = mEnvelope.reversed_value_at(i) * mGain;
     for (unsigned int c = 0; c < channels; c++)
       mFadeoutBuffer[i * channels + c] *= e;
   }
@@ -679,6 +743,12 @@ void PlayerStateCommand::execute(const Transport& /*transport*/){
       case NO_LOOP:
         p->loop(false);
         break;
+      case KEYLOCK:
+        p->keylock(true);
+        break;
+      case NO_KEYLOCK:
+        p->keylock(false);
+        break;
     };
   }
 }
@@ -725,6 +795,12 @@ bool PlayerStateCommand::store(CommandIOData& data) const{
     case BUMP_OFF:
       data["action"] = "bump_off";
       break;
+    case KEYLOCK:
+      data["action"] = "keylock";
+      break;
+    case NO_KEYLOCK:
+      data["action"] = "no_keylock";
+      break;
   };
   return true;
 }
@@ -1000,7 +1076,7 @@ void PlayerLoopCommand::execute(const Transport& transport) {
   int old_loop_frames = 0;
   if (p->looping())
     old_loop_frames = p->loop_end_frame() - p->loop_start_frame();
-  const unsigned int beat = beat_buff ? beat_index(beat_buff, p->frame()) : 0;
+  const unsigned int beat = beat_buff ? beat_buff->beat_index(p->frame(), p->beat_index()) : 0;
 
   if (mEndFrame < 0) {
     if (!beat_buff)
@@ -1019,7 +1095,7 @@ void PlayerLoopCommand::execute(const Transport& transport) {
       else
         mEndFrame = beat_buff->at(beat_end);
     } else {
-      beat_end = beat_index(beat_buff, mStartFrame) + mBeats;
+      beat_end = beat_buff->beat_index(mStartFrame) + mBeats;
       mEndFrame = beat_buff->at(beat_end);
     }
 
@@ -1037,7 +1113,7 @@ void PlayerLoopCommand::execute(const Transport& transport) {
   } else if (mStartFrame < 0) {
     if (!beat_buff)
       return;
-    unsigned int beat_end = beat_index(beat_buff, mEndFrame);
+    unsigned int beat_end = beat_buff->beat_index(mEndFrame);
     if (beat_end < mBeats) {
       mStartFrame = 0;
     } else {
@@ -1114,8 +1190,8 @@ void PlayerLoopShiftCommand::execute(const Transport& /*transport*/) {
   if (!audio || !beat_buff)
     return;
 
-  int beat_start = beat_index(beat_buff, p->loop_start_frame());
-  int beat_end = beat_index(beat_buff, p->loop_end_frame());
+  int beat_start = beat_buff->beat_index(p->loop_start_frame());
+  int beat_end = beat_buff->beat_index(p->loop_end_frame());
 
   beat_start += mBeats;
   beat_end += mBeats;
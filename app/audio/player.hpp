@@ -7,8 +7,13 @@
 #include "audiobuffer.hpp"
 #include "annotation.hpp"
 #include "stretcher.hpp"
+#include "stretcherrate.hpp"
+#include "stretcherwsola.hpp"
 #include "envelope.hpp"
+#include "smoother.hpp"
+#include "bufferarena.hpp"
 #include "defines.hpp"
+#include "equalizer.hpp"
 
 #ifdef USE_LV2
 #include "lv2plugin.h"
@@ -24,12 +29,15 @@ namespace djaudio {
       Player();
       ~Player();
 
-      //this creates internal buffers
+      //this creates internal buffers, taking them from arena
       //** must be called BEFORE the audio callback starts
       void setup_audio(
           unsigned int sampleRate,
           unsigned int maxBufferLen,
-          unsigned int sendBufferCount);
+          unsigned int sendBufferCount,
+          BufferArena& arena);
+      //the arena space setup_audio takes
+      static std::size_t audio_buffer_bytes(unsigned int maxBufferLen, unsigned int sendBufferCount);
 
       //the audio computation methods
       //the player doesn't own its own buffer, it is passed it..
@@ -37,17 +45,18 @@ namespace djaudio {
       //setup for audio computation, we will be computing numFrames
       void audio_pre_compute(unsigned int numFrames, float ** mixBuffer,
           const Transport& transport); 
-      //actually compute one frame, filling an internal buffer
+      //compute a block of frames starting at offset, filling an internal buffer
       //syncing to the transport if mSync == true,
-      //inbeat reflects if the transport computed a new beat on the last
-      //tick
-      void audio_compute_frame(unsigned int frame, float ** mixBuffer, 
+      //inbeat reflects if the transport computed a new beat on the tick
+      //for the first frame of the block, the caller must not let a beat fall
+      //inside the block
+      void audio_compute_block(unsigned int offset, unsigned int frames, float ** mixBuffer, 
           const Transport& transport, bool inbeat); 
       //finalize audio computation, apply effects, etc.
       void audio_post_compute(unsigned int numFrames, float ** mixBuffer); 
 
       //actually fill the output vectors
-      //send buffers may already have audio in them, so mix into them
+      //the cue and send buffers are shared by all the players, so mix into them
       void audio_fill_output_buffers(unsigned int numFrames, 
           float ** mixBuffer, float ** cueBuffer, std::vector<float **>& sendBuffers);
 
@@ -57,6 +66,7 @@ namespace djaudio {
       bool muted() const;
       bool syncing() const;
       bool looping() const;
+      bool keylock() const;
       double volume() const;
       float send_volume(unsigned int send_index) const;
       double play_speed() const;
@@ -76,6 +86,8 @@ namespace djaudio {
       void mute(bool val);
       void sync(bool val, const Transport * transport = NULL);
       void loop(bool val);
+      //keep the pitch when the speed changes, switches stretchers without allocating
+      void keylock(bool val);
       void bump_start(bool forward);
       void bump_stop();
       void volume(double val);
@@ -95,6 +107,8 @@ namespace djaudio {
       void beat_buffer(BeatBuffer * buf);
       void eq(dj::eq_band_t band, double value);
       float max_sample_value_reset();
+      //true if playback has run ahead of a track that is still loading since the last call
+      bool starved_reset();
 
       //misc
       void position_at_frame_relative(long offset);
@@ -126,9 +140,16 @@ namespace djaudio {
       double mSampleRateMult = 1.0;
       float * mVolumeBuffer;
       std::vector<float *> mSendVolumeBuffers;
+      Smoother mVolumeSmoother;
+      std::vector<Smoother> mSendVolumeSmoothers;
       BeatBuffer * mBeatBuffer;
+      //the stretcher playing, one of the two below
       Stretcher * mStretcher;
+      StretcherRate mStretcherRate;
+      StretcherWSOLA mStretcherKeyLock;
       float mMaxSampleValue;
+      //the normalization gain we play at, taken when we start playing or get a new buffer
+      float mGain = 1.0f;
 
       Envelope mEnvelope;
       Envelope mBumpEnvelope;
@@ -136,7 +157,9 @@ namespace djaudio {
       unsigned int mFadeoutIndex;
       std::vector<float> mFadeoutBuffer;
 
-      //the eq instance
+      //the eq instance, our own unless configured to use lv2
+      bool mEqBuiltin = true;
+      Equalizer mEq;
 #ifdef USE_LV2
       Lv2Plugin * mEqPlugin;
       std::array<uint32_t, 3> mEqBandPortMapping;
@@ -151,8 +174,14 @@ namespace djaudio {
       void update_play_speed(const Transport * transport);
       void sync_to_transport(const Transport * transport);
       double pos_in_beat(int pos_frame, unsigned int pos_beat) const;
+      //move mBeatIndex to the beat at the stretcher's frame, walking from where it was
+      void update_beat_index();
       void fill_fade_buffer(); //moves our stretcher index..
       void setup_seek_fade();
+      //the number of frames we can compute before we pass the loop end
+      unsigned int frames_till_loop_end(unsigned int frames) const;
+      //apply the normalization gain to a chunk of stretcher output
+      void apply_gain(float ** chunk, unsigned int frames);
   };
 
   //forward declaration
@@ -186,7 +215,8 @@ namespace djaudio {
         SYNC, NO_SYNC,
         MUTE, NO_MUTE,
         LOOP, NO_LOOP,
-        BUMP_FWD, BUMP_REV, BUMP_OFF
+        BUMP_FWD, BUMP_REV, BUMP_OFF,
+        KEYLOCK, NO_KEYLOCK
       };
       PlayerStateCommand(unsigned int idx, action_t action);
       virtual void execute(const Transport& transport);
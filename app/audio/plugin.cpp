@@ -2,38 +2,62 @@
 
 int AudioPlugin::cIndexCount = 0;
 
-AudioPluginCollection::AudioPluginCollection() {
+AudioPluginChain::AudioPluginChain(unsigned int capacity) {
+  mOwners.reserve(capacity);
+  mPlugins.reserve(capacity);
+}
+
+bool AudioPluginChain::insert(const AudioPluginChain& other, unsigned int index, AudioPluginPtr plugin) {
+  if (other.mOwners.size() + 1 > mOwners.capacity() || other.mPlugins.size() + 1 > mPlugins.capacity())
+    return false;
+  if (index > other.size())
+    index = other.size();
+
+  mOwners.clear();
+  mPlugins.clear();
+  for (unsigned int i = 0; i <= other.size(); i++) {
+    const AudioPluginPtr& p = i == index ? plugin : other.mOwners[i < index ? i : i - 1];
+    mOwners.push_back(p);
+    mPlugins.push_back(p.data());
+  }
+  mVersion++;
+  return true;
+}
+
+AudioPluginCollection::AudioPluginCollection() :
+  mRunning(new AudioPluginChain),
+  mLatest(mRunning)
+{
 }
 
 AudioPluginCollection::~AudioPluginCollection() {
 }
 
 void AudioPluginCollection::setup(unsigned int sample_rate, unsigned int max_buffer_length) {
-  mEffects.each(
-    [sample_rate, max_buffer_length](AudioPluginPtr plugin) {
-      plugin->setup(sample_rate, max_buffer_length);
-    });
+  mSampleRate = sample_rate;
+  mMaxBufferLength = max_buffer_length;
+  for (unsigned int i = 0; i < mRunning->size(); i++)
+    mRunning->at(i)->setup(sample_rate, max_buffer_length);
 }
 
-void AudioPluginCollection::compute(unsigned int nframes, float ** mixBuffer) {
-  mEffects.each(
-    [nframes, &mixBuffer](AudioPluginPtr plugin) {
-      plugin->compute(nframes, mixBuffer);
-    });
+void AudioPluginCollection::setup_plugin(AudioPlugin * plugin) const {
+  plugin->setup(mSampleRate, mMaxBufferLength);
 }
 
-void AudioPluginCollection::stop() {
-  mEffects.each(
-    [](AudioPluginPtr plugin) {
-      plugin->stop();
-    });
+void AudioPluginCollection::compute(unsigned int nframes, float ** mixBuffer) {
+  const AudioPluginChain * chain = mRunning.data();
+  for (unsigned int i = 0; i < chain->size(); i++)
+    chain->at(i)->compute(nframes, mixBuffer);
 }
 
-void AudioPluginCollection::append(AudioPluginNode * plugin) {
-  mEffects.push_back(plugin);
+void AudioPluginCollection::stop() {
+  for (unsigned int i = 0; i < mRunning->size(); i++)
+    mRunning->at(i)->stop();
 }
 
-void AudioPluginCollection::insert(unsigned int index, AudioPluginNode * plugin) {
+void AudioPluginCollection::swap(AudioPluginChainPtr& chain) {
+  //the pointers change hands, no counts change and nothing is freed
+  mRunning.swap(chain);
 }
 
 AudioPlugin::AudioPlugin() {
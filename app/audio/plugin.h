@@ -1,9 +1,9 @@
 #ifndef AUDIO_PLUGIN_H
 #define AUDIO_PLUGIN_H
 
-#include "doublelinkedlist.h"
 #include <QString>
 #include <QSharedPointer>
+#include <vector>
 
 class AudioPluginControlDescription {
   public:
@@ -31,21 +31,58 @@ class AudioPlugin {
 };
 
 typedef QSharedPointer<AudioPlugin> AudioPluginPtr;
-typedef DoubleLinkedListNode<AudioPluginPtr> AudioPluginNode;
 
+//plugins run in order, not changed once the audio thread runs it
+class AudioPluginChain {
+  public:
+    //room for capacity plugins, so that insert doesn't allocate
+    explicit AudioPluginChain(unsigned int capacity = 0);
+
+    //make this a copy of other with plugin inserted at index, at the end if index is past it
+    //doesn't allocate, returns false if there isn't room
+    bool insert(const AudioPluginChain& other, unsigned int index, AudioPluginPtr plugin);
+
+    unsigned int size() const { return mPlugins.size(); }
+    AudioPlugin * at(unsigned int index) const { return mPlugins[index]; }
+    //counts inserts, so a chain built on this one can tell if it has changed since
+    unsigned int version() const { return mVersion; }
+  private:
+    unsigned int mVersion = 0;
+    //keeps the plugins around as long as the chain is
+    std::vector<AudioPluginPtr> mOwners;
+    //what the audio thread walks
+    std::vector<AudioPlugin *> mPlugins;
+};
+
+typedef QSharedPointer<AudioPluginChain> AudioPluginChainPtr;
+
+//runs a chain, a new chain is built outside of the audio thread on top of the last one built,
+//swapped in from the audio thread and the one it replaces is handed back to be freed outside of it
 class AudioPluginCollection : public AudioPlugin {
   public:
     AudioPluginCollection();
     virtual ~AudioPluginCollection();
+    //sets up what is running and remembers the settings for the plugins that are added later
     virtual void setup(unsigned int sample_rate, unsigned int max_buffer_length);
+    //not in the audio thread, set up a plugin before it goes into a chain
+    void setup_plugin(AudioPlugin * plugin) const;
 
     virtual void compute(unsigned int nframes, float ** mixBuffer);
     virtual void stop();
 
-    void insert(unsigned int index, AudioPluginNode * plugin);
-    void append(AudioPluginNode * plugin); 
+    //not in the audio thread and only from one thread, the last chain built, what the next is built on
+    AudioPluginChainPtr latest() const { return mLatest; }
+    void latest(AudioPluginChainPtr chain) { mLatest = chain; }
+
+    //audio thread
+    const AudioPluginChain& running() const { return *mRunning; }
+    //run chain from now on, chain is given the one it replaces to be freed outside of the audio thread
+    void swap(AudioPluginChainPtr& chain);
   private:
-    DoubleLinkedList<AudioPluginPtr> mEffects;
+    AudioPluginChainPtr mRunning;
+    AudioPluginChainPtr mLatest;
+    unsigned int mSampleRate = 0;
+    unsigned int mMaxBufferLength = 0;
 };
 
 #endif
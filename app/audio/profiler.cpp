@@ -0,0 +1,261 @@
+#include "profiler.hpp"
+#include <time.h>
+#include <algorithm>
+#include <sstream>
+
+using namespace djaudio;
+
+namespace {
+  //enough for about a second of periods with a few players at small buffer sizes
+  const std::size_t RING_SAMPLES = 8192;
+  //periods kept to look back at on an xrun
+  const std::size_t RECENT_PERIODS = 32;
+  //how far before the xrun notification to look for the late period
+  const uint32_t XRUN_LOOKBACK = 2;
+}
+
+const char * Profiler::stage_name(stage_t stage) {
+  switch (stage) {
+    case SCHEDULE: return "schedule";
+    case RENDER: return "render";
+    case EQ: return "eq";
+    case MIX: return "mix";
+    case SENDS: return "sends";
+    case PERIOD: return "period";
+    default: return "unknown";
+  }
+}
+
+Profiler::Profiler() :
+  mSamples(RING_SAMPLES),
+  mSampleRate(44100),
+  mPeriodStart(0),
+  mFrames(0),
+  mPeriod(0),
+  mXruns(0),
+  mXrunPeriod(0),
+  mDropped(0)
+{
+}
+
+void Profiler::setup(unsigned int sample_rate, unsigned int players) {
+  mSampleRate = sample_rate;
+  for (unsigned int i = 0; i < STAGE_COUNT; i++)
+    mPlayerNanos[i].assign(players, 0);
+}
+
+uint64_t Profiler::now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000ull + static_cast<uint64_t>(t.tv_nsec);
+}
+
+void Profiler::begin_period(unsigned int frames) {
+  mPeriodStart = now();
+  mFrames = static_cast<uint16_t>(std::min(frames, 65535u));
+}
+
+void Profiler::record(stage_t stage, uint64_t start) {
+  push(stage, 0, now() - start);
+}
+
+void Profiler::record_nanos(stage_t stage, uint64_t nanos) {
+  push(stage, 0, nanos);
+}
+
+void Profiler::add_player(stage_t stage, unsigned int player, uint64_t start) {
+  if (player < mPlayerNanos[stage].size())
+    mPlayerNanos[stage][player] += now() - start;
+}
+
+void Profiler::end_period() {
+  //the workers are done with the period so their times are ours to read
+  const stage_t player_stages[] = {RENDER, EQ};
+  for (unsigned int s = 0; s < 2; s++) {
+    std::vector<uint64_t>& nanos = mPlayerNanos[player_stages[s]];
+    for (unsigned int p = 0; p < nanos.size(); p++) {
+      push(player_stages[s], p, nanos[p]);
+      nanos[p] = 0;
+    }
+  }
+  push(PERIOD, 0, now() - mPeriodStart);
+  mPeriod.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::xrun() {
+  mXrunPeriod.store(mPeriod.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  mXruns.fetch_add(1, std::memory_order_release);
+}
+
+bool Profiler::read(sample_t& sample) {
+  if (!mSamples.getReadSpace())
+    return false;
+  mSamples.read(sample);
+  return true;
+}
+
+unsigned int Profiler::xruns() const { return mXruns.load(std::memory_order_acquire); }
+uint32_t Profiler::xrun_period() const { return mXrunPeriod.load(std::memory_order_relaxed); }
+unsigned int Profiler::dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+void Profiler::push(stage_t stage, unsigned int player, uint64_t nanos) {
+  if (!mSamples.getWriteSpace()) {
+    mDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  sample_t s;
+  s.period = mPeriod.load(std::memory_order_relaxed);
+  s.stage = static_cast<uint8_t>(stage);
+  s.player = static_cast<uint8_t>(std::min(player, 255u));
+  s.frames = mFrames;
+  s.nanos = static_cast<uint32_t>(std::min<uint64_t>(nanos, 0xffffffffull));
+  mSamples.write(s);
+}
+
+ProfileStats::ProfileStats() : mXruns(0), mBudget(0.0) {
+  mLastXrun.count = 0;
+  mLastXrun.period = mLastXrun.budget = mLastXrun.culprit_time = 0.0;
+}
+
+bool ProfileStats::update(Profiler * profiler) {
+  Profiler::sample_t sample;
+  while (profiler->read(sample)) {
+    mHistograms[stage_key_t(sample.stage, sample.player)].add(sample.nanos);
+    if (mRecent.empty() || mRecent.back().front().period != sample.period) {
+      mRecent.push_back(std::vector<Profiler::sample_t>());
+      if (mRecent.size() > RECENT_PERIODS)
+        mRecent.pop_front();
+    }
+    mRecent.back().push_back(sample);
+  }
+  if (!mRecent.empty() && profiler->sample_rate())
+    mBudget = 1e6 * static_cast<double>(mRecent.back().front().frames) / static_cast<double>(profiler->sample_rate());
+
+  const unsigned int xruns = profiler->xruns();
+  if (xruns == mXruns)
+    return false;
+  mXruns = xruns;
+  correlate_xrun(profiler);
+  return true;
+}
+
+std::vector<ProfileStats::stage_stats_t> ProfileStats::stats() const {
+  std::vector<stage_stats_t> stats;
+  for (std::map<stage_key_t, Histogram>::const_iterator it = mHistograms.begin(); it != mHistograms.end(); it++) {
+    if (!it->second.count())
+      continue;
+    stage_stats_t s;
+    s.name = key_name(it->first);
+    s.p50 = it->second.percentile(0.5) / 1000.0;
+    s.p99 = it->second.percentile(0.99) / 1000.0;
+    s.max = static_cast<double>(it->second.max()) / 1000.0;
+    s.count = it->second.count();
+    stats.push_back(s);
+  }
+  return stats;
+}
+
+void ProfileStats::reset() {
+  for (std::map<stage_key_t, Histogram>::iterator it = mHistograms.begin(); it != mHistograms.end(); it++)
+    it->second.clear();
+}
+
+std::string ProfileStats::key_name(const stage_key_t& key) {
+  const Profiler::stage_t stage = static_cast<Profiler::stage_t>(key.first);
+  if (stage != Profiler::RENDER && stage != Profiler::EQ)
+    return Profiler::stage_name(stage);
+  std::stringstream name;
+  name << Profiler::stage_name(stage) << "/" << key.second;
+  return name.str();
+}
+
+void ProfileStats::correlate_xrun(Profiler * profiler) {
+  mLastXrun.count = mXruns;
+  mLastXrun.period = mLastXrun.budget = mLastXrun.culprit_time = 0.0;
+  mLastXrun.culprit.clear();
+
+  //the late period is the one running at the notification or one just before it, take the slowest
+  const uint32_t at = profiler->xrun_period();
+  const std::vector<Profiler::sample_t> * worst = NULL;
+  uint32_t worst_nanos = 0;
+  for (std::size_t i = 0; i < mRecent.size(); i++) {
+    const std::vector<Profiler::sample_t>& period = mRecent[i];
+    const uint32_t index = period.front().period;
+    if (index > at || at - index > XRUN_LOOKBACK)
+      continue;
+    for (std::size_t j = 0; j < period.size(); j++) {
+      if (period[j].stage == Profiler::PERIOD && (!worst || period[j].nanos > worst_nanos)) {
+        worst = &period;
+        worst_nanos = period[j].nanos;
+      }
+    }
+  }
+  if (!worst)
+    return;
+
+  mLastXrun.period = static_cast<double>(worst_nanos) / 1000.0;
+  mLastXrun.budget = mBudget;
+
+  //the culprit is the stage that went furthest over its median
+  double worst_excess = -1.0;
+  for (std::size_t j = 0; j < worst->size(); j++) {
+    const Profiler::sample_t& s = (*worst)[j];
+    if (s.stage == Profiler::PERIOD)
+      continue;
+    const stage_key_t key(s.stage, s.player);
+    const double excess = static_cast<double>(s.nanos) - mHistograms[key].percentile(0.5);
+    if (excess > worst_excess) {
+      worst_excess = excess;
+      mLastXrun.culprit = key_name(key);
+      mLastXrun.culprit_time = static_cast<double>(s.nanos) / 1000.0;
+    }
+  }
+}
+
+ProfileStats::Histogram::Histogram() {
+  clear();
+}
+
+void ProfileStats::Histogram::add(uint32_t nanos) {
+  mBuckets[bucket(nanos)]++;
+  mCount++;
+  mMax = std::max(mMax, nanos);
+}
+
+void ProfileStats::Histogram::clear() {
+  std::fill(mBuckets, mBuckets + BUCKETS, 0ul);
+  mCount = 0;
+  mMax = 0;
+}
+
+double ProfileStats::Histogram::percentile(double p) const {
+  if (!mCount)
+    return 0.0;
+  const unsigned long rank = static_cast<unsigned long>(p * static_cast<double>(mCount - 1)) + 1;
+  unsigned long seen = 0;
+  for (unsigned int i = 0; i < BUCKETS; i++) {
+    seen += mBuckets[i];
+    if (seen >= rank)
+      return std::min(bucket_value(i), static_cast<double>(mMax));
+  }
+  return mMax;
+}
+
+unsigned int ProfileStats::Histogram::bucket(uint32_t nanos) {
+  //values below SUB_BUCKETS get a bucket each, above that the top 3 bits after the leading one pick the sub bucket
+  if (nanos < SUB_BUCKETS)
+    return nanos;
+  const unsigned int log = 31 - __builtin_clz(nanos);
+  const unsigned int sub = (nanos >> (log - 3)) & (SUB_BUCKETS - 1);
+  return std::min<unsigned int>((log - 2) * SUB_BUCKETS + sub, BUCKETS - 1);
+}
+
+double ProfileStats::Histogram::bucket_value(unsigned int bucket) {
+  //the middle of the bucket
+  if (bucket < SUB_BUCKETS)
+    return bucket;
+  const unsigned int log = bucket / SUB_BUCKETS + 2;
+  const unsigned int sub = bucket % SUB_BUCKETS;
+  const double low = static_cast<double>(static_cast<uint64_t>(SUB_BUCKETS + sub) << (log - 3));
+  return low + 0.5 * static_cast<double>(1ull << (log - 3));
+}
@@ -0,0 +1,140 @@
+#ifndef DATAJOCKEY_PROFILER_HPP
+#define DATAJOCKEY_PROFILER_HPP
+
+#include "jackringbuffer.hpp"
+#include <atomic>
+#include <vector>
+#include <map>
+#include <deque>
+#include <string>
+#include <stdint.h>
+
+namespace djaudio {
+  //times the stages of each period in the audio thread and hands the samples to another thread through a ring,
+  //the render and eq stages are per player and may be timed from the worker threads
+  class Profiler {
+    public:
+      enum stage_t {
+        SCHEDULE, //executing scheduled and next beat commands
+        RENDER, //a player's blocks, per player
+        EQ, //a player's eq plugin, per player
+        MIX, //players' output into the main, cue and send buses, and the master volume
+        SENDS, //the send effects
+        PERIOD, //the whole period
+        STAGE_COUNT
+      };
+      static const char * stage_name(stage_t stage);
+
+      struct sample_t {
+        uint32_t period;
+        uint8_t stage;
+        uint8_t player;
+        uint16_t frames;
+        uint32_t nanos;
+      };
+
+      Profiler();
+
+      //not from the audio thread
+      void setup(unsigned int sample_rate, unsigned int players);
+      unsigned int sample_rate() const { return mSampleRate; }
+
+      //monotonic nanoseconds
+      static uint64_t now();
+
+      //audio thread
+      void begin_period(unsigned int frames);
+      //the time since start, or time spent over several parts of the period
+      void record(stage_t stage, uint64_t start);
+      void record_nanos(stage_t stage, uint64_t nanos);
+      //time spent for a player, adds up over the period, safe from the player's worker thread
+      void add_player(stage_t stage, unsigned int player, uint64_t start);
+      void end_period();
+
+      //jack's xrun notification, from jack's thread
+      void xrun();
+
+      //the consumer thread, returns false if there are no samples left
+      bool read(sample_t& sample);
+      unsigned int xruns() const;
+      //the period that was running at the last xrun
+      uint32_t xrun_period() const;
+      //samples that didn't fit in the ring
+      unsigned int dropped() const;
+    private:
+      void push(stage_t stage, unsigned int player, uint64_t nanos);
+
+      JackCpp::RingBuffer<sample_t> mSamples;
+      unsigned int mSampleRate;
+      std::vector<uint64_t> mPlayerNanos[STAGE_COUNT];
+      uint64_t mPeriodStart;
+      uint16_t mFrames;
+      std::atomic<uint32_t> mPeriod;
+      std::atomic<unsigned int> mXruns;
+      std::atomic<uint32_t> mXrunPeriod;
+      std::atomic<unsigned int> mDropped;
+  };
+
+  //aggregates profiler samples into per stage histograms and, on an xrun, finds the stage that blew the deadline,
+  //for the consumer thread
+  class ProfileStats {
+    public:
+      struct stage_stats_t {
+        std::string name; //"render/0", "period"..
+        double p50; //microseconds
+        double p99;
+        double max;
+        unsigned long count;
+      };
+      struct xrun_t {
+        unsigned int count; //xruns so far
+        double period; //microseconds the worst period near the xrun took
+        double budget; //microseconds the period had
+        std::string culprit; //the stage furthest over its usual time in that period
+        double culprit_time;
+      };
+
+      ProfileStats();
+
+      //drain the profiler, returns true if there was an xrun since the last update
+      bool update(Profiler * profiler);
+      //the stats since the last reset, in stage order
+      std::vector<stage_stats_t> stats() const;
+      void reset();
+      const xrun_t& last_xrun() const { return mLastXrun; }
+      //microseconds the most recent period had
+      double period_budget() const { return mBudget; }
+    private:
+      class Histogram {
+        public:
+          Histogram();
+          void add(uint32_t nanos);
+          void clear();
+          unsigned long count() const { return mCount; }
+          //nanoseconds
+          double percentile(double p) const;
+          uint32_t max() const { return mMax; }
+        private:
+          //log2 buckets split in 8 linear sub buckets, about 12% resolution
+          enum { SUB_BUCKETS = 8, BUCKETS = 32 * SUB_BUCKETS };
+          static unsigned int bucket(uint32_t nanos);
+          static double bucket_value(unsigned int bucket);
+          unsigned long mBuckets[BUCKETS];
+          unsigned long mCount;
+          uint32_t mMax;
+      };
+
+      typedef std::pair<int, int> stage_key_t; //stage, player
+      static std::string key_name(const stage_key_t& key);
+      void correlate_xrun(Profiler * profiler);
+
+      std::map<stage_key_t, Histogram> mHistograms;
+      //the most recent periods' samples, to look back at when there is an xrun
+      std::deque<std::vector<Profiler::sample_t> > mRecent;
+      unsigned int mXruns;
+      xrun_t mLastXrun;
+      double mBudget;
+  };
+}
+
+#endif
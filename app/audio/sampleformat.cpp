@@ -0,0 +1,208 @@
+#include "sampleformat.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#ifdef DJ_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+  float half_to_float_scalar(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+    uint32_t bits;
+
+    if (exponent == 0x1f) {
+      //inf or nan
+      bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent == 0) {
+      if (mantissa == 0) {
+        bits = sign;
+      } else {
+        //denormal, renormalize it
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400)) {
+          mantissa <<= 1;
+          exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+      }
+    } else {
+      bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+
+  uint16_t float_to_half_scalar(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+      return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 0x1f)
+      return sign | 0x7c00;
+    if (exponent <= 0) {
+      //denormal or zero
+      if (exponent < -10)
+        return sign;
+      mantissa |= 0x800000;
+      const int shift = 14 - exponent;
+      uint32_t h = mantissa >> shift;
+      //round to nearest even
+      const uint32_t rem = mantissa & ((1u << shift) - 1);
+      const uint32_t halfway = 1u << (shift - 1);
+      if (rem > halfway || (rem == halfway && (h & 1)))
+        h++;
+      return sign | static_cast<uint16_t>(h);
+    }
+
+    uint32_t h = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t rem = mantissa & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+      h++; //may carry into the exponent, which is what we want
+    return sign | static_cast<uint16_t>(h);
+  }
+
+#ifdef DJ_SIMD_X86
+  DJ_TARGET_SSE2
+  float abs_peak_sse2(const float * src, unsigned int count) {
+    //clearing the sign bit gives the absolute value
+    const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peak0 = _mm_setzero_ps();
+    __m128 peak1 = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      peak0 = _mm_max_ps(peak0, _mm_and_ps(mask, _mm_loadu_ps(src + i)));
+      peak1 = _mm_max_ps(peak1, _mm_and_ps(mask, _mm_loadu_ps(src + i + 4)));
+    }
+    float p[4];
+    _mm_storeu_ps(p, _mm_max_ps(peak0, peak1));
+    float peak = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+    for (; i < count; i++)
+      peak = std::max(peak, fabsf(src[i]));
+    return peak;
+  }
+
+  DJ_TARGET_AVX2
+  float abs_peak_avx2(const float * src, unsigned int count) {
+    const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak0 = _mm256_setzero_ps();
+    __m256 peak1 = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      peak0 = _mm256_max_ps(peak0, _mm256_and_ps(mask, _mm256_loadu_ps(src + i)));
+      peak1 = _mm256_max_ps(peak1, _mm256_and_ps(mask, _mm256_loadu_ps(src + i + 8)));
+    }
+    float p[8];
+    _mm256_storeu_ps(p, _mm256_max_ps(peak0, peak1));
+    float peak = 0.0f;
+    for (unsigned int k = 0; k < 8; k++)
+      peak = std::max(peak, p[k]);
+    for (; i < count; i++)
+      peak = std::max(peak, fabsf(src[i]));
+    return peak;
+  }
+
+  DJ_TARGET_F16C
+  void half_to_float_f16c(const uint16_t * src, float * dest, unsigned int count) {
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+      _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(h));
+    }
+    for (; i < count; i++)
+      dest[i] = half_to_float_scalar(src[i]);
+  }
+
+  DJ_TARGET_F16C
+  void float_to_half_f16c(const float * src, uint16_t * dest, unsigned int count) {
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), h);
+    }
+    for (; i < count; i++)
+      dest[i] = float_to_half_scalar(src[i]);
+  }
+#endif
+}
+
+namespace djaudio {
+  sample_storage_t sample_storage_from_string(const QString& name, sample_storage_t default_storage) {
+    if (name == "float")
+      return STORAGE_FLOAT;
+    if (name == "int16")
+      return STORAGE_INT16;
+    if (name == "half")
+      return STORAGE_HALF;
+    return default_storage;
+  }
+
+  float abs_peak(const float * src, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::avx2())
+      return abs_peak_avx2(src, count);
+    if (simd::sse2())
+      return abs_peak_sse2(src, count);
+#endif
+    float peak = 0.0f;
+    for (unsigned int i = 0; i < count; i++)
+      peak = std::max(peak, fabsf(src[i]));
+    return peak;
+  }
+
+  float int16_scale(float peak) {
+    if (peak <= 0.0f)
+      return 1.0f / 32767.0f;
+    return peak / 32767.0f;
+  }
+
+  void int16_to_float(const int16_t * src, float * dest, unsigned int count, float scale) {
+    //simple enough for the compiler to vectorize
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] = static_cast<float>(src[i]) * scale;
+  }
+
+  void float_to_int16(const float * src, int16_t * dest, unsigned int count, float scale) {
+    const float mul = 1.0f / scale;
+    for (unsigned int i = 0; i < count; i++) {
+      float v = roundf(src[i] * mul);
+      if (v > 32767.0f)
+        v = 32767.0f;
+      else if (v < -32767.0f)
+        v = -32767.0f;
+      dest[i] = static_cast<int16_t>(v);
+    }
+  }
+
+  void half_to_float(const uint16_t * src, float * dest, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::f16c()) {
+      half_to_float_f16c(src, dest, count);
+      return;
+    }
+#endif
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] = half_to_float_scalar(src[i]);
+  }
+
+  void float_to_half(const float * src, uint16_t * dest, unsigned int count) {
+#ifdef DJ_SIMD_X86
+    if (simd::f16c()) {
+      float_to_half_f16c(src, dest, count);
+      return;
+    }
+#endif
+    for (unsigned int i = 0; i < count; i++)
+      dest[i] = float_to_half_scalar(src[i]);
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef DATAJOCKEY_SAMPLEFORMAT_HPP
+#define DATAJOCKEY_SAMPLEFORMAT_HPP
+
+#include <QString>
+#include <stdint.h>
+
+namespace djaudio {
+  //how loaded audio is kept in memory
+  enum sample_storage_t {
+    STORAGE_FLOAT,
+    STORAGE_INT16, //16 bit integers with a scale factor per block of frames
+    STORAGE_HALF //ieee half precision floats
+  };
+
+  //parse a storage name, "float", "int16" or "half", returns the default for anything else
+  sample_storage_t sample_storage_from_string(const QString& name, sample_storage_t default_storage = STORAGE_FLOAT);
+
+  //the largest absolute value in src
+  float abs_peak(const float * src, unsigned int count);
+
+  //the scale to use when converting a block with the given peak absolute value to int16
+  float int16_scale(float peak);
+
+  //dest[i] = src[i] * scale
+  void int16_to_float(const int16_t * src, float * dest, unsigned int count, float scale);
+  //dest[i] = round(src[i] / scale), expects values within the range given by the scale
+  void float_to_int16(const float * src, int16_t * dest, unsigned int count, float scale);
+
+  //the half conversions use f16c when the cpu has it
+  void half_to_float(const uint16_t * src, float * dest, unsigned int count);
+  void float_to_half(const float * src, uint16_t * dest, unsigned int count);
+}
+
+#endif
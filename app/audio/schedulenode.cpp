@@ -3,7 +3,6 @@
 using namespace djaudio;
 
 ScheduleNode::ScheduleNode(Command * c, const TimePoint& t){
-   next = prev = NULL;
    command = c;
    time = t;
 }
@@ -5,12 +5,11 @@
 #include "timepoint.hpp"
 
 namespace djaudio {
+  //a command and when to run it, the scheduler keeps its own sorted array of these
   class ScheduleNode {
     public:
       ScheduleNode(Command * c, const TimePoint& t);
       ~ScheduleNode();
-      ScheduleNode * next;
-      ScheduleNode * prev;
       Command * command;
       TimePoint time;
   };
@@ -1,6 +1,10 @@
 #include "scheduler.hpp"
 #include "timepoint.hpp"
+#include "commandpool.hpp"
 #include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 using std::cout;
 using std::cerr;
@@ -8,42 +12,115 @@ using std::endl;
 
 using namespace djaudio;
 
+//commands the in queue holds, the audio thread takes up to 1024 every period
+//so it only fills if audio isn't running or something floods it
+#define COMMAND_QUEUE_SIZE 4096
+//schedule key resolution within a beat
+#define SCHEDULE_TICKS_PER_BEAT 65536
+
+namespace {
+  void report_count(const char * what, unsigned int count, unsigned int& reported) {
+    if (count != reported) {
+      cerr << what << ": " << (count - reported) << endl;
+      reported = count;
+    }
+  }
+}
+
 Scheduler::Scheduler() : 
-   mCommandsIn(1024), mCommandsOut(1024)
+   mCommandsIn(COMMAND_QUEUE_SIZE), mCommandsOut(1024),
+   mInOverflows(0), mOutDropped(0),
+   mInOverflowsReported(0), mOutDroppedReported(0)
 {
-   mSchedule = NULL; 
+   mScheduleHead.key = 0;
+   mScheduleHead.id = 0;
+   mScheduleHead.command = NULL;
+   mScheduleHead.levels = SCHEDULE_LEVELS;
+   for (unsigned int l = 0; l < SCHEDULE_LEVELS; l++)
+      mScheduleHead.next[l] = NULL;
+   mScheduleCursor = NULL;
+   mLevelSeed = 2463534242u;
    mNodeIndex = 0;
+   mCommandsOutPending.reserve(1024);
+   mCommandsDue.reserve(1024);
+   mPeriodStart = mPeriodFrames = 0;
+   mFrameClock = NULL;
+   mFrameClockData = NULL;
+   //set the command pool up now rather than on the first command
+   mPoolOverflowsReported = CommandPool::instance()->overflows();
    invalidate_schedule_pointers();
 }
 
-void Scheduler::execute(Command * cmd){
-   QMutexLocker lock(&mExecuteMutex);
+void Scheduler::frame_clock(frame_clock_t clock, void * user_data) {
+   mFrameClock = clock;
+   mFrameClockData = user_data;
+}
 
-   if(mCommandsIn.getWriteSpace())
-      mCommandsIn.write(cmd);
-   else {
-      cerr << "no space in command queue, deleting command" << endl;
-      delete cmd;
-   }
+void Scheduler::period_start(unsigned int frame_time, unsigned int frames) {
+   mPeriodStart = frame_time;
+   mPeriodFrames = frames;
+}
+
+bool Scheduler::execute(Command * cmd){
+   if (mFrameClock && !cmd->frame_stamped())
+      cmd->frame_stamp(mFrameClock(mFrameClockData));
+   if (mCommandsIn.push(cmd))
+      return true;
+
+   //never wait on the audio thread, the caller may be the gui
+   mInOverflows.fetch_add(1, std::memory_order_relaxed);
+   delete cmd;
+   return false;
+}
+
+Scheduler::schedule_key_t Scheduler::schedule_key(const TimePoint& time) {
+   //XXX like the TimePoint comparisons, this ignores beat_type and assumes x/4
+   const schedule_key_t beats = static_cast<schedule_key_t>(time.bar()) * time.beats_per_bar() + time.beat();
+   return beats * SCHEDULE_TICKS_PER_BEAT + static_cast<schedule_key_t>(floor(time.pos_in_beat() * SCHEDULE_TICKS_PER_BEAT + 0.5));
 }
 
 Scheduler::node_id_t Scheduler::schedule(const TimePoint &time, Command * cmd){
    node_id_t index = mNodeIndex++;
-   ScheduleNode * node = new ScheduleNode(cmd, time);;
-   AddCommand * addCmd = new AddCommand(this, node);
-   execute(addCmd);
-   mNodeMap[index] = node;
+   if (time.type() != TimePoint::BEAT_BAR || !time.valid()) {
+      //the schedule runs against the transport, which counts beats
+      cerr << "can only schedule at a valid bar and beat, deleting command" << endl;
+      delete cmd;
+      return index;
+   }
+
+   schedule_node_t * node = new schedule_node_t;
+   node->key = schedule_key(time);
+   node->id = index;
+   node->command = cmd;
+   //a quarter of the nodes on each level go up to the next
+   node->levels = 1;
+   while (node->levels < SCHEDULE_LEVELS) {
+      mLevelSeed ^= mLevelSeed << 13;
+      mLevelSeed ^= mLevelSeed >> 17;
+      mLevelSeed ^= mLevelSeed << 5;
+      if (mLevelSeed & 3)
+         break;
+      node->levels++;
+   }
+   for (unsigned int l = 0; l < node->levels; l++)
+      node->next[l] = NULL;
+
+   const schedule_key_t key = node->key;
+   if (!execute(new AddCommand(this, node)))
+      return index;
+   mNodeMap[index] = key;
    //return the index of this node
    return index;
 }
 
 void Scheduler::remove(Scheduler::node_id_t id){
    //find the node
-   std::map<node_id_t, ScheduleNode *>::iterator it;
+   std::map<node_id_t, schedule_key_t>::iterator it;
    it = mNodeMap.find(id);
    if(it != mNodeMap.end()){
-      //execute a remove command
-      execute( new RemoveCommand(this, it->second));
+      //execute a remove command, if it couldn't be queued the node is still scheduled
+      if (!execute( new RemoveCommand(this, id, it->second)))
+         return;
       //remove the node from the map
       mNodeMap.erase(it);
    }
@@ -53,89 +130,55 @@ void Scheduler::clear(){
    //XXX not implemented
 }
 
-void Scheduler::execute_schedule(const Transport& transport){
+void Scheduler::execute_schedule(const Transport& transport, unsigned int frame){
    //while there are commands to be executed
    //execute them, noteing the time, 
    //and write them to the out buffer
-   while(mCommandsIn.getReadSpace()){
-      Command * cmd;
-      mCommandsIn.read(cmd);
+   //hand back what didn't fit last time
+   flush_pending();
+   //take new commands while we can hold them, otherwise they wait in the in queue
+   Command * cmd;
+   while(mCommandsDue.size() < mCommandsDue.capacity() && mCommandsIn.pop(cmd)){
       //shouldn't ever be null huh?
       if (cmd)
-        execute_immediately(cmd, transport);
+         mCommandsDue.push_back(cmd);
+   }
+   //run the ones that are due, in the order they came in, while we can hand them back
+   std::size_t waiting = 0;
+   for (std::size_t i = 0; i < mCommandsDue.size(); i++) {
+      cmd = mCommandsDue[i];
+      if (command_frame(cmd) <= frame && mCommandsOutPending.empty() && mCommandsOut.getWriteSpace())
+         execute_immediately(cmd, transport);
+      else
+         mCommandsDue[waiting++] = cmd;
    }
+   mCommandsDue.resize(waiting);
+
    //actually eval the scheuldule
-   if(mSchedule == NULL)
+   const TimePoint& position = transport.position();
+   if (!mScheduleHead.next[0] || !position.valid() || position.type() != TimePoint::BEAT_BAR)
       return;
-   if(mScheduleCur == NULL)
-      mScheduleCur = mSchedule;
-
-   //backtrack, if we have a valid last time, we go to the
-   //node just past the last time
-   //otherwise we go to the node closest to the front that
-   //has time >= transport.position()
-   if(mLastScheduledTime.valid()){
-      //here we are concerned with anything that has a timepoint
-      //larger than the last time and less than or equal to the 
-      //transport time
-
-      //seek back in case we have new nodes that are valid
-      while(mScheduleCur->prev != NULL && 
-            mScheduleCur->prev->time > mLastScheduledTime){
-         mScheduleCur = mScheduleCur->prev;
-      }
-      //seek forward until our time is in range
-      while(mScheduleCur->time <= mLastScheduledTime && mScheduleCur->next != NULL)
-         mScheduleCur = mScheduleCur->next;
-
-      if(mScheduleCur->time > mLastScheduledTime &&
-            mScheduleCur->time <= transport.position()){
-         //iterate through the schedule, executing as we go
-         //until our next node is either null, or has a time point
-         //greater than the transport position
-         while(true){
-            //execute
-            mScheduleCur->command->execute(transport);
-#ifdef DEBUG
-            cout << "executing: " << mScheduleCur->time.bar() << " : " <<
-               mScheduleCur->time.beat() << endl;
-#endif
-            //advance or break
-            if(mScheduleCur->next == NULL ||
-                  mScheduleCur->next->time > transport.position()){
-               break;
-            } else
-               mScheduleCur = mScheduleCur->next;
-         }
-      }
-   } else {
-      //here we only care about stuff that is scheduled exactly at the
-      //transport time
+   const schedule_key_t now = schedule_key(position);
 
-      //seek back
-      while(mScheduleCur->prev != NULL && 
-            mScheduleCur->prev->time >= transport.position()){
-         mScheduleCur = mScheduleCur->prev;
+   if (mLastScheduledValid && now >= mLastScheduledKey) {
+      //everything after the last time up to and including now, the cursor is already at the first of them
+      while (mScheduleCursor && mScheduleCursor->key <= now) {
+         mScheduleCursor->command->execute(transport);
+         mScheduleCursor = mScheduleCursor->next[0];
       }
-      //seek forward until our time is in range
-      while(mScheduleCur->time < transport.position() && mScheduleCur->next != NULL)
-         mScheduleCur = mScheduleCur->next;
-
-      //execute everything at the time of the transport
-      while(mScheduleCur->time == transport.position()){
-         mScheduleCur->command->execute(transport);
-#ifdef DEBUG
-         cout << "executing: " << mScheduleCur->time.bar() << " : " <<
-            mScheduleCur->time.beat() << endl;
-#endif
-         if(mScheduleCur->next == NULL)
-            break;
-         else
-            mScheduleCur = mScheduleCur->next;
+   } else {
+      //we've jumped, only run what is scheduled exactly at the transport time
+      schedule_node_t * before[SCHEDULE_LEVELS];
+      find(now, false, before);
+      mScheduleCursor = before[0]->next[0];
+      while (mScheduleCursor && mScheduleCursor->key == now) {
+         mScheduleCursor->command->execute(transport);
+         mScheduleCursor = mScheduleCursor->next[0];
       }
    }
    //store the current time as the 'last time' for next time we execute_schedule
-   mLastScheduledTime = transport.position();
+   mLastScheduledKey = now;
+   mLastScheduledValid = true;
 }
 
 void Scheduler::execute_done_actions(){
@@ -153,19 +196,55 @@ void Scheduler::execute_done_actions(){
             mCommandsComplete << cmd;
       }
    }
+
+   report_count("command pool exhausted, commands allocated from the heap",
+         CommandPool::instance()->overflows(), mPoolOverflowsReported);
+   report_count("command queue full, commands dropped",
+         mInOverflows.load(std::memory_order_relaxed), mInOverflowsReported);
+   report_count("command done queue full, commands dropped",
+         mOutDropped.load(std::memory_order_relaxed), mOutDroppedReported);
 }
 
 void Scheduler::invalidate_schedule_pointers(){
-   mScheduleCur = NULL;
-   mLastScheduledTime.invalidate();
+   mLastScheduledValid = false;
 }
 
 void Scheduler::execute_immediately(Command * cmd, const Transport& transport) {
   cmd->execute(transport);
   cmd->time_executed(transport.position());
-  //XXX what if there is no write space?
-  if(mCommandsOut.getWriteSpace())
+  //keep the order, so nothing goes straight out while others are pending
+  if (mCommandsOutPending.empty() && mCommandsOut.getWriteSpace())
     mCommandsOut.write(cmd);
+  else if (mCommandsOutPending.size() < mCommandsOutPending.capacity())
+    mCommandsOutPending.push_back(cmd);
+  else
+    mOutDropped.fetch_add(1, std::memory_order_relaxed); //deleting here isn't realtime safe, so it leaks
+}
+
+unsigned int Scheduler::next_command_frame(unsigned int frame) const {
+   unsigned int next = std::numeric_limits<unsigned int>::max();
+   for (std::size_t i = 0; i < mCommandsDue.size(); i++) {
+      const unsigned int due = command_frame(mCommandsDue[i]);
+      if (due > frame)
+         next = std::min(next, due);
+   }
+   return next;
+}
+
+unsigned int Scheduler::command_frame(const Command * cmd) const {
+   if (!cmd->frame_stamped() || mPeriodFrames == 0)
+      return 0;
+   //the clock wraps, so take the difference as signed, late commands run right away
+   const int offset = static_cast<int>(cmd->frame_stamp() + mPeriodFrames - mPeriodStart);
+   return offset < 0 ? 0 : static_cast<unsigned int>(offset);
+}
+
+void Scheduler::flush_pending() {
+  size_t count = 0;
+  while (count < mCommandsOutPending.size() && mCommandsOut.getWriteSpace())
+    mCommandsOut.write(mCommandsOutPending[count++]);
+  if (count)
+    mCommandsOutPending.erase(mCommandsOutPending.begin(), mCommandsOutPending.begin() + count);
 }
 
 Command * Scheduler::pop_complete_command() {
@@ -174,53 +253,52 @@ Command * Scheduler::pop_complete_command() {
    return mCommandsComplete.takeFirst();
 }
 
-void Scheduler::add(ScheduleNode * node){
-   //if this is the first we set the schedule to this node
-   if(mSchedule == NULL)
-      mSchedule = node;
-   else if (mSchedule->time > node->time){
-      //if the first node has a later time than this new node
-      //place this new node at the front
-      node->next = mSchedule;
-      mSchedule->prev = node;
-      mSchedule = node;
-   } else {
-      ScheduleNode * cur = mSchedule;
-      //find our place in the schedule
-      while(cur->next != NULL && cur->next->time < node->time)
-         cur = cur->next;
-      node->prev = cur;
-      node->next = cur->next;
-      cur->next = node;
-      //if there is a next node set its prev to us
-      if(node->next)
-         node->next->prev = node;
+void Scheduler::find(schedule_key_t key, bool after_equal, schedule_node_t ** before){
+   schedule_node_t * node = &mScheduleHead;
+   for (unsigned int l = SCHEDULE_LEVELS; l-- > 0; ) {
+      while (node->next[l] && (node->next[l]->key < key || (after_equal && node->next[l]->key == key)))
+         node = node->next[l];
+      before[l] = node;
    }
-#ifdef DEBUG
-   ScheduleNode * tmp = mSchedule;
-   cout << "node list: " << endl;
-   while(tmp != NULL){
-      cout << tmp->time.bar() << " : " <<
-         tmp->time.beat() << endl;
-      tmp = tmp->next;
+}
+
+void Scheduler::add(schedule_node_t * node){
+   //after anything at the same time so that entries at a time run in the order they were added
+   schedule_node_t * before[SCHEDULE_LEVELS];
+   find(node->key, true, before);
+   for (unsigned int l = 0; l < node->levels; l++) {
+      node->next[l] = before[l]->next[l];
+      before[l]->next[l] = node;
    }
-   cout << "end list" << endl;
+   //a node at or before the last key we ran has been passed like those around it and doesn't run until
+   //the transport comes back to it, a later one just in front of the cursor is the next due
+   if (node->next[0] == mScheduleCursor && !(mLastScheduledValid && node->key <= mLastScheduledKey))
+      mScheduleCursor = node;
+#ifdef DEBUG
+   cout << "schedule: " << endl;
+   for (schedule_node_t * n = mScheduleHead.next[0]; n; n = n->next[0])
+      cout << n->key << endl;
+   cout << "end schedule" << endl;
 #endif
 }
 
-void Scheduler::remove(ScheduleNode * node){
-   //if this is the first node then we need to update our head pointer
-   if(mSchedule == node)
-      mSchedule = node->next;
-   //if this is the current node, update the current node pointer
-   if(mScheduleCur == node)
-      mScheduleCur = node->prev;
-
-   //actually remove the node from the list
-   if(node->next)
-      node->next->prev = node->prev;
-   if(node->prev)
-      node->prev->next = node->next;
+Scheduler::schedule_node_t * Scheduler::remove(node_id_t id, schedule_key_t key){
+   schedule_node_t * before[SCHEDULE_LEVELS];
+   find(key, false, before);
+   schedule_node_t * node = before[0]->next[0];
+   while (node && node->key == key && node->id != id)
+      node = node->next[0];
+   if (!node || node->key != key)
+      return NULL;
+   //the nodes between before and node on each level are at the same key
+   for (unsigned int l = 0; l < node->levels; l++) {
+      while (before[l]->next[l] != node)
+         before[l] = before[l]->next[l];
+      before[l]->next[l] = node->next[l];
+   }
+   if (mScheduleCursor == node)
+      mScheduleCursor = node->next[0];
+   return node;
 }
 
 Scheduler::SchedulerCommand::SchedulerCommand(Scheduler * scheduler){
@@ -231,14 +309,24 @@ Scheduler * Scheduler::SchedulerCommand::scheduler() const {
    return mScheduler;
 }
 
-Scheduler::AddCommand::AddCommand(Scheduler * scheduler, ScheduleNode * node) : 
-   SchedulerCommand(scheduler)
+Scheduler::AddCommand::AddCommand(Scheduler * scheduler, schedule_node_t * node) : 
+   SchedulerCommand(scheduler),
+   mNode(node)
 {
-   mNode = node;
+}
+
+Scheduler::AddCommand::~AddCommand(){
+   //never linked in, the command was dropped
+   if (mNode) {
+      delete mNode->command;
+      delete mNode;
+   }
 }
 
 void Scheduler::AddCommand::execute(const Transport& /*transport*/){
+   //the schedule has it now
    scheduler()->add(mNode);
+   mNode = NULL;
 }
 
 bool Scheduler::AddCommand::store(CommandIOData& /*data*/) const{
@@ -246,14 +334,23 @@ bool Scheduler::AddCommand::store(CommandIOData& /*data*/) const{
    return false;
 }
 
-Scheduler::RemoveCommand::RemoveCommand(Scheduler * scheduler, ScheduleNode * node) :
-   SchedulerCommand(scheduler)
+Scheduler::RemoveCommand::RemoveCommand(Scheduler * scheduler, node_id_t id, schedule_key_t key) :
+   SchedulerCommand(scheduler),
+   mId(id),
+   mKey(key),
+   mRemoved(NULL)
 {
-   mNode = node;
+}
+
+Scheduler::RemoveCommand::~RemoveCommand(){
+   if (mRemoved) {
+      delete mRemoved->command;
+      delete mRemoved;
+   }
 }
 
 void Scheduler::RemoveCommand::execute(const Transport& /*transport*/){
-   scheduler()->remove(mNode);
+   mRemoved = scheduler()->remove(mId, mKey);
 }
 
 bool Scheduler::RemoveCommand::store(CommandIOData& /*data*/) const{
@@ -3,39 +3,78 @@
 
 #include "command.hpp"
 #include "transport.hpp"
-#include "schedulenode.hpp"
+#include "mpscqueue.hpp"
 #include <jackringbuffer.hpp>
 #include <map>
-#include <QMutex>
-#include <QMutexLocker>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
 #include <QList>
 
 namespace djaudio {
   class Scheduler {
     public:
       typedef unsigned long node_id_t;
+      //schedule times as integers, ticks since bar 0 beat 0, so the audio thread compares integers
+      typedef int64_t schedule_key_t;
+      static schedule_key_t schedule_key(const TimePoint& time);
     private:
-      JackCpp::RingBuffer<Command *> mCommandsIn;
+      //a quarter of the nodes at a level are on the next, enough levels for millions of nodes
+      static const unsigned int SCHEDULE_LEVELS = 12;
+      //the schedule is a skip list so the audio thread adds and removes in O(log n) without allocating,
+      //nodes are made by the thread that schedules, the audio thread only links them in and out
+      struct schedule_node_t {
+        schedule_key_t key;
+        node_id_t id;
+        Command * command;
+        unsigned int levels;
+        schedule_node_t * next[SCHEDULE_LEVELS];
+      };
+
+      //any thread can execute a command, so the in queue has many producers
+      MPSCQueue<Command *> mCommandsIn;
       JackCpp::RingBuffer<Command *> mCommandsOut;
+      //commands that didn't fit in mCommandsOut, only touched by the audio thread
+      std::vector<Command *> mCommandsOutPending;
+      //commands taken from mCommandsIn that are waiting for their frame, audio thread
+      std::vector<Command *> mCommandsDue;
+      //the frame time of the first frame of the current period and its length
+      unsigned int mPeriodStart;
+      unsigned int mPeriodFrames;
       QList<Command *> mCommandsComplete;
       class AddCommand;
-      //this is the main schedule, relative to the transport
-      ScheduleNode * mSchedule;
-      //a pointer to the [guessed] current location in the schedule
-      ScheduleNode * mScheduleCur;
+      //this is the main schedule, relative to the transport, sorted by key then by the order added
+      //only touched by the audio thread, the head is before the first node on every level
+      schedule_node_t mScheduleHead;
+      //the next node due, everything before it is at or before the last key we ran, NULL at the end
+      schedule_node_t * mScheduleCursor;
       //this is is the last spot that the schedule was run
       //it can be invalidated if we jump around in the transport
-      TimePoint mLastScheduledTime;
+      schedule_key_t mLastScheduledKey;
+      bool mLastScheduledValid;
       node_id_t mNodeIndex;
-      //this maps the index given by the schedule for a node to a pointer
-      //to the node itself
-      std::map<node_id_t, ScheduleNode *> mNodeMap;
-      //make sure that don't try to write to the command queue from more than one thread once
-      QMutex mExecuteMutex;
+      //this maps the index given by the schedule for a node to its key
+      std::map<node_id_t, schedule_key_t> mNodeMap;
+      //picks the levels of new nodes, only touched by the thread that schedules
+      uint32_t mLevelSeed;
+      //overflow counts, and the counts we last reported
+      std::atomic<unsigned int> mInOverflows;
+      std::atomic<unsigned int> mOutDropped;
+      unsigned int mInOverflowsReported;
+      unsigned int mOutDroppedReported;
+      unsigned int mPoolOverflowsReported;
     public:
+      typedef unsigned int (* frame_clock_t)(void * user_data);
       Scheduler();
       //this executes a command now, scheduler now owns this command
-      void execute(Command * cmd);
+      //safe to call from any number of threads at once and never blocks,
+      //if the queue is full the command is deleted and this returns false
+      bool execute(Command * cmd);
+      //execute stamps commands with this clock, jack_frame_time for instance, set it before anything executes
+      //with no clock commands run at the start of the next period
+      void frame_clock(frame_clock_t clock, void * user_data);
+      //called by the audio thread before the period is computed, with the clock time of its first frame
+      void period_start(unsigned int frame_time, unsigned int frames);
       //this schedules a command based on the main transport
       //returns an ID for this node
       node_id_t schedule(const TimePoint &time, Command * cmd);
@@ -43,9 +82,14 @@ namespace djaudio {
       void remove(node_id_t id);
       //this clears the schedule [as soon as possible]
       void clear();
-      //this is called by the audio callback
-      //it executes commands based on the schedule
-      void execute_schedule(const Transport& transport);
+      //this is called by the audio callback at the start of each block, frame is the block's offset in the period
+      //it executes commands based on the schedule, and the executed commands that are due by frame,
+      //a command stamped during the last period runs at the same offset in this one,
+      //a period late but without jitter
+      void execute_schedule(const Transport& transport, unsigned int frame = 0);
+      //the offset of the next waiting command after frame, so the block can end there
+      //a large number if there isn't one
+      unsigned int next_command_frame(unsigned int frame) const;
       //this is called back in the main thread, 
       //clearing the command out buffer and executing their done actions
       void execute_done_actions();
@@ -62,10 +106,19 @@ namespace djaudio {
 
       friend class AddCommand;
     private:
-      //adds a node to the schedule
-      void add(ScheduleNode * node);
-      //removes a node from the schedule
-      void remove(ScheduleNode * node);
+      //fills before with the last node on each level whose key is less than key, or at most key if after_equal
+      void find(schedule_key_t key, bool after_equal, schedule_node_t ** before);
+      //links a node into the schedule after any at the same key
+      void add(schedule_node_t * node);
+      //unlinks a node from the schedule and returns it, NULL if it isn't there
+      schedule_node_t * remove(node_id_t id, schedule_key_t key);
+      //move pending commands into mCommandsOut, audio thread only
+      void flush_pending();
+      //the offset in the current period that a command is due at, possibly past the period
+      unsigned int command_frame(const Command * cmd) const;
+
+      frame_clock_t mFrameClock;
+      void * mFrameClockData;
 
       class SchedulerCommand : public Command {
         public:
@@ -76,22 +129,28 @@ namespace djaudio {
           Scheduler * mScheduler;
       };
 
+      //owns the node and its command until it is linked in
       class AddCommand : public SchedulerCommand {
         public:
-          AddCommand(Scheduler * scheduler, ScheduleNode * node);
+          AddCommand(Scheduler * scheduler, schedule_node_t * node);
+          virtual ~AddCommand();
           virtual void execute(const Transport& transport);
           virtual bool store(CommandIOData& data) const;
         private:
-          ScheduleNode * mNode;
+          schedule_node_t * mNode;
       };
 
+      //deletes the removed node and command back out of the audio thread
       class RemoveCommand : public SchedulerCommand {
         public:
-          RemoveCommand(Scheduler * scheduler, ScheduleNode * node);
+          RemoveCommand(Scheduler * scheduler, node_id_t id, schedule_key_t key);
+          virtual ~RemoveCommand();
           virtual void execute(const Transport& transport);
           virtual bool store(CommandIOData& data) const;
         private:
-          ScheduleNode * mNode;
+          node_id_t mId;
+          schedule_key_t mKey;
+          schedule_node_t * mRemoved;
       };
 
   };
@@ -0,0 +1,39 @@
+#include "simd.hpp"
+
+#ifdef DJ_SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace {
+  struct cpu_features_t {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool f16c = false;
+
+    cpu_features_t() {
+#ifdef DJ_SIMD_X86
+      __builtin_cpu_init();
+      sse2 = __builtin_cpu_supports("sse2");
+      avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+      //f16c isn't in every compiler's feature list so ask cpuid directly
+      //it uses the avx register state so we require that the os supports avx too
+      unsigned int eax, ebx, ecx, edx;
+      if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        f16c = (ecx & bit_F16C) && __builtin_cpu_supports("avx");
+#endif
+    }
+  };
+
+  const cpu_features_t& cpu_features() {
+    static const cpu_features_t features;
+    return features;
+  }
+}
+
+namespace djaudio {
+  namespace simd {
+    bool sse2() { return cpu_features().sse2; }
+    bool avx2() { return cpu_features().avx2; }
+    bool f16c() { return cpu_features().f16c; }
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef DATAJOCKEY_SIMD_HPP
+#define DATAJOCKEY_SIMD_HPP
+
+//we build the x86 vector code with function level target attributes so that
+//the rest of the program doesn't require the instruction sets, the code paths
+//are picked at runtime based on what the cpu supports
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DJ_SIMD_X86 1
+#define DJ_TARGET_SSE2 __attribute__((target("sse2")))
+#define DJ_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define DJ_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+namespace djaudio {
+  namespace simd {
+    //runtime cpu feature detection, these are always false on non x86 builds
+    bool sse2();
+    //avx2 and fma
+    bool avx2();
+    //half precision float conversion
+    bool f16c();
+  }
+}
+
+#endif
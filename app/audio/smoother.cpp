@@ -0,0 +1,82 @@
+#include "smoother.hpp"
+#include "mix.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace djaudio;
+
+namespace {
+  //one pole smoothing stops once it is this close to the target
+  const float SETTLED_DISTANCE = 1e-5f;
+}
+
+Smoother::Smoother(mode_t mode, unsigned int length, float value) :
+  mMode(mode),
+  mLength(0),
+  mValue(value),
+  mTarget(value),
+  mStep(0.0f),
+  mRemaining(0),
+  mCoeff(0.0f)
+{
+  this->length(length);
+}
+
+void Smoother::mode(mode_t mode) {
+  mMode = mode;
+  update_step();
+}
+
+void Smoother::length(unsigned int l) {
+  mLength = l;
+  //about 99% of the way there after length frames
+  mCoeff = l ? static_cast<float>(exp(-4.6 / static_cast<double>(l))) : 0.0f;
+  update_step();
+}
+
+void Smoother::target(float value) {
+  if (value == mTarget)
+    return;
+  mTarget = value;
+  update_step();
+}
+
+void Smoother::jump(float value) {
+  mValue = mTarget = value;
+  mRemaining = 0;
+}
+
+void Smoother::fill(float * dest, unsigned int count) {
+  if (settled()) {
+    std::fill(dest, dest + count, mValue);
+    return;
+  }
+
+  if (mMode == LINEAR) {
+    const unsigned int ramp = std::min(count, mRemaining);
+    fill_ramp(dest, mValue, mStep, ramp);
+    mRemaining -= ramp;
+    mValue = mRemaining ? mValue + mStep * static_cast<float>(ramp) : mTarget;
+    if (ramp < count)
+      std::fill(dest + ramp, dest + count, mTarget);
+    //land exactly on the target
+    if (!mRemaining && ramp)
+      dest[ramp - 1] = mTarget;
+    return;
+  }
+
+  const float diff = mValue - mTarget;
+  fill_decay(dest, mTarget, diff, mCoeff, count);
+  const float left = diff * static_cast<float>(pow(static_cast<double>(mCoeff), static_cast<double>(count)));
+  mValue = fabsf(left) < SETTLED_DISTANCE ? mTarget : mTarget + left;
+}
+
+void Smoother::update_step() {
+  if (mLength == 0) {
+    mValue = mTarget;
+    mRemaining = 0;
+    return;
+  }
+  mRemaining = mLength;
+  mStep = (mTarget - mValue) / static_cast<float>(mLength);
+}
@@ -0,0 +1,49 @@
+#ifndef DJ_SMOOTHER_HPP
+#define DJ_SMOOTHER_HPP
+
+namespace djaudio {
+  //moves a parameter to a new value over time instead of stepping, so gain changes don't click,
+  //filling blocks of per frame values that the mix stages multiply by
+  class Smoother {
+    public:
+      enum mode_t {
+        LINEAR, //reach the target in length frames
+        ONE_POLE //exponential approach, covering most of the distance in length frames
+      };
+
+      Smoother(mode_t mode = LINEAR, unsigned int length = 0, float value = 0.0f);
+
+      void mode(mode_t mode);
+      mode_t mode() const { return mMode; }
+
+      //the ramp length in frames, 0 steps straight to the target
+      void length(unsigned int l);
+      unsigned int length() const { return mLength; }
+
+      //start moving toward value, it is fine to call this every block with the same value
+      void target(float value);
+      float target() const { return mTarget; }
+      //go straight to value
+      void jump(float value);
+
+      float value() const { return mValue; }
+      bool settled() const { return mValue == mTarget; }
+
+      //fill dest with the next count values and advance
+      void fill(float * dest, unsigned int count);
+    private:
+      void update_step();
+
+      mode_t mMode;
+      unsigned int mLength;
+      float mValue;
+      float mTarget;
+      //linear, the increment per frame and frames left
+      float mStep;
+      unsigned int mRemaining;
+      //one pole, the fraction of the distance left after each frame
+      float mCoeff;
+  };
+}
+
+#endif
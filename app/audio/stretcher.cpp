@@ -1,11 +1,14 @@
 #include "stretcher.hpp"
+#include <cmath>
+#include <cstring>
 
 namespace djaudio {
   Stretcher::Stretcher() :
     mFrame(0),
     mFrameSubsample(0.0),
     mSpeed(1.0),
-    mAudioBuffer(NULL) {
+    mAudioBuffer(NULL),
+    mStarved(false) {
     }
 
   Stretcher::~Stretcher() { }
@@ -102,6 +105,7 @@ namespace djaudio {
     }
 
     compute_frame(frame, mFrame, mFrameSubsample, last_frame, last_frame_subsamp);
+    check_starved();
   }
 
   void Stretcher::next(float * frame_buffer, unsigned int frames) {
@@ -113,8 +117,97 @@ namespace djaudio {
       next_frame(frame_buffer + i);
   }
 
+  void Stretcher::next_block(float ** buffers, unsigned int offset, unsigned int frames) {
+    float * left = buffers[0] + offset;
+    float * right = buffers[1] + offset;
+
+    if (!mAudioBuffer || mAudioBuffer->length() == 0) {
+      memset(left, 0, sizeof(float) * frames);
+      memset(right, 0, sizeof(float) * frames);
+      return;
+    }
+
+    const double step = speed();
+    //going backwards or standing still is rare, just do it frame by frame
+    if (step <= 0.0) {
+      float frame[2];
+      for (unsigned int i = 0; i < frames; i++) {
+        next_frame(frame);
+        left[i] = frame[0];
+        right[i] = frame[1];
+      }
+      return;
+    }
+
+    //the first frame we compute is one step past our current location
+    //figure out how many frames we can compute before we hit the last frame of the buffer
+    const unsigned int last = mAudioBuffer->length() - 1;
+    const double start = mFrameSubsample + step;
+    unsigned int valid = 0;
+    if (mFrame < last && static_cast<double>(last - mFrame) > start) {
+      const double count = ceil((static_cast<double>(last - mFrame) - start) / step);
+      valid = count >= static_cast<double>(frames) ? frames : static_cast<unsigned int>(count);
+    }
+
+    if (valid) {
+      const double start_floor = floor(start);
+      float * out[2] = { left, right };
+      compute_block(out, valid, mFrame + static_cast<unsigned int>(start_floor), start - start_floor, step);
+
+      const double end = mFrameSubsample + static_cast<double>(valid) * step;
+      const double end_floor = floor(end);
+      mFrame += static_cast<unsigned int>(end_floor);
+      mFrameSubsample = end - end_floor;
+      check_starved();
+    }
+
+    //past the end, output silence
+    if (valid < frames) {
+      mFrame = mAudioBuffer->length();
+      mFrameSubsample = 0.0;
+      memset(left + valid, 0, sizeof(float) * (frames - valid));
+      memset(right + valid, 0, sizeof(float) * (frames - valid));
+    }
+  }
+
   bool Stretcher::pitch_independent() const { return false; }
 
+  bool Stretcher::starved_reset() {
+    bool v = mStarved;
+    mStarved = false;
+    return v;
+  }
+
+  void Stretcher::check_starved() {
+    //the buffer may still be loading, if we've read up to where it has decoded we've output silence
+    const unsigned int decoded = mAudioBuffer->decoded_frames();
+    if (decoded < mAudioBuffer->length() && mFrame + 1 >= decoded)
+      mStarved = true;
+  }
+
+  void Stretcher::compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step) {
+    unsigned int last_index = index;
+    double last_index_subsample = index_subsample - step;
+    while (last_index_subsample < 0.0 && last_index > 0) {
+      last_index--;
+      last_index_subsample += 1.0;
+    }
+
+    float frame[2];
+    for (unsigned int i = 0; i < frames; i++) {
+      compute_frame(frame, index, index_subsample, last_index, last_index_subsample);
+      buffers[0][i] = frame[0];
+      buffers[1][i] = frame[1];
+
+      last_index = index;
+      last_index_subsample = index_subsample;
+      index_subsample += step;
+      const double whole = floor(index_subsample);
+      index += static_cast<unsigned int>(whole);
+      index_subsample -= whole;
+    }
+  }
+
 
   void Stretcher::audio_changed() { }
   void Stretcher::frame_updated() { }
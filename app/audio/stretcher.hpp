@@ -29,20 +29,32 @@ namespace djaudio {
 
       void next_frame(float * frame, double rate_offset = 1.0); 
       void next(float * frame_buffer, unsigned int frames);
+      //compute frames of stereo audio into the non interleaved buffers, starting at offset
+      //produces the same output as calling next_frame frames times
+      void next_block(float ** buffers, unsigned int offset, unsigned int frames);
 
       virtual bool pitch_independent() const;
 
+      //returns true if we've read past the decoded part of a buffer that is still loading since the last call
+      bool starved_reset();
+
     protected:
       virtual void audio_changed();
       virtual void frame_updated();
       virtual void speed_updated();
       virtual void compute_frame(float * frame, unsigned int new_index, double new_index_subsample, unsigned int last_index, double last_index_subsample) = 0;
+      //compute frames of audio, the first at index + index_subsample, each following frame step further along
+      //all the frames are guaranteed to be at least one frame from the end of the audio buffer
+      //by default this calls compute_frame for each frame
+      virtual void compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step);
 
     private:
+      void check_starved();
       unsigned int mFrame;
       double mFrameSubsample;
       double mSpeed;
       AudioBuffer * mAudioBuffer;
+      bool mStarved;
   };
 }
 
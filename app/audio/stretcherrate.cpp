@@ -1,10 +1,84 @@
 #include "stretcherrate.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#define DECODE_WINDOW_FRAMES 2048
 
 namespace djaudio {
+  StretcherRate::StretcherRate(interpolation_t mode) :
+    mInterpolation(mode),
+    mWindow(2 * DECODE_WINDOW_FRAMES, 0.0f)
+  { }
+
   StretcherRate::~StretcherRate() { }
 
+  void StretcherRate::interpolation(interpolation_t mode) { mInterpolation = mode; }
+  interpolation_t StretcherRate::interpolation() const { return mInterpolation; }
+
   void StretcherRate::compute_frame(float * frame, unsigned int new_index, double new_index_subsample, unsigned int /* last_index */, double /* last_index_subsample */) {
-    for (unsigned int i = 0; i < 2; i++)
-      frame[i] = audio_buffer()->sample(i, new_index, new_index_subsample);
+    float * out[2] = { frame, frame + 1 };
+    if (audio_buffer()->storage() != STORAGE_FLOAT)
+      compute_decoded(out, 1, new_index, new_index_subsample, 0.0);
+    else
+      interpolate_block(mInterpolation, source(), out, 1, new_index, new_index_subsample, 0.0);
+  }
+
+  void StretcherRate::compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step) {
+    if (audio_buffer()->storage() != STORAGE_FLOAT)
+      compute_decoded(buffers, frames, index, index_subsample, step);
+    else
+      interpolate_block(mInterpolation, source(), buffers, frames, index, index_subsample, step);
+  }
+
+  SampleSource StretcherRate::source() const {
+    const AudioBuffer * buffer = audio_buffer();
+    SampleSource s;
+    s.channel[0] = buffer->channel_data(0);
+    s.channel[1] = buffer->channel_data(buffer->channels() > 1 ? 1 : 0);
+    s.stride = buffer->stride();
+    s.frames = buffer->decoded_frames();
+    return s;
+  }
+
+  void StretcherRate::compute_decoded(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step) {
+    const AudioBuffer * buffer = audio_buffer();
+    const unsigned int before = interpolation_taps_before(mInterpolation);
+    const unsigned int after = interpolation_taps_after(mInterpolation);
+    const unsigned int right_channel = buffer->channels() > 1 ? 1 : 0;
+    float * window[2] = { &mWindow.front(), &mWindow.front() + DECODE_WINDOW_FRAMES };
+
+    //how many output frames fit in one window, leaving room for the taps and the partial frame at the start
+    unsigned int chunk_max = frames;
+    if (step > 0.0)
+      chunk_max = std::max(1u, static_cast<unsigned int>(static_cast<double>(DECODE_WINDOW_FRAMES - before - after - 3) / step));
+
+    unsigned int done = 0;
+    while (done < frames) {
+      const unsigned int count = std::min(frames - done, chunk_max);
+      const double pos = index_subsample + static_cast<double>(done) * step;
+      const double whole = floor(pos);
+      const unsigned int chunk_index = index + static_cast<unsigned int>(whole);
+      const double chunk_subsample = pos - whole;
+      const unsigned int used = static_cast<unsigned int>(chunk_subsample + static_cast<double>(count - 1) * step) + 1;
+      const unsigned int window_frames = std::min(static_cast<unsigned int>(DECODE_WINDOW_FRAMES), before + used + after);
+
+      //the taps before the start of the audio are zero
+      const unsigned int lead = chunk_index < before ? before - chunk_index : 0;
+      for (unsigned int c = 0; c < 2; c++) {
+        if (lead)
+          memset(window[c], 0, sizeof(float) * lead);
+        buffer->read_block(c == 0 ? 0 : right_channel, chunk_index + lead - before, window[c] + lead, window_frames - lead);
+      }
+
+      SampleSource s;
+      s.channel[0] = window[0];
+      s.channel[1] = window[1];
+      s.stride = 1;
+      s.frames = window_frames;
+      float * out[2] = { buffers[0] + done, buffers[1] + done };
+      interpolate_block(mInterpolation, s, out, count, before, chunk_subsample, step);
+      done += count;
+    }
   }
 }
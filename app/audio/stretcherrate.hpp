@@ -2,13 +2,26 @@
 #define STRETCHER_RATE_HPP
 
 #include "stretcher.hpp"
+#include "interpolation.hpp"
+#include <vector>
 
 namespace djaudio {
   class StretcherRate : public Stretcher {
     public:
+      StretcherRate(interpolation_t mode = INTERPOLATE_CUBIC);
       virtual ~StretcherRate();
+
+      void interpolation(interpolation_t mode);
+      interpolation_t interpolation() const;
     protected:
       virtual void compute_frame(float * frame, unsigned int new_index, double new_index_subsample, unsigned int last_index, double last_index_subsample);
+      virtual void compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step);
+    private:
+      SampleSource source() const;
+      //for compact storage, converts the source frames a chunk of output needs into mWindow and interpolates from there
+      void compute_decoded(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step);
+      interpolation_t mInterpolation;
+      std::vector<float> mWindow;
   };
 }
 
@@ -0,0 +1,256 @@
+#include "stretcherwsola.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#ifdef DJ_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace djaudio {
+  namespace {
+    //a grain is two hops, about 23ms, long enough to hold a cycle of the lowest notes.
+    //a grain costs about hop * tolerance / 2 multiply adds to place and comes once a hop, at this size
+    //every deck placing a grain in the same short period still leaves most of the period
+    const double HOP_SECONDS = 0.0116;
+    const unsigned int HOP_MIN = 64;
+    //extra lags computed past the end by the vector search
+    const unsigned int LAG_PAD = 8;
+
+    //out[m] = sum over i of tmpl[i] * region[m + i]
+    void correlate_scalar(const float * tmpl, const float * region, unsigned int length, unsigned int lags, float * out) {
+      for (unsigned int m = 0; m < lags; m++) {
+        float sum = 0.0f;
+        for (unsigned int i = 0; i < length; i++)
+          sum += tmpl[i] * region[m + i];
+        out[m] = sum;
+      }
+    }
+
+#ifdef DJ_SIMD_X86
+    DJ_TARGET_SSE2
+    void correlate_sse2(const float * tmpl, const float * region, unsigned int length, unsigned int lags, float * out) {
+      //eight lags at a time, each template sample is multiplied into all of them
+      //region must be readable for 8 lags past the last
+      for (unsigned int m = 0; m < lags; m += 8) {
+        __m128 low = _mm_setzero_ps();
+        __m128 high = _mm_setzero_ps();
+        for (unsigned int i = 0; i < length; i++) {
+          const __m128 t = _mm_set1_ps(tmpl[i]);
+          low = _mm_add_ps(low, _mm_mul_ps(t, _mm_loadu_ps(region + m + i)));
+          high = _mm_add_ps(high, _mm_mul_ps(t, _mm_loadu_ps(region + m + i + 4)));
+        }
+        _mm_storeu_ps(out + m, low);
+        _mm_storeu_ps(out + m + 4, high);
+      }
+    }
+#endif
+
+    void correlate(const float * tmpl, const float * region, unsigned int length, unsigned int lags, float * out) {
+#ifdef DJ_SIMD_X86
+      if (simd::sse2())
+        return correlate_sse2(tmpl, region, length, lags, out);
+#endif
+      correlate_scalar(tmpl, region, length, lags, out);
+    }
+  }
+
+  StretcherWSOLA::StretcherWSOLA() :
+    mHop(0),
+    mTolerance(0),
+    mOutputIndex(0),
+    mNext(0),
+    mPrimed(false)
+  {
+    setup(44100);
+  }
+
+  StretcherWSOLA::~StretcherWSOLA() { }
+
+  void StretcherWSOLA::setup(unsigned int sample_rate) {
+    //multiples of 8 so the decimated buffers split evenly into vectors
+    mHop = std::max(HOP_MIN, static_cast<unsigned int>(static_cast<double>(sample_rate) * HOP_SECONDS) & ~7u);
+    mTolerance = mHop / 2;
+
+    //hann, overlapped a hop apart the windows sum to one
+    mWindow.resize(2 * mHop);
+    for (unsigned int i = 0; i < mWindow.size(); i++)
+      mWindow[i] = static_cast<float>(0.5 - 0.5 * cos(M_PI * static_cast<double>(i) / static_cast<double>(mHop)));
+
+    for (unsigned int c = 0; c < 2; c++) {
+      mRegion[c].assign(2 * mHop + 2 * mTolerance, 0.0f);
+      mOverlap[c].assign(mHop, 0.0f);
+      mOutput[c].assign(mHop, 0.0f);
+    }
+    mTemplate.assign(mHop, 0.0f);
+    mCoarseTemplate.assign(mHop / 2, 0.0f);
+    mCoarseRegion.assign(mHop / 2 + mTolerance + LAG_PAD, 0.0f);
+    mCorrelation.assign(mTolerance + 1 + LAG_PAD, 0.0f);
+
+    mOutputIndex = mHop;
+    mPrimed = false;
+  }
+
+  bool StretcherWSOLA::pitch_independent() const { return true; }
+
+  void StretcherWSOLA::audio_changed() {
+    mOutputIndex = mHop;
+    mPrimed = false;
+  }
+
+  void StretcherWSOLA::frame_updated() {
+    mOutputIndex = mHop;
+    mPrimed = false;
+  }
+
+  void StretcherWSOLA::compute_frame(float * frame, unsigned int new_index, double new_index_subsample, unsigned int last_index, double last_index_subsample) {
+    const double step = (static_cast<double>(new_index) - static_cast<double>(last_index)) + (new_index_subsample - last_index_subsample);
+    if (step > 0.0) {
+      float * out[2] = { frame, frame + 1 };
+      compute_block(out, 1, new_index, new_index_subsample, step);
+      return;
+    }
+
+    //stopped or going backwards there's no pitch to keep, play the source like the rate stretcher does
+    const AudioBuffer * buffer = audio_buffer();
+    const unsigned int right = buffer->channels() > 1 ? 1 : 0;
+    for (unsigned int c = 0; c < 2; c++) {
+      float s[2];
+      buffer->read_block(c == 0 ? 0 : right, new_index, s, 2);
+      frame[c] = s[0] + (s[1] - s[0]) * static_cast<float>(new_index_subsample);
+    }
+    mOutputIndex = mHop;
+    mPrimed = false;
+  }
+
+  void StretcherWSOLA::compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step) {
+    unsigned int done = 0;
+    while (done < frames) {
+      if (mOutputIndex >= mHop) {
+        const double position = floor(index_subsample + static_cast<double>(done) * step);
+        next_grain(static_cast<long>(index) + static_cast<long>(position), step);
+      }
+      const unsigned int count = std::min(frames - done, mHop - mOutputIndex);
+      for (unsigned int c = 0; c < 2; c++)
+        memcpy(buffers[c] + done, &mOutput[c][mOutputIndex], sizeof(float) * count);
+      mOutputIndex += count;
+      done += count;
+    }
+  }
+
+  void StretcherWSOLA::next_grain(long position, double step) {
+    const AudioBuffer * buffer = audio_buffer();
+    const unsigned int right = buffer->channels() > 1 ? 1 : 0;
+    const long hop = static_cast<long>(mHop);
+    const long tolerance = static_cast<long>(mTolerance);
+
+    //centre the grain on where the play head is half way through it
+    const long nominal = position + lround(static_cast<double>(mHop) * step) - hop;
+    const long start = nominal - tolerance;
+    const unsigned int frames = mRegion[0].size();
+    //the frames before the start of the audio are zero, read_block pads past the end
+    const unsigned int lead = start < 0 ? static_cast<unsigned int>(std::min(-start, static_cast<long>(frames))) : 0;
+    for (unsigned int c = 0; c < 2; c++) {
+      float * region = &mRegion[c].front();
+      if (lead)
+        memset(region, 0, sizeof(float) * lead);
+      if (lead < frames)
+        buffer->read_block(c == 0 ? 0 : right, static_cast<unsigned int>(start + lead), region + lead, frames - lead);
+    }
+
+    if (!mPrimed) {
+      //pick the source up as is, as if the last grain ended right here
+      for (unsigned int c = 0; c < 2; c++) {
+        for (unsigned int i = 0; i < mHop; i++)
+          mOverlap[c][i] = mWindow[mHop + i] * mRegion[c][mTolerance + i];
+      }
+      mNext = nominal;
+      mPrimed = true;
+    }
+
+    //already on the audio that follows the last grain, nothing lines up better
+    const long offset = nominal == mNext ? 0 : best_offset();
+    const float * grain[2] = { &mRegion[0][tolerance + offset], &mRegion[1][tolerance + offset] };
+    const float * window = &mWindow.front();
+    for (unsigned int c = 0; c < 2; c++) {
+      float * out = &mOutput[c].front();
+      float * overlap = &mOverlap[c].front();
+      const float * g = grain[c];
+      for (unsigned int i = 0; i < mHop; i++) {
+        out[i] = overlap[i] + window[i] * g[i];
+        overlap[i] = window[mHop + i] * g[mHop + i];
+      }
+    }
+    for (unsigned int i = 0; i < mHop; i++)
+      mTemplate[i] = grain[0][mHop + i] + grain[1][mHop + i];
+
+    mNext = nominal + offset + hop;
+    mOutputIndex = 0;
+  }
+
+  int StretcherWSOLA::best_offset() {
+    //mono, decimated by two, the coarse lags are two frames apart and cover the tolerance either side
+    const unsigned int length = mHop / 2;
+    const unsigned int lags = mTolerance + 1;
+    const float * left = &mRegion[0].front();
+    const float * right = &mRegion[1].front();
+    float * coarse_region = &mCoarseRegion.front();
+    float * coarse_template = &mCoarseTemplate.front();
+    for (unsigned int i = 0; i < length + lags - 1; i++)
+      coarse_region[i] = left[2 * i] + left[2 * i + 1] + right[2 * i] + right[2 * i + 1];
+    double template_energy = 0.0;
+    for (unsigned int i = 0; i < length; i++) {
+      coarse_template[i] = mTemplate[2 * i] + mTemplate[2 * i + 1];
+      template_energy += coarse_template[i] * coarse_template[i];
+    }
+    //silence lines up anywhere
+    if (template_energy < 1e-9)
+      return 0;
+
+    float * correlation = &mCorrelation.front();
+    correlate(coarse_template, coarse_region, length, lags, correlation);
+
+    //normalized by the region's energy so loud spots don't win, only in phase matches count
+    double energy = 0.0;
+    for (unsigned int i = 0; i < length; i++)
+      energy += coarse_region[i] * coarse_region[i];
+    int best = -1;
+    double best_score = 0.0;
+    for (unsigned int m = 0; m < lags; m++) {
+      const double c = correlation[m];
+      if (c > 0.0 && energy > 1e-9 && c * c > best_score * energy) {
+        best = static_cast<int>(m);
+        best_score = c * c / energy;
+      }
+      const double leaving = coarse_region[m];
+      const double entering = coarse_region[m + length];
+      energy += entering * entering - leaving * leaving;
+    }
+    if (best < 0)
+      return 0;
+
+    //refine to the frame
+    const int tolerance = static_cast<int>(mTolerance);
+    const int coarse = 2 * best - tolerance;
+    int offset = coarse;
+    best_score = -1.0;
+    for (int d = std::max(coarse - 1, -tolerance); d <= std::min(coarse + 1, tolerance); d++) {
+      const float * l = left + tolerance + d;
+      const float * r = right + tolerance + d;
+      double c = 0.0;
+      double e = 0.0;
+      for (unsigned int i = 0; i < mHop; i++) {
+        const float v = l[i] + r[i];
+        c += mTemplate[i] * v;
+        e += v * v;
+      }
+      const double score = (c > 0.0 && e > 1e-9) ? c * c / e : 0.0;
+      if (score > best_score) {
+        offset = d;
+        best_score = score;
+      }
+    }
+    return offset;
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef STRETCHER_WSOLA_HPP
+#define STRETCHER_WSOLA_HPP
+
+#include "stretcher.hpp"
+#include "alignedallocator.hpp"
+#include <vector>
+
+namespace djaudio {
+  //key lock, changes the speed without changing the pitch: waveform similarity overlap-add.
+  //hann windowed grains two hops long are taken from around the play head and overlapped a hop apart,
+  //each is shifted, within a tolerance, to where it best continues the audio that followed the last grain
+  class StretcherWSOLA : public Stretcher {
+    public:
+      StretcherWSOLA();
+      virtual ~StretcherWSOLA();
+
+      //not in the audio thread, sizes the grains for the sample rate
+      void setup(unsigned int sample_rate);
+
+      virtual bool pitch_independent() const;
+    protected:
+      virtual void audio_changed();
+      virtual void frame_updated();
+      virtual void compute_frame(float * frame, unsigned int new_index, double new_index_subsample, unsigned int last_index, double last_index_subsample);
+      virtual void compute_block(float ** buffers, unsigned int frames, unsigned int index, double index_subsample, double step);
+    private:
+      typedef std::vector<float, aligned_allocator<float> > sample_buffer_t;
+      //overlap the next grain into a hop of output whose first frame plays the source at position
+      void next_grain(long position, double step);
+      //the shift of a grain from its nominal position, within the tolerance, that best continues the last grain
+      //searches a decimated mono mix first then refines around what it found
+      int best_offset();
+
+      unsigned int mHop;
+      unsigned int mTolerance;
+      //2 hops
+      sample_buffer_t mWindow;
+      //the source around a grain, 2 hops plus the tolerance either side
+      sample_buffer_t mRegion[2];
+      //the windowed second half of the last grain
+      sample_buffer_t mOverlap[2];
+      //a hop of finished output and the next frame of it to play, a hop when it is used up
+      sample_buffer_t mOutput[2];
+      unsigned int mOutputIndex;
+      //the mono source that followed the last grain, what the next one should line up with
+      sample_buffer_t mTemplate;
+      //decimated template and region for the coarse search
+      sample_buffer_t mCoarseTemplate;
+      sample_buffer_t mCoarseRegion;
+      sample_buffer_t mCorrelation;
+      //the source frame that continues the last grain, not valid after a seek until a grain is played
+      long mNext;
+      bool mPrimed;
+  };
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include "transport.hpp"
+#include <cmath>
+#include <climits>
 
 using namespace djaudio;
 
@@ -33,6 +35,35 @@ bool Transport::tick(){
    }
 }
 
+bool Transport::tick(unsigned int count){
+   if (count == 0)
+      return false;
+   if (count == 1)
+      return tick();
+
+   double index = mPosition.pos_in_beat() + mIncrement * static_cast<double>(count);
+   bool beat = false;
+   while(index >= 1.0){
+      index -= 1.0;
+      mPosition.advance_beat();
+      beat = true;
+   }
+   mPosition.pos_in_beat(index);
+   mSecondsTillNextBeat = (1.0 - index) * 60.0 / mBPM;
+   return beat;
+}
+
+unsigned int Transport::ticks_till_next_beat() const {
+   if (mIncrement <= 0.0)
+      return UINT_MAX;
+   double ticks = ceil((1.0 - mPosition.pos_in_beat()) / mIncrement);
+   if (ticks < 1.0)
+      return 1;
+   if (ticks >= static_cast<double>(UINT_MAX))
+      return UINT_MAX;
+   return static_cast<unsigned int>(ticks);
+}
+
 double Transport::seconds_till_next_beat() const {
    return mSecondsTillNextBeat;
 }
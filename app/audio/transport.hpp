@@ -23,6 +23,10 @@ namespace djaudio {
       //misc
       //tick the clock, outputs true if new beat, false otherwise
       bool tick();
+      //tick the clock count times, outputs true if we crossed into a new beat
+      bool tick(unsigned int count);
+      //the number of ticks until tick() will report a new beat, at least 1
+      unsigned int ticks_till_next_beat() const;
       //only valid right after tick() 
       double seconds_till_next_beat() const;
 
@@ -0,0 +1,165 @@
+#include "workerpool.hpp"
+#include "profiler.hpp"
+#include <sched.h>
+#include <iostream>
+
+using namespace djaudio;
+
+namespace {
+  //how long a worker checks for a new run before going to sleep, enough to cover the gap between
+  //the blocks of a period but a small part of even a short period
+  const uint64_t SPIN_NANOS = 20000;
+  //the clock is read every this many spins
+  const unsigned int SPIN_CLOCK_INTERVAL = 16;
+
+  //give other threads on this core a turn now and then, in case there are more threads than cores
+  inline void cpu_relax(unsigned int spins) {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+    if (spins % 64 == 63)
+      sched_yield();
+  }
+}
+
+WorkerPool::WorkerPool() :
+  mQuit(false),
+  mJob(NULL),
+  mUserData(NULL),
+  mCount(0),
+  mGeneration(0),
+  mNext(0),
+  mFinished(0)
+{
+}
+
+WorkerPool::~WorkerPool() {
+  stop();
+}
+
+unsigned int WorkerPool::start(unsigned int threads, int realtime_priority) {
+  stop();
+  mQuit.store(false);
+
+  for (unsigned int i = 0; i < threads; i++) {
+    worker_t * worker = new worker_t;
+    worker->pool = this;
+    worker->index = i;
+    worker->generation = mGeneration.load();
+    worker->sleeping.store(false);
+    sem_init(&worker->wake, 0, 0);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (realtime_priority > 0) {
+      //the workers hold up the audio thread so they have to run at its priority
+      struct sched_param param;
+      param.sched_priority = realtime_priority;
+      pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+      pthread_attr_setschedparam(&attr, &param);
+    }
+
+    if (pthread_create(&worker->thread, &attr, &WorkerPool::thread_main, worker) != 0) {
+      pthread_attr_destroy(&attr);
+      sem_destroy(&worker->wake);
+      delete worker;
+      std::cerr << "worker pool: could not create a realtime worker thread, using " << mWorkers.size() << " workers" << std::endl;
+      break;
+    }
+    pthread_attr_destroy(&attr);
+    mWorkers.push_back(worker);
+  }
+  return mWorkers.size();
+}
+
+void WorkerPool::stop() {
+  if (mWorkers.empty())
+    return;
+  mQuit.store(true);
+  for (unsigned int i = 0; i < mWorkers.size(); i++)
+    sem_post(&mWorkers[i]->wake);
+  for (unsigned int i = 0; i < mWorkers.size(); i++) {
+    pthread_join(mWorkers[i]->thread, NULL);
+    sem_destroy(&mWorkers[i]->wake);
+    delete mWorkers[i];
+  }
+  mWorkers.clear();
+}
+
+unsigned int WorkerPool::workers() const { return mWorkers.size(); }
+
+void WorkerPool::run(job_t job, void * user_data, unsigned int count) {
+  if (mWorkers.empty() || count < 2) {
+    for (unsigned int i = 0; i < count; i++)
+      job(user_data, i);
+    return;
+  }
+
+  //every worker finished the last run so nobody reads these while we write them
+  mJob = job;
+  mUserData = user_data;
+  mCount = count;
+  mNext.store(0, std::memory_order_relaxed);
+  mFinished.store(0, std::memory_order_relaxed);
+  mGeneration.fetch_add(1, std::memory_order_seq_cst);
+
+  for (unsigned int i = 0; i < mWorkers.size(); i++) {
+    if (mWorkers[i]->sleeping.exchange(false, std::memory_order_seq_cst))
+      sem_post(&mWorkers[i]->wake);
+  }
+
+  work();
+
+  //wait for every worker to check in, not just for the jobs to be done, so that none of them
+  //can see the next run half written
+  const unsigned int workers = mWorkers.size();
+  for (unsigned int spins = 0; mFinished.load(std::memory_order_acquire) != workers; spins++)
+    cpu_relax(spins);
+}
+
+void * WorkerPool::thread_main(void * worker) {
+  worker_t * w = static_cast<worker_t *>(worker);
+  w->pool->work_loop(w);
+  return NULL;
+}
+
+void WorkerPool::work_loop(worker_t * worker) {
+  unsigned int generation = worker->generation;
+  while (!mQuit.load(std::memory_order_acquire)) {
+    const uint64_t spin_end = Profiler::now() + SPIN_NANOS;
+    for (unsigned int spins = 0; mGeneration.load(std::memory_order_acquire) == generation; spins++) {
+      if (spins % SPIN_CLOCK_INTERVAL == SPIN_CLOCK_INTERVAL - 1 && Profiler::now() >= spin_end)
+        break;
+      cpu_relax(spins);
+    }
+
+    if (mGeneration.load(std::memory_order_acquire) == generation) {
+      worker->sleeping.store(true, std::memory_order_seq_cst);
+      if (mGeneration.load(std::memory_order_seq_cst) == generation) {
+        sem_wait(&worker->wake);
+      } else if (!worker->sleeping.exchange(false, std::memory_order_acq_rel)) {
+        //the audio thread saw us sleeping and posted, take it so the next wait doesn't return early
+        sem_wait(&worker->wake);
+      }
+      if (mQuit.load(std::memory_order_acquire))
+        break;
+      if (mGeneration.load(std::memory_order_acquire) == generation)
+        continue;
+    }
+
+    generation = mGeneration.load(std::memory_order_acquire);
+    worker->generation = generation;
+    work();
+    mFinished.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+void WorkerPool::work() {
+  for (;;) {
+    const unsigned int index = mNext.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= mCount)
+      return;
+    mJob(mUserData, index);
+  }
+}
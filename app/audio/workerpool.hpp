@@ -0,0 +1,63 @@
+#ifndef DATAJOCKEY_WORKERPOOL_HPP
+#define DATAJOCKEY_WORKERPOOL_HPP
+
+#include <atomic>
+#include <vector>
+#include <pthread.h>
+#include <semaphore.h>
+
+namespace djaudio {
+  //realtime threads that split jobs with the audio thread
+  //workers spin for about 20us after each run so back to back runs within a period don't need a wake up,
+  //then sleep on a semaphore until the next period
+  class WorkerPool {
+    public:
+      typedef void (* job_t)(void * user_data, unsigned int index);
+
+      WorkerPool();
+      ~WorkerPool();
+
+      //start threads workers running SCHED_FIFO at realtime_priority, not pinned since we don't know where
+      //jack runs the audio thread, the kernel spreads realtime threads over the idle cores,
+      //not from the audio thread, any workers that can't get realtime scheduling are dropped since the
+      //audio thread would wait on them, returns the number of workers running
+      unsigned int start(unsigned int threads, int realtime_priority);
+      void stop();
+      unsigned int workers() const;
+
+      //call job for every index in [0, count) across the workers and the calling thread, returns once all are done
+      //realtime safe, only call from one thread
+      void run(job_t job, void * user_data, unsigned int count);
+    private:
+      WorkerPool(const WorkerPool&);
+      WorkerPool& operator=(const WorkerPool&);
+
+      struct worker_t {
+        WorkerPool * pool;
+        unsigned int index;
+        //the last run this worker has seen
+        unsigned int generation;
+        pthread_t thread;
+        sem_t wake;
+        std::atomic<bool> sleeping;
+      };
+
+      static void * thread_main(void * worker);
+      void work_loop(worker_t * worker);
+      //take jobs from the current run until there are none left
+      void work();
+
+      std::vector<worker_t *> mWorkers;
+      std::atomic<bool> mQuit;
+
+      //the current run, only written while every worker is waiting
+      job_t mJob;
+      void * mUserData;
+      unsigned int mCount;
+      std::atomic<unsigned int> mGeneration;
+      std::atomic<unsigned int> mNext;
+      std::atomic<unsigned int> mFinished;
+  };
+}
+
+#endif
@@ -58,7 +58,7 @@ void AudioFileInfoExtractor::processAudioFile(QString audioFileName) {
     }
 
     //extract the beats
-    djaudio::AudioBufferPtr audio_buffer(new djaudio::AudioBuffer(audioFileName));
+    djaudio::AudioBufferPtr audio_buffer(new djaudio::AudioBuffer(audioFileName, djaudio::AudioBuffer::PLANAR));
     djaudio::BeatBufferPtr beat_buffer(new djaudio::BeatBuffer);
 
     if (audio_buffer->channels() != 2) {
@@ -3,6 +3,7 @@
 #include "player.hpp"
 #include "command.hpp"
 #include "loopandjumpmanager.h"
+#include "config.hpp"
 #include <QThread>
 #include <QTimer>
 #include <QHash>
@@ -38,33 +39,6 @@ namespace {
     }
 }
 
-class Consumer : public QObject {
-  private:
-    EngineQueryCommand * mQueryCmd = nullptr;
-    djaudio::Scheduler * mScheduler = nullptr;
-  public:
-    Consumer(djaudio::Scheduler * scheduler, EngineQueryCommand * cmd, QObject * parent = nullptr) : 
-      QObject(parent),
-      mQueryCmd(cmd),
-      mScheduler(scheduler) { }
-
-    void grabCommands() {
-      mScheduler->execute_done_actions();
-      while (djaudio::Command * cmd = mScheduler->pop_complete_command()) {
-        EngineQueryCommand * query = dynamic_cast<EngineQueryCommand*>(cmd);
-        if (query) {
-          mQueryCmd = query;
-        } else if (cmd) {
-          delete cmd;
-        }
-      }
-      if (mQueryCmd) {
-        mScheduler->execute(mQueryCmd);
-        mQueryCmd = nullptr;
-      }
-    }
-};
-
 struct PlayerState {
   QHash<QString, bool> boolValue;
   QHash<QString, int> intValue;
@@ -76,6 +50,7 @@ AudioModel::AudioModel(QObject *parent) :
 {
   mAudioIO = djaudio::AudioIO::instance();
   mMaster  = djaudio::Master::instance();
+  mNumPlayers = dj::Configuration::instance()->engine_decks();
 
   mLoopAndJumpManager = new LoopAndJumpManager(this);
 
@@ -115,6 +90,7 @@ AudioModel::AudioModel(QObject *parent) :
     pstate->boolValue["mute"] = p->muted();
     pstate->boolValue["audible"] = false;
     pstate->boolValue["loop"] = false;
+    pstate->boolValue["keylock"] = p->keylock();
 
     pstate->doubleValue["speed"] = p->play_speed() - 1.0;
     pstate->doubleValue["loop_length_beats"] = 0;
@@ -124,9 +100,8 @@ AudioModel::AudioModel(QObject *parent) :
   mMasterIntValue["volume"] = to_int(mMaster->master_volume());
   mMasterIntValue["cue_volume"] = to_int(mMaster->cue_volume());
 
-  EngineQueryCommand * query = new EngineQueryCommand(mNumPlayers);
   mConsumeThread = new QThread(this);
-  mConsumer = new Consumer(mMaster->scheduler(), query);
+  mConsumer = new Consumer(mMaster->scheduler(), mMaster->state());
   mConsumer->moveToThread(mConsumeThread);
 
   QTimer * consumetimer = new QTimer(this);
@@ -137,11 +112,11 @@ AudioModel::AudioModel(QObject *parent) :
   connect(mConsumeThread, &QThread::started, consumetimer, static_cast<void (QTimer::*)(void)>(&QTimer::start));
   connect(mConsumeThread, &QThread::finished, consumetimer, &QTimer::stop);
 
-  connect(query, &EngineQueryCommand::playerValueUpdateBool, this, &AudioModel::playerSetValueBool);
-  connect(query, &EngineQueryCommand::playerValueUpdateInt, this, &AudioModel::playerSetValueInt);
-  connect(query, &EngineQueryCommand::playerValueUpdateDouble, this, &AudioModel::playerSetValueDouble);
+  connect(mConsumer, &Consumer::playerValueUpdateBool, this, &AudioModel::playerSetValueBool);
+  connect(mConsumer, &Consumer::playerValueUpdateInt, this, &AudioModel::playerSetValueInt);
+  connect(mConsumer, &Consumer::playerValueUpdateDouble, this, &AudioModel::playerSetValueDouble);
 
-  connect(query, &EngineQueryCommand::masterValueUpdateDouble, this, &AudioModel::masterSetValueDouble);
+  connect(mConsumer, &Consumer::masterValueUpdateDouble, this, &AudioModel::masterSetValueDouble);
 }
 
 AudioModel::~AudioModel() {
@@ -294,6 +269,8 @@ void AudioModel::playerSetValueBool(int player, QString name, bool v) {
         }
       } else if (name == "mute") {
         cmd = new djaudio::PlayerStateCommand(player, v ? djaudio::PlayerStateCommand::MUTE : djaudio::PlayerStateCommand::NO_MUTE);
+      } else if (name == "keylock") {
+        cmd = new djaudio::PlayerStateCommand(player, v ? djaudio::PlayerStateCommand::KEYLOCK : djaudio::PlayerStateCommand::NO_KEYLOCK);
       } else if (name == "seeking") {
         pstate->boolValue["seeking"] = v;
         emit(playerValueChangedBool(player, name, v));
@@ -301,7 +278,7 @@ void AudioModel::playerSetValueBool(int player, QString name, bool v) {
         if (!pstate->boolValue["play"])
           return nullptr;
         return new djaudio::PlayerStateCommand(player, v ? djaudio::PlayerStateCommand::PAUSE : djaudio::PlayerStateCommand::PLAY);
-      } else if (name == "audible") {
+      } else if (name == "audible" || name == "starved") {
         pstate->boolValue[name] = v; //relaying from Consumer
         emit(playerValueChangedBool(player, name, v));
         return nullptr;
@@ -319,7 +296,7 @@ void AudioModel::playerSetValueBool(int player, QString name, bool v) {
       }
       return cmd;
     });
-  if (name != "audible")
+  if (name != "audible" && name != "starved")
     cout << player << qPrintable(name) << " " << v << endl;
 }
 
@@ -457,6 +434,38 @@ void AudioModel::masterTrigger(QString name) {
   cout << "master name " << qPrintable(name) << endl;
 }
 
+void AudioModel::midiPlayerSetValueDouble(int player, QString name, double v, unsigned int frame) {
+  stamped(frame, [&] { playerSetValueDouble(player, name, v); });
+}
+
+void AudioModel::midiPlayerSetValueInt(int player, QString name, int v, unsigned int frame) {
+  stamped(frame, [&] { playerSetValueInt(player, name, v); });
+}
+
+void AudioModel::midiPlayerSetValueBool(int player, QString name, bool v, unsigned int frame) {
+  stamped(frame, [&] { playerSetValueBool(player, name, v); });
+}
+
+void AudioModel::midiPlayerTrigger(int player, QString name, unsigned int frame) {
+  stamped(frame, [&] { playerTrigger(player, name); });
+}
+
+void AudioModel::midiMasterSetValueDouble(QString name, double v, unsigned int frame) {
+  stamped(frame, [&] { masterSetValueDouble(name, v); });
+}
+
+void AudioModel::midiMasterSetValueInt(QString name, int v, unsigned int frame) {
+  stamped(frame, [&] { masterSetValueInt(name, v); });
+}
+
+void AudioModel::midiMasterSetValueBool(QString name, bool v, unsigned int frame) {
+  stamped(frame, [&] { masterSetValueBool(name, v); });
+}
+
+void AudioModel::midiMasterTrigger(QString name, unsigned int frame) {
+  stamped(frame, [&] { masterTrigger(name); });
+}
+
 void AudioModel::pluginSetValueInt(int plugin_index, QString parameter_name, int value) {
   auto it = mPlugins.find(plugin_index);
   if (it == mPlugins.end())
@@ -519,8 +528,18 @@ void AudioModel::masterSet(std::function<djaudio::Command *(void)> func) {
     queue(cmd);
 }
 
+void AudioModel::stamped(unsigned int frame, std::function<void(void)> func) {
+  mStamp = true;
+  mStampFrame = frame;
+  func();
+  mStamp = false;
+}
+
 void AudioModel::queue(djaudio::Command * cmd) {
-  mMaster->scheduler()->execute(cmd);
+  if (mStamp)
+    cmd->frame_stamp(mStampFrame);
+  if (!mMaster->scheduler()->execute(cmd))
+    cerr << "command queue full, dropped a command" << endl;
 }
 
 
@@ -577,50 +596,44 @@ void PlayerLoopAndReportCommand::execute_done() {
   emit(playerValueChangedInt(pindex, "loop_end_frame", static_cast<int>(end_frame())));
 }
 
-struct EnginePlayerState {
-  unsigned int frame_current;
-  double play_speed;
-  float max_sample_value;
-  bool audible;
-};
-
-EngineQueryCommand::EngineQueryCommand(int num_players, QObject * parent) : QObject(parent), djaudio::MasterCommand()
+Consumer::Consumer(djaudio::Scheduler * scheduler, const djaudio::EngineState * state, QObject * parent) :
+  QObject(parent),
+  mScheduler(scheduler),
+  mState(state)
 {
-  for (int i = 0; i < num_players; i++)
-    mPlayerStates.push_back(new EnginePlayerState);
-}
-
-bool EngineQueryCommand::delete_after_done() { return false; }
-
-void EngineQueryCommand::execute(const djaudio::Transport& /*transport*/) {
-  djaudio::Master * m = master();
-  for (size_t i = 0; i < std::min(m->players().size(), (size_t)mPlayerStates.size()); i++) {
-    djaudio::Player * p = m->players().at(i);
-    EnginePlayerState * ps = mPlayerStates[i];
-
-    ps->play_speed = p->play_speed();
-    ps->max_sample_value = p->max_sample_value_reset();
-    ps->audible = p->audible();
-    ps->frame_current = p->frame();
-  }
-  mMasterVolume = m->max_sample_value_reset();
-  mMasterBPM = m->transport()->bpm();
 }
 
-void EngineQueryCommand::execute_done() {
-  for (int i = 0; i < mPlayerStates.size(); i++) {
-    EnginePlayerState * ps = mPlayerStates[i];
-    emit(playerValueUpdateDouble(i, "update_speed", (ps->play_speed - 1.0) * 100.0));
-    emit(playerValueUpdateDouble(i, "audio_level", ps->max_sample_value));
-    emit(playerValueUpdateInt(i, "position_frame", ps->frame_current));
-    emit(playerValueUpdateBool(i, "audible", ps->audible));
+void Consumer::grabCommands() {
+  //report first, the done actions may release buffers the state refers to
+  report();
+  mScheduler->execute_done_actions();
+  while (djaudio::Command * cmd = mScheduler->pop_complete_command())
+    delete cmd;
+  mDonePeriods = mState->periods();
+}
+
+void Consumer::report() {
+  const unsigned long periods = mState->read(mMasterState, mPlayerStates);
+  //a command we ran the done actions for may have swapped a buffer out during the period after mDonePeriods,
+  //so only states from after that one are sure to refer to buffers that are still around
+  const bool buffers_current = periods > mDonePeriods;
+  mStarved.resize(mPlayerStates.size(), 0);
+
+  for (unsigned int i = 0; i < mPlayerStates.size(); i++) {
+    const djaudio::EngineState::player_t& ps = mPlayerStates[i];
+    emit(playerValueUpdateDouble(i, "update_speed", (ps.play_speed - 1.0) * 100.0));
+    emit(playerValueUpdateDouble(i, "audio_level", ps.peak));
+    emit(playerValueUpdateInt(i, "position_frame", ps.frame));
+    emit(playerValueUpdateBool(i, "audible", ps.audible));
+    emit(playerValueUpdateBool(i, "starved", ps.starved != mStarved[i]));
+    mStarved[i] = ps.starved;
+    //we're off the audio thread, page in what it is about to read
+    if (ps.audio_buffer && buffers_current)
+      ps.audio_buffer->keep_resident(ps.frame, ps.loop_start_frame, ps.loop_end_frame);
   }
-  //emit(masterValueUpdateDouble("update_bpm", mMasterBPM));
-  emit(masterValueUpdateDouble("audio_level", mMasterVolume));
+  emit(masterValueUpdateDouble("audio_level", mMasterState.peak));
 }
 
-bool EngineQueryCommand::store(djaudio::CommandIOData& /* data */) const { return false; }
-
 MasterSyncToPlayerCommand::MasterSyncToPlayerCommand(int value) :
   QObject(NULL),
   djaudio::MasterIntCommand(djaudio::MasterIntCommand::SYNC_TO_PLAYER, value), mBPM(0.0) {
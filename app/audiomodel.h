@@ -4,14 +4,14 @@
 #include <QObject>
 #include <QList>
 #include <functional>
+#include <vector>
 #include "audioio.hpp"
 #include "db.h"
 #include "transport.hpp"
+#include "enginestate.hpp"
 
 class Consumer;
-class EngineQueryCommand;
 struct PlayerState;
-struct EnginePlayerState;
 class LoopAndJumpManager;
 
 class AudioModel : public QObject {
@@ -51,6 +51,16 @@ class AudioModel : public QObject {
     void masterSetValueBool(QString name, bool v);
     void masterTrigger(QString name);
 
+    //from midi, the commands are stamped with the jack frame time of the event
+    void midiPlayerSetValueDouble(int player, QString name, double v, unsigned int frame);
+    void midiPlayerSetValueInt(int player, QString name, int v, unsigned int frame);
+    void midiPlayerSetValueBool(int player, QString name, bool v, unsigned int frame);
+    void midiPlayerTrigger(int player, QString name, unsigned int frame);
+    void midiMasterSetValueDouble(QString name, double v, unsigned int frame);
+    void midiMasterSetValueInt(QString name, int v, unsigned int frame);
+    void midiMasterSetValueBool(QString name, bool v, unsigned int frame);
+    void midiMasterTrigger(QString name, unsigned int frame);
+
     void pluginSetValueInt(int plugin_index, QString parameter_name, int value);
     void pluginAddToPlayer(int player_index, int location_index, AudioPluginPtr plugin);
     void pluginAddToMaster(int send_index, int location_index, AudioPluginPtr plugin);
@@ -81,10 +91,15 @@ class AudioModel : public QObject {
     QHash<int, AudioPluginPtr> mPlugins; //valid plugins
     QList<AudioPluginPtr> mPluginsToDelete; //plugins that will be deleted once they come out of the audio thread
 
+    //while set, queue stamps commands with mStampFrame instead of leaving it to the scheduler
+    bool mStamp = false;
+    unsigned int mStampFrame = 0;
+
     bool inRange(int player);
     void queue(djaudio::Command * cmd);
     void playerSet(int player, std::function<djaudio::Command *(PlayerState * state)> func);
     void masterSet(std::function<djaudio::Command *(void)> func);
+    void stamped(unsigned int frame, std::function<void(void)> func);
 };
 
 
@@ -117,23 +132,28 @@ class PlayerLoopAndReportCommand : public QObject, public djaudio::PlayerLoopCom
     void playerValueChangedBool(int player, QString name, bool v);
 };
 
-class EngineQueryCommand : public QObject, public djaudio::MasterCommand {
+//runs in its own thread, relaying the state the audio thread publishes every period
+//and taking back the commands the audio thread is done with
+class Consumer : public QObject {
   Q_OBJECT
   public:
-    EngineQueryCommand(int num_players, QObject * parent = NULL);
-    virtual bool delete_after_done();
-    virtual void execute(const djaudio::Transport& transport);
-    virtual void execute_done();
-    virtual bool store(djaudio::CommandIOData& /* data */) const;
+    Consumer(djaudio::Scheduler * scheduler, const djaudio::EngineState * state, QObject * parent = nullptr);
+    void grabCommands();
   signals:
     void playerValueUpdateBool(int player, QString name, bool val);
     void playerValueUpdateInt(int player, QString name, int val);
     void playerValueUpdateDouble(int player, QString name, double val);
     void masterValueUpdateDouble(QString name, double val);
   private:
-    QList<EnginePlayerState *> mPlayerStates;
-    double mMasterBPM;
-    double mMasterVolume;
+    void report();
+
+    djaudio::Scheduler * mScheduler;
+    const djaudio::EngineState * mState;
+    djaudio::EngineState::master_t mMasterState;
+    std::vector<djaudio::EngineState::player_t> mPlayerStates;
+    std::vector<unsigned int> mStarved;
+    //the periods published when we last ran the done actions
+    unsigned long mDonePeriods = 0;
 };
 
 class MasterSyncToPlayerCommand : public QObject, public djaudio::MasterIntCommand {
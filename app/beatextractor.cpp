@@ -78,6 +78,7 @@ bool BeatExtractor::process(const djaudio::AudioBufferPtr audio_buffer, djaudio:
   features = mPlugin->getRemainingFeatures();
   for (unsigned int f = 0; f < features[beat_output_index].size(); f++)
     beat_buffer->push_back(Vamp::RealTime::realTime2Frame(features[beat_output_index][f].timestamp, audio_buffer->sample_rate()));
+  beat_buffer->update();
 
   emit(progress(100));
   return true;
@@ -27,6 +27,7 @@
 #include <QDebug>
 
 #include <iostream>
+#include <algorithm>
 using std::cerr;
 using std::cout;
 
@@ -171,6 +172,24 @@ void Configuration::load_file(const QString& path) throw(std::runtime_error) {
 
     try {
       if (root["eq"]) {
+        if (root["eq"]["type"]) {
+          QString type = QString::fromStdString(root["eq"]["type"].as<std::string>()).trimmed();
+          if (type == "builtin" || type == "lv2")
+            mEqBuiltin = type == "builtin";
+          else
+            cerr << "eq:type must be builtin or lv2" << std::endl;
+        } else if (root["eq"]["uri"]) {
+          //configs from before the builtin eq name the plugin they use, keep using it
+          mEqBuiltin = false;
+        }
+        if (root["eq"]["crossovers"]) {
+          if (root["eq"]["crossovers"].size() == 2) {
+            for (int i = 0; i < 2; i++)
+              mEqCrossovers[i] = root["eq"]["crossovers"][i].as<float>();
+          } else {
+            cerr << "eq:crossovers must be of length 2" << std::endl;
+          }
+        }
         if (root["eq"]["uri"]) {
           mEqPluginURI = QString::fromStdString(root["eq"]["uri"].as<std::string>());
         }
@@ -196,6 +215,36 @@ void Configuration::load_file(const QString& path) throw(std::runtime_error) {
       }
     } catch (...) { /* do nothing */ }
 
+    try {
+      if (root["playback"] && root["playback"]["interpolation"]) {
+        QString mode = QString::fromStdString(root["playback"]["interpolation"].as<std::string>()).trimmed();
+        mPlaybackInterpolation = djaudio::interpolation_from_string(mode, mPlaybackInterpolation);
+      }
+      if (root["playback"] && root["playback"]["keylock"])
+        mPlaybackKeyLock = root["playback"]["keylock"].as<bool>();
+      if (root["playback"] && root["playback"]["storage"]) {
+        QString storage = QString::fromStdString(root["playback"]["storage"].as<std::string>()).trimmed();
+        mPlaybackStorage = djaudio::sample_storage_from_string(storage, mPlaybackStorage);
+      }
+      if (root["playback"] && root["playback"]["cache"])
+        mPlaybackCache = root["playback"]["cache"].as<bool>();
+      if (root["playback"] && root["playback"]["cache_max_mb"])
+        mPlaybackCacheMaxMB = root["playback"]["cache_max_mb"].as<int>();
+      if (root["playback"] && root["playback"]["cache_resident_seconds"])
+        mPlaybackCacheResidentSeconds = root["playback"]["cache_resident_seconds"].as<double>();
+    } catch (...) { /* do nothing */ }
+
+    try {
+      if (root["engine"] && root["engine"]["decks"])
+        mEngineDecks = std::max(1, root["engine"]["decks"].as<int>());
+      if (root["engine"] && root["engine"]["sends"])
+        mEngineSends = std::max(0, root["engine"]["sends"].as<int>());
+      if (root["engine"] && root["engine"]["worker_threads"])
+        mEngineWorkerThreads = root["engine"]["worker_threads"].as<int>();
+      if (root["engine"] && root["engine"]["midi_latency_ms"])
+        mEngineMIDILatencyMS = std::max(0.0, root["engine"]["midi_latency_ms"].as<double>());
+    } catch (...) { /* do nothing */ }
+
 
   } catch (...){
     mValidFile = false;
@@ -234,6 +283,8 @@ QString Configuration::db_username() const { return mDBUserName; }
 QString Configuration::db_host() const { return mDBHost; }
 int Configuration::db_port() const { return mDBPort; }
 
+bool Configuration::eq_builtin() const { return mEqBuiltin; }
+float Configuration::eq_crossover(unsigned int index) const { return mEqCrossovers[std::min(index, 1u)]; }
 QString Configuration::eq_uri() const { return mEqPluginURI; }
 QString Configuration::eq_port_symbol(dj::eq_band_t band) const { return mEqPluginSymbol[band]; }
 float Configuration::eq_band_db_scale(dj::eq_band_t band) const { return mEqPluginDBScale[band]; }
@@ -258,6 +309,48 @@ double Configuration::import_max_seconds() const {
   return mImportMaxSeconds;
 }
 
+djaudio::interpolation_t Configuration::playback_interpolation() const {
+  return mPlaybackInterpolation;
+}
+
+bool Configuration::playback_keylock() const {
+  return mPlaybackKeyLock;
+}
+
+djaudio::sample_storage_t Configuration::playback_storage() const {
+  return mPlaybackStorage;
+}
+
+QString Configuration::playback_cache_dir() const {
+  if (!mPlaybackCache)
+    return QString();
+  return QFileInfo(mAnnotationDir).dir().filePath("pcmcache");
+}
+
+qint64 Configuration::playback_cache_max_bytes() const {
+  return mPlaybackCacheMaxMB * 1024 * 1024;
+}
+
+double Configuration::playback_cache_resident_seconds() const {
+  return mPlaybackCacheResidentSeconds;
+}
+
+unsigned int Configuration::engine_decks() const {
+  return mEngineDecks;
+}
+
+unsigned int Configuration::engine_sends() const {
+  return mEngineSends;
+}
+
+int Configuration::engine_worker_threads() const {
+  return mEngineWorkerThreads;
+}
+
+double Configuration::engine_midi_latency_ms() const {
+  return mEngineMIDILatencyMS;
+}
+
 void Configuration::restore_defaults() {
   mDBUserName = "user";
   mDBPassword = "";
@@ -36,6 +36,8 @@
 #include <yaml-cpp/yaml.h>
 #include <array>
 #include "defines.hpp"
+#include "interpolation.hpp"
+#include "sampleformat.hpp"
 
 namespace dj {
   class Configuration {
@@ -58,6 +60,10 @@ namespace dj {
       QString db_host() const;
       int db_port() const;
 
+      //the engine's own eq rather than an lv2 plugin, the default unless the config gives a plugin uri without a type
+      bool eq_builtin() const;
+      //the builtin eq's frequencies between the low and mid bands at 0, the mid and high bands at 1
+      float eq_crossover(unsigned int index) const;
       QString eq_uri() const;
       QString eq_port_symbol(dj::eq_band_t band) const;
       //zero for no db scaling
@@ -76,6 +82,26 @@ namespace dj {
 
       const QStringList& import_ignores() const;
       double import_max_seconds() const;
+
+      //how the players resample audio when not playing at the original speed
+      djaudio::interpolation_t playback_interpolation() const;
+      //if the players start with key lock on, keeping the pitch when the speed changes
+      bool playback_keylock() const;
+      //how loaded tracks are kept in memory
+      djaudio::sample_storage_t playback_storage() const;
+      //where decoded tracks are cached, next to the annotation dir, empty if the cache is disabled
+      QString playback_cache_dir() const;
+      qint64 playback_cache_max_bytes() const;
+      //seconds of a cached track to keep in memory around the play head, 0 reads the whole track in
+      double playback_cache_resident_seconds() const;
+
+      //the number of players and of send effect buses the engine is set up with
+      unsigned int engine_decks() const;
+      unsigned int engine_sends() const;
+      //threads besides the audio thread that render players, -1 picks one per spare core, 0 renders in the audio thread
+      int engine_worker_threads() const;
+      //how far ahead midi commands are scheduled, long enough for the router to get them to the engine
+      double engine_midi_latency_ms() const;
     private:
       bool db_get(YAML::Node& doc, QString entry, QString &result);
       QString mFile;
@@ -87,6 +113,8 @@ namespace dj {
       QString mDBHost;
       int mDBPort;
 
+      bool mEqBuiltin = true;
+      std::array<float, 2> mEqCrossovers = std::array<float, 2>{250.0f, 2500.0f};
       QString mEqPluginURI = "http://plugin.org.uk/swh-plugins/dj_eq";
       std::array<QString, 3> mEqPluginSymbol = std::array<QString,3>{"lo", "mid", "hi"};
       std::array<float, 3> mEqPluginDBScale = std::array<float,3>{0.0f, 0.0f, 0.0f};
@@ -113,6 +141,18 @@ namespace dj {
 
       double mImportMaxSeconds = 60.0 * 20.0;
 
+      djaudio::interpolation_t mPlaybackInterpolation = djaudio::INTERPOLATE_CUBIC;
+      bool mPlaybackKeyLock = false;
+      djaudio::sample_storage_t mPlaybackStorage = djaudio::STORAGE_FLOAT;
+      bool mPlaybackCache = true;
+      qint64 mPlaybackCacheMaxMB = 4096;
+      double mPlaybackCacheResidentSeconds = 60.0;
+
+      unsigned int mEngineDecks = 2;
+      unsigned int mEngineSends = 2;
+      int mEngineWorkerThreads = -1;
+      double mEngineMIDILatencyMS = 25.0;
+
     protected:
       Configuration();
       Configuration(const Configuration&);
@@ -11,6 +11,8 @@
 #define DO_STRINGIFY(X) #X
 #define STRINGIFY(X) DO_STRINGIFY(X)
 #define INAUDIBLE_VOLUME 0.001f
+//gain changes are spread over this long so they don't click
+#define GAIN_SMOOTHING_SECONDS 0.010
 
 namespace dj {
   enum eq_band_t {LOW = 0, MID = 1, HIGH = 2};
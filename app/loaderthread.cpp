@@ -1,4 +1,5 @@
 #include "loaderthread.h"
+#include "config.hpp"
 #include <QMutexLocker>
 
 using namespace djaudio;
@@ -16,9 +17,13 @@ LoaderThread::LoaderThread(int player_index, QObject * parent) :
 void LoaderThread::progress_callback(int percent, void *objPtr) {
   //XXX lock mutex?
   LoaderThread * self = (LoaderThread *)objPtr;
+  if (!self->mPublished && self->mAudioBuffer->decoded_frames() > 0)
+    self->publish();
   //only every 5 percent
-  if (percent % 5 == 0)
+  if (percent % 5 == 0 && percent != self->mPercentLast) {
+    self->mPercentLast = percent;
     self->relay_load_progress(percent);
+  }
 }
 
 void LoaderThread::abort() {
@@ -32,6 +37,12 @@ void LoaderThread::relay_load_progress(int percent) {
   emit(playerValueChangedInt(mPlayerIndex, "load_percent", percent));
 }
 
+void LoaderThread::publish() {
+  mPublished = true;
+  emit(loadComplete(mPlayerIndex, mAudioBuffer, mBeatBuffer));
+  emit(playerValueChangedString(mPlayerIndex, "work_info", mSongInfo));
+}
+
 void LoaderThread::load(QString audio_file_location, QString annotation_file_location, QString songinfo) {
   QMutexLocker lock(&mMutex);
   mAborted = false;
@@ -52,8 +63,12 @@ void LoaderThread::run() {
   try {
     mAudioBuffer.reset();
     mBeatBuffer.reset();
+    mPublished = false;
+    mPercentLast = -1;
 
-    mAudioBuffer = AudioBufferPtr(new AudioBuffer(mAudioFileName));
+    dj::Configuration * config = dj::Configuration::instance();
+    mAudioBuffer = AudioBufferPtr(new AudioBuffer(mAudioFileName, AudioBuffer::PLANAR, config->playback_storage()));
+    mAudioBuffer->cache(config->playback_cache_dir(), config->playback_cache_max_bytes(), config->playback_cache_resident_seconds());
 
     if (!mAnnotationFileName.isEmpty()) {
       djaudio::Annotation annotation;
@@ -64,8 +79,8 @@ void LoaderThread::run() {
     }
 
     if (mAudioBuffer->load(LoaderThread::progress_callback, this)) {
-      emit(loadComplete(mPlayerIndex, mAudioBuffer, mBeatBuffer));
-      emit(playerValueChangedString(mPlayerIndex, "work_info", mSongInfo));
+      if (!mPublished)
+        publish();
     } else
       emit(playerValueChangedString(mPlayerIndex, "load_error", "problem loading audio file: " + mAudioFileName));
   } catch (std::exception& e) {
@@ -22,6 +22,8 @@ namespace djaudio {
       void loadComplete(int player, djaudio::AudioBufferPtr audio_buffer, djaudio::BeatBufferPtr beat_buffer);
     protected:
       void relay_load_progress(int percent);
+      //hand the buffer to the player as soon as there is something to play
+      void publish();
     private:
       int mPlayerIndex = 0;
 
@@ -34,6 +36,8 @@ namespace djaudio {
 
       QMutex mMutex;
       bool mAborted;
+      bool mPublished = false;
+      int mPercentLast = -1;
   };
 }
 
@@ -14,6 +14,7 @@
 #include "midirouter.h"
 #include "config.hpp"
 #include "oscsender.h"
+#include "profilemonitor.h"
 #include "historymanager.h"
 #include "nsm.h"
 
@@ -149,15 +150,15 @@ static int startApp(QApplication * app, QString jackClientName, nsm_client_t * n
   midiThread->start(QThread::HighPriority);
   midiProcessTimer->start();
 
-  QObject::connect(midi, &MidiRouter::playerValueChangedDouble, audio, &AudioModel::playerSetValueDouble);
-  QObject::connect(midi, &MidiRouter::playerValueChangedInt,    audio, &AudioModel::playerSetValueInt);
-  QObject::connect(midi, &MidiRouter::playerValueChangedBool,   audio, &AudioModel::playerSetValueBool);
-  QObject::connect(midi, &MidiRouter::playerTriggered,          audio, &AudioModel::playerTrigger);
+  QObject::connect(midi, &MidiRouter::playerValueChangedDouble, audio, &AudioModel::midiPlayerSetValueDouble);
+  QObject::connect(midi, &MidiRouter::playerValueChangedInt,    audio, &AudioModel::midiPlayerSetValueInt);
+  QObject::connect(midi, &MidiRouter::playerValueChangedBool,   audio, &AudioModel::midiPlayerSetValueBool);
+  QObject::connect(midi, &MidiRouter::playerTriggered,          audio, &AudioModel::midiPlayerTrigger);
 
-  QObject::connect(midi, &MidiRouter::masterValueChangedDouble, audio, &AudioModel::masterSetValueDouble);
-  QObject::connect(midi, &MidiRouter::masterValueChangedInt,    audio, &AudioModel::masterSetValueInt);
-  QObject::connect(midi, &MidiRouter::masterValueChangedBool,   audio, &AudioModel::masterSetValueBool);
-  QObject::connect(midi, &MidiRouter::masterTriggered,          audio, &AudioModel::masterTrigger);
+  QObject::connect(midi, &MidiRouter::masterValueChangedDouble, audio, &AudioModel::midiMasterSetValueDouble);
+  QObject::connect(midi, &MidiRouter::masterValueChangedInt,    audio, &AudioModel::midiMasterSetValueInt);
+  QObject::connect(midi, &MidiRouter::masterValueChangedBool,   audio, &AudioModel::midiMasterSetValueBool);
+  QObject::connect(midi, &MidiRouter::masterTriggered,          audio, &AudioModel::midiMasterTrigger);
   QObject::connect(midi, &MidiRouter::playerTriggered, loader, &AudioLoader::playerTrigger);
 
   QErrorMessage * midiErrors = new QErrorMessage;
@@ -184,9 +185,24 @@ static int startApp(QApplication * app, QString jackClientName, nsm_client_t * n
   QObject::connect(audio, &AudioModel::masterValueChangedBool,   osc_send, &OSCSender::masterSetValueBool);
   QObject::connect(audio, &AudioModel::masterTriggered,          osc_send, &OSCSender::masterTrigger);
 
+  //report the engine's timings and xruns
+  ProfileMonitor * profile = new ProfileMonitor(audio->audioio()->master()->profiler());
+  QThread * profileThread = new QThread;
+  profile->moveToThread(profileThread);
+  QTimer * profileProcessTimer = new QTimer();
+  profileProcessTimer->setInterval(50);
+  QObject::connect(profileProcessTimer, &QTimer::timeout, profile, &ProfileMonitor::process);
+  QObject::connect(profileThread, &QThread::finished, profileProcessTimer, &QTimer::stop);
+  profileThread->start(QThread::LowPriority);
+  profileProcessTimer->start();
+
+  QObject::connect(profile, &ProfileMonitor::stageReport, osc_send, &OSCSender::profileStage);
+  QObject::connect(profile, &ProfileMonitor::xrun,        osc_send, &OSCSender::profileXrun);
+
 
   MainWindow * w = new MainWindow(db, audio);
   w->loader(loader);
+  w->profiler(profile);
   QObject::connect(history, &HistoryManager::workHistoryChanged, w, &MainWindow::workUpdateHistory);
   QObject::connect(midi, &MidiRouter::masterValueChangedInt,     w, &MainWindow::masterSetValueInt);
 
@@ -198,9 +214,10 @@ static int startApp(QApplication * app, QString jackClientName, nsm_client_t * n
   });
   del->start(10);
 
-  QObject::connect(app, &QApplication::aboutToQuit, [audio, w, midiThread] {
+  QObject::connect(app, &QApplication::aboutToQuit, [audio, w, midiThread, profileThread] {
     w->finalize();
     midiThread->quit();
+    profileThread->quit();
     audio->prepareToQuit();
     QThread::msleep(200);
   });
@@ -9,12 +9,15 @@
 #include "workfilterview.h"
 #include "tagmodel.h"
 #include "tagsview.h"
+#include "profilemonitor.h"
+#include "profileview.h"
 
 #include <QSqlQueryModel>
 #include <QToolButton>
 #include <QSettings>
 #include <QTimer>
 #include <QMessageBox>
+#include <QMenuBar>
 
 MainWindow::MainWindow(DB *db, AudioModel * audio, QWidget *parent) :
   QMainWindow(parent),
@@ -124,6 +127,21 @@ void MainWindow::loader(AudioLoader * loader) {
   connect(loader, &AudioLoader::playerBuffersChanged, mixer, &MixerPanelView::playerSetBuffers);
 }
 
+void MainWindow::profiler(ProfileMonitor * monitor) {
+  ProfileView * view = new ProfileView(this);
+  view->setWindowFlags(Qt::Window);
+  connect(monitor, &ProfileMonitor::stageReport, view, &ProfileView::stageReport);
+  connect(monitor, &ProfileMonitor::reportDone, view, &ProfileView::reportDone);
+  connect(monitor, &ProfileMonitor::xrun, view, &ProfileView::xrun);
+
+  QMenu * debug = menuBar()->addMenu(tr("debug"));
+  QAction * show = debug->addAction(tr("engine performance"));
+  connect(show, &QAction::triggered, [view]() {
+    view->show();
+    view->raise();
+  });
+}
+
 void MainWindow::readSettings() {
   QSettings settings;
   settings.beginGroup("WorkFilterModelCollection");
@@ -13,6 +13,7 @@ class AudioModel;
 class AudioLoader;
 class WorkFilterModelCollection;
 class WorkFilterView;
+class ProfileMonitor;
 
 class MainWindow : public QMainWindow
 {
@@ -21,6 +22,7 @@ class MainWindow : public QMainWindow
   public:
     explicit MainWindow(DB* db, AudioModel * audio, QWidget *parent = 0);
     void loader(AudioLoader * loader);
+    void profiler(ProfileMonitor * monitor);
     ~MainWindow();
   public slots:
     void readSettings();
@@ -15,7 +15,7 @@ namespace {
   };
 
   QList<QString> player_bool = {
-     "sync", "cue", "bump_fwd", "bump_back",
+     "sync", "cue", "bump_fwd", "bump_back", "keylock",
   };
 
   QList<QString> player_continuous = {
@@ -219,9 +219,9 @@ void MidiRouter::process() {
             if (mmap->midi_type == CC && value <= 0)
               continue;
             if (player < 0)
-              emit(masterTriggered(signal_name));
+              emit(masterTriggered(signal_name, buff.frame));
             else
-              emit(playerTriggered(player, signal_name));
+              emit(playerTriggered(player, signal_name, buff.frame));
             break;
           case TWOS_COMPLEMENT:
             //if the top bit is set it is negative, we don't scale 2s complement by 127
@@ -233,19 +233,19 @@ void MidiRouter::process() {
           case CONTINUOUS:
             if (double_signal(signal_name)) {
               if (player < 0)
-                emit(masterValueChangedDouble(signal_name, value));
+                emit(masterValueChangedDouble(signal_name, value, buff.frame));
               else
-                emit(playerValueChangedDouble(player, signal_name, value));
+                emit(playerValueChangedDouble(player, signal_name, value, buff.frame));
             } else {
               if (player < 0)
-                emit(masterValueChangedInt(signal_name, intvalue));
+                emit(masterValueChangedInt(signal_name, intvalue, buff.frame));
               else
-                emit(playerValueChangedInt(player, signal_name, intvalue));
+                emit(playerValueChangedInt(player, signal_name, intvalue, buff.frame));
             }
             break;
           case BOOL:
             if (player >= 0)
-              emit (playerValueChangedBool(player, signal_name, buff.data[2] > 0 && status != JackCpp::MIDIPort::NOTEOFF));
+              emit (playerValueChangedBool(player, signal_name, buff.data[2] > 0 && status != JackCpp::MIDIPort::NOTEOFF, buff.frame));
             break;
           case SHIFT:
             break;
@@ -23,15 +23,16 @@ class MidiRouter : public QObject {
   public:
     explicit MidiRouter(djaudio::AudioIO::midi_ringbuff_t *ringbuf, QObject *parent = 0);
   signals:
-    void playerValueChangedDouble(int player, QString name, double v);
-    void playerValueChangedInt(int player, QString name, int v);
-    void playerValueChangedBool(int player, QString name, bool v);
-    void playerTriggered(int player, QString name);
+    //frame is the jack frame time of the midi event
+    void playerValueChangedDouble(int player, QString name, double v, unsigned int frame);
+    void playerValueChangedInt(int player, QString name, int v, unsigned int frame);
+    void playerValueChangedBool(int player, QString name, bool v, unsigned int frame);
+    void playerTriggered(int player, QString name, unsigned int frame);
 
-    void masterValueChangedDouble(QString name, double v);
-    void masterValueChangedInt(QString name, int v);
-    void masterValueChangedBool(QString name, bool v);
-    void masterTriggered(QString name);
+    void masterValueChangedDouble(QString name, double v, unsigned int frame);
+    void masterValueChangedInt(QString name, int v, unsigned int frame);
+    void masterValueChangedBool(QString name, bool v, unsigned int frame);
+    void masterTriggered(QString name, unsigned int frame);
 
     void mappingError(QString message);
 
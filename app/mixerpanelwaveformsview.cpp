@@ -65,9 +65,17 @@ void MixerPanelWaveformsView::playerSetBuffers(int player, djaudio::AudioBufferP
 }
 
 void MixerPanelWaveformsView::playerSetValueInt(int player, QString name, int v) {
-  if (player >= mNumPlayers || player < 0 || name != "position_frame")
+  if (player >= mNumPlayers || player < 0)
     return;
   player *= 2;
+  //the buffer is shown while it is still loading, redraw as more of it comes in
+  if (name == "load_percent") {
+    mWaveforms[player]->refreshLines();
+    mWaveforms[player + 1]->refreshLines();
+    return;
+  }
+  if (name != "position_frame")
+    return;
   mWaveforms[player]->setPositionFrame(v);
   mWaveforms[player + 1]->setPositionFrame(v);
   update();
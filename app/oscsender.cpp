@@ -83,3 +83,14 @@ void OSCSender::masterTrigger(QString name) {
   lo_send(mAddress, "/master/trigger", "s", qPrintable(name));
 }
 
+void OSCSender::profileStage(QString stage, double p50, double p99, double max) {
+  if (!mAddress) { return; }
+  QString address = QString("/profile/%1").arg(stage);
+  lo_send(mAddress, qPrintable(address), "fff", static_cast<float>(p50), static_cast<float>(p99), static_cast<float>(max));
+}
+
+void OSCSender::profileXrun(int count, double period, double budget, QString culprit, double culprit_time) {
+  if (!mAddress) { return; }
+  lo_send(mAddress, "/profile/xrun", "iffsf", count, static_cast<float>(period), static_cast<float>(budget),
+      qPrintable(culprit), static_cast<float>(culprit_time));
+}
@@ -24,6 +24,9 @@ class OSCSender : public QObject {
     void masterSetValueInt(QString name, int v);
     void masterSetValueBool(QString name, bool v);
     void masterTrigger(QString name);
+
+    void profileStage(QString stage, double p50, double p99, double max);
+    void profileXrun(int count, double period, double budget, QString culprit, double culprit_time);
   private:
     lo_address mAddress = nullptr;
 };
@@ -0,0 +1,33 @@
+#include "profilemonitor.h"
+#include <QDateTime>
+
+namespace {
+  const qint64 report_interval_ms = 2000;
+}
+
+ProfileMonitor::ProfileMonitor(djaudio::Profiler * profiler, QObject * parent) :
+  QObject(parent),
+  mProfiler(profiler)
+{
+}
+
+void ProfileMonitor::process() {
+  if (mStats.update(mProfiler)) {
+    const djaudio::ProfileStats::xrun_t& x = mStats.last_xrun();
+    emit(xrun(x.count, x.period, x.budget, QString::fromStdString(x.culprit), x.culprit_time));
+  }
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  if (now - mLastReport < report_interval_ms)
+    return;
+  mLastReport = now;
+
+  std::vector<djaudio::ProfileStats::stage_stats_t> stats = mStats.stats();
+  for (unsigned int i = 0; i < stats.size(); i++) {
+    const djaudio::ProfileStats::stage_stats_t& s = stats[i];
+    emit(stageReport(QString::fromStdString(s.name), s.p50, s.p99, s.max));
+  }
+  if (stats.size())
+    emit(reportDone(mStats.period_budget()));
+  mStats.reset();
+}
@@ -0,0 +1,28 @@
+#ifndef PROFILEMONITOR_H
+#define PROFILEMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include "profiler.hpp"
+
+//drains the engine's profiler off the audio thread, reporting per stage timings every so often and xruns as they happen
+class ProfileMonitor : public QObject {
+  Q_OBJECT
+  public:
+    explicit ProfileMonitor(djaudio::Profiler * profiler, QObject * parent = nullptr);
+  signals:
+    //microseconds over the last report interval, stage is "schedule", "render/0" etc
+    void stageReport(QString stage, double p50, double p99, double max);
+    //the stats for an interval are complete
+    void reportDone(double budget);
+    //period is how long the late period took and budget how long it had, culprit is the stage furthest over its median
+    void xrun(int count, double period, double budget, QString culprit, double culprit_time);
+  public slots:
+    void process(); //grab samples and process them
+  private:
+    djaudio::Profiler * mProfiler;
+    djaudio::ProfileStats mStats;
+    qint64 mLastReport = 0;
+};
+
+#endif
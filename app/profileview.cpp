@@ -0,0 +1,59 @@
+#include "profileview.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QVBoxLayout>
+
+namespace {
+  enum column_t { P50, P99, MAX, WORST, COLUMNS };
+
+  QString micros(double v) { return QString::number(v, 'f', 1); }
+}
+
+ProfileView::ProfileView(QWidget * parent) : QWidget(parent) {
+  setWindowTitle(tr("engine performance"));
+  mTable = new QTableWidget(0, COLUMNS, this);
+  mTable->setHorizontalHeaderLabels(QStringList() << "p50 us" << "p99 us" << "max us" << "worst us");
+  mTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  mTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  mBudget = new QLabel(this);
+  mXrun = new QLabel(tr("no xruns"), this);
+  mXrun->setWordWrap(true);
+
+  QVBoxLayout * layout = new QVBoxLayout(this);
+  layout->addWidget(mTable);
+  layout->addWidget(mBudget);
+  layout->addWidget(mXrun);
+  resize(480, 360);
+}
+
+void ProfileView::stageReport(QString stage, double p50, double p99, double max) {
+  const int row = stageRow(stage);
+  const double worst = qMax(mWorst.value(stage, 0.0), max);
+  mWorst[stage] = worst;
+  const double values[] = {p50, p99, max, worst};
+  for (int c = 0; c < COLUMNS; c++)
+    mTable->item(row, c)->setText(micros(values[c]));
+}
+
+void ProfileView::reportDone(double budget) {
+  mBudget->setText(tr("period budget: %1 us").arg(micros(budget)));
+}
+
+void ProfileView::xrun(int count, double period, double budget, QString culprit, double culprit_time) {
+  mXrun->setText(tr("xruns: %1, the last one's period took %2 of %3 us, %4 took %5 us")
+      .arg(count).arg(micros(period)).arg(micros(budget)).arg(culprit.isEmpty() ? tr("unknown") : culprit).arg(micros(culprit_time)));
+}
+
+int ProfileView::stageRow(QString stage) {
+  auto it = mRows.find(stage);
+  if (it != mRows.end())
+    return it.value();
+  const int row = mTable->rowCount();
+  mTable->insertRow(row);
+  mTable->setVerticalHeaderItem(row, new QTableWidgetItem(stage));
+  for (int c = 0; c < COLUMNS; c++)
+    mTable->setItem(row, c, new QTableWidgetItem());
+  mRows[stage] = row;
+  return row;
+}
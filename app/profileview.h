@@ -0,0 +1,28 @@
+#ifndef PROFILEVIEW_H
+#define PROFILEVIEW_H
+
+#include <QWidget>
+#include <QHash>
+
+class QTableWidget;
+class QLabel;
+
+//a debug window with the engine's per stage timings and the last xrun
+class ProfileView : public QWidget {
+  Q_OBJECT
+  public:
+    explicit ProfileView(QWidget * parent = nullptr);
+  public slots:
+    void stageReport(QString stage, double p50, double p99, double max);
+    void reportDone(double budget);
+    void xrun(int count, double period, double budget, QString culprit, double culprit_time);
+  private:
+    int stageRow(QString stage);
+    QTableWidget * mTable;
+    QLabel * mBudget;
+    QLabel * mXrun;
+    QHash<QString, int> mRows;
+    QHash<QString, double> mWorst;
+};
+
+#endif
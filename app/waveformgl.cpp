@@ -282,6 +282,11 @@ void WaveFormGL::framesPerLine(int v) {
   updateLines();
 }
 
+void WaveFormGL::refreshLines() {
+  mXStartLast = -mWaveformLines.size();
+  updateLines();
+}
+
 void WaveFormGL::updateLines() {
   if (!mAudioBuffer)
     return;
@@ -308,37 +313,39 @@ void WaveFormGL::updateLines() {
   emit(waveformLinesRequested(mAudioBuffer, start_line, end_line, mFramesPerLine));
 }
 
-GLfloat WaveFormGL::lineHeight(int line_index) const {
-  //this is only called with a valid audio buffer
-  int start_frame = line_index * mFramesPerLine;
-
-  if (start_frame < 0 || start_frame >= (int)mAudioBuffer->length())
-    return (GLfloat)0.0;
-
-  int end_frame = std::min(start_frame + mFramesPerLine, (int)mAudioBuffer->length());
-  float value = 0;
-  for (int frame = start_frame; frame < end_frame; frame++) {
-    value = std::max(value, fabsf(mAudioBuffer->sample(0, frame)));
-    value = std::max(value, fabsf(mAudioBuffer->sample(1, frame)));
-  }
-  return (GLfloat)value;
-}
-
 namespace {
-  GLfloat lineHeight(djaudio::AudioBufferPtr buffer, int line_index, int frames_per_line) {
+  //the peak absolute value of the first two channels over a line's worth of frames
+  GLfloat peak(const djaudio::AudioBuffer * buffer, int line_index, int frames_per_line) {
     //this is only called with a valid audio buffer
     int start_frame = line_index * frames_per_line;
 
     if (start_frame < 0 || start_frame >= (int)buffer->length())
       return (GLfloat)0.0;
 
-    int end_frame = std::min(start_frame + frames_per_line, (int)buffer->length());
+    const int end_frame = std::min(start_frame + frames_per_line, (int)buffer->length());
+    const unsigned int channels = std::min(buffer->channels(), 2u);
     float value = 0;
-    for (int frame = start_frame; frame < end_frame; frame++) {
-      value = std::max(value, fabsf(buffer->sample(0, frame)));
-      value = std::max(value, fabsf(buffer->sample(1, frame)));
+    //read_block converts compact storage for us
+    float block[1024];
+    for (unsigned int c = 0; c < channels; c++) {
+      for (int frame = start_frame; frame < end_frame; frame += 1024) {
+        const unsigned int count = std::min(1024, end_frame - frame);
+        buffer->read_block(c, frame, block, count);
+        for (unsigned int i = 0; i < count; i++)
+          value = std::max(value, fabsf(block[i]));
+      }
     }
-    return (GLfloat)value;
+    return (GLfloat)(value * buffer->gain());
+  }
+}
+
+GLfloat WaveFormGL::lineHeight(int line_index) const {
+  return peak(mAudioBuffer.data(), line_index, mFramesPerLine);
+}
+
+namespace {
+  GLfloat lineHeight(djaudio::AudioBufferPtr buffer, int line_index, int frames_per_line) {
+    return peak(buffer.data(), line_index, frames_per_line);
   }
   QColor color_interp(const QColor& start, const QColor& end, double dist) {
    if (dist <= 0.0)
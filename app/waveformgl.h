@@ -108,6 +108,8 @@ class WaveFormGL : public QObject
     void setBeatBuffer(djaudio::BeatBufferPtr buffer);
     void setPositionFrame(int frame);
     void framesPerLine(int v);
+    //recompute all of the lines
+    void refreshLines();
     void draw();
     void drawText(QPainter * painter, float width_scale);
 
@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include "benchaudio.h"
+#include "stretcherrate.hpp"
+#include "stretcherwsola.hpp"
+#include <vector>
+
+using namespace djaudio;
+
+namespace {
+  //frames per iteration, about a jack period's worth of work for a few players
+  const unsigned int BLOCK_FRAMES = 1024;
+
+  //args: layout, storage
+  void layouts_and_storage(benchmark::internal::Benchmark * b) {
+    const int storage[] = {STORAGE_FLOAT, STORAGE_INT16, STORAGE_HALF};
+    for (int s : storage) {
+      if (s == STORAGE_FLOAT)
+        b->Args({AudioBuffer::INTERLEAVED, s});
+      b->Args({AudioBuffer::PLANAR, s});
+    }
+  }
+
+  AudioBuffer * buffer_for(benchmark::State& state) {
+    return bench_audio(static_cast<AudioBuffer::layout_t>(state.range(0)), static_cast<sample_storage_t>(state.range(1)));
+  }
+}
+
+static void BM_AudioBufferSample(benchmark::State& state) {
+  AudioBuffer * buffer = buffer_for(state);
+  unsigned int index = 0;
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < BLOCK_FRAMES; i++)
+      sum += buffer->sample(0, index + i) + buffer->sample(1, index + i);
+    benchmark::DoNotOptimize(sum);
+    index = (index + BLOCK_FRAMES) % (BENCH_AUDIO_FRAMES - BLOCK_FRAMES);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_AudioBufferSample)->Apply(layouts_and_storage);
+
+static void BM_AudioBufferSampleSubsample(benchmark::State& state) {
+  AudioBuffer * buffer = buffer_for(state);
+  unsigned int index = 0;
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < BLOCK_FRAMES; i++)
+      sum += buffer->sample(0, index + i, 0.25) + buffer->sample(1, index + i, 0.25);
+    benchmark::DoNotOptimize(sum);
+    index = (index + BLOCK_FRAMES) % (BENCH_AUDIO_FRAMES - BLOCK_FRAMES);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_AudioBufferSampleSubsample)->Apply(layouts_and_storage);
+
+static void BM_AudioBufferFillMono(benchmark::State& state) {
+  AudioBuffer * buffer = buffer_for(state);
+  std::vector<float> mono(BLOCK_FRAMES);
+  unsigned int index = 0;
+  for (auto _ : state) {
+    buffer->fill_mono(&mono.front(), BLOCK_FRAMES, index);
+    benchmark::DoNotOptimize(mono.front());
+    index = (index + BLOCK_FRAMES) % (BENCH_AUDIO_FRAMES - BLOCK_FRAMES);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_AudioBufferFillMono)->Apply(layouts_and_storage);
+
+namespace {
+  //args: interpolation, speed in percent, storage
+  void stretcher_args(benchmark::internal::Benchmark * b) {
+    const int modes[] = {INTERPOLATE_LINEAR, INTERPOLATE_CUBIC, INTERPOLATE_SINC};
+    for (int mode : modes) {
+      b->Args({mode, 100, STORAGE_FLOAT});
+      b->Args({mode, 107, STORAGE_FLOAT});
+      b->Args({mode, 107, STORAGE_INT16});
+    }
+  }
+
+  void setup_stretcher(benchmark::State& state, StretcherRate& stretcher) {
+    stretcher.audio_buffer(bench_audio(AudioBuffer::PLANAR, static_cast<sample_storage_t>(state.range(2))));
+    stretcher.speed(static_cast<double>(state.range(1)) / 100.0);
+  }
+
+  //start over well before the end so every block is a full one
+  void wrap(Stretcher& stretcher) {
+    if (stretcher.frame() > BENCH_AUDIO_FRAMES - 4 * BLOCK_FRAMES)
+      stretcher.frame(0);
+  }
+}
+
+static void BM_StretcherNextFrame(benchmark::State& state) {
+  StretcherRate stretcher(static_cast<interpolation_t>(state.range(0)));
+  setup_stretcher(state, stretcher);
+  float frame[2];
+  for (auto _ : state) {
+    for (unsigned int i = 0; i < BLOCK_FRAMES; i++) {
+      stretcher.next_frame(frame);
+      benchmark::DoNotOptimize(frame[0]);
+    }
+    wrap(stretcher);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_StretcherNextFrame)->Apply(stretcher_args);
+
+//the block path the player uses, for comparison with the frame at a time path above
+static void BM_StretcherNextBlock(benchmark::State& state) {
+  StretcherRate stretcher(static_cast<interpolation_t>(state.range(0)));
+  setup_stretcher(state, stretcher);
+  std::vector<float> left(BLOCK_FRAMES), right(BLOCK_FRAMES);
+  float * buffers[2] = {&left.front(), &right.front()};
+  for (auto _ : state) {
+    stretcher.next_block(buffers, 0, BLOCK_FRAMES);
+    benchmark::DoNotOptimize(left.front());
+    wrap(stretcher);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_StretcherNextBlock)->Apply(stretcher_args);
+
+//key lock, args: speed in percent, storage
+//the grains come once a hop so a block of this size sees a few, the rate is the average cost of each deck
+static void BM_StretcherKeyLockNextBlock(benchmark::State& state) {
+  StretcherWSOLA stretcher;
+  stretcher.setup(44100);
+  stretcher.audio_buffer(bench_audio(AudioBuffer::PLANAR, static_cast<sample_storage_t>(state.range(1))));
+  stretcher.speed(static_cast<double>(state.range(0)) / 100.0);
+  std::vector<float> left(BLOCK_FRAMES), right(BLOCK_FRAMES);
+  float * buffers[2] = {&left.front(), &right.front()};
+  for (auto _ : state) {
+    stretcher.next_block(buffers, 0, BLOCK_FRAMES);
+    benchmark::DoNotOptimize(left.front());
+    wrap(stretcher);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_StretcherKeyLockNextBlock)->Args({100, STORAGE_FLOAT})->Args({107, STORAGE_FLOAT})->Args({93, STORAGE_FLOAT})->Args({107, STORAGE_INT16});
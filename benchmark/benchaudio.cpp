@@ -0,0 +1,66 @@
+#include "benchaudio.h"
+#include <sndfile.hh>
+#include <QTemporaryFile>
+#include <QFile>
+#include <QDir>
+#include <map>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace djaudio;
+
+namespace {
+  //a wav file of a sine on each channel with some noise, written on first use and removed at exit
+  struct bench_file_t {
+    QString path;
+
+    bench_file_t() {
+      QTemporaryFile file(QDir::tempPath() + "/datajockey_benchmark_XXXXXX.wav");
+      file.setAutoRemove(false);
+      if (!file.open()) {
+        std::cerr << "cannot create a temporary file for the benchmark audio" << std::endl;
+        exit(1);
+      }
+      path = file.fileName();
+      file.close();
+
+      SndfileHandle sndfile(QFile::encodeName(path).constData(), SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_FLOAT, 2, 44100);
+      std::vector<float> interleaved(2 * BENCH_AUDIO_FRAMES);
+      uint32_t noise = 1;
+      for (unsigned int i = 0; i < BENCH_AUDIO_FRAMES; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        const float white = static_cast<float>(noise >> 8) / static_cast<float>(1 << 23) - 1.0f;
+        interleaved[2 * i] = 0.5f * static_cast<float>(sin(2.0 * M_PI * 440.0 * i / 44100.0)) + 0.1f * white;
+        interleaved[2 * i + 1] = 0.5f * static_cast<float>(sin(2.0 * M_PI * 660.0 * i / 44100.0)) - 0.1f * white;
+      }
+      sndfile.writef(&interleaved.front(), BENCH_AUDIO_FRAMES);
+    }
+
+    ~bench_file_t() {
+      QFile::remove(path);
+    }
+  };
+
+  QString bench_file() {
+    static bench_file_t file;
+    return file.path;
+  }
+}
+
+AudioBuffer * bench_audio(AudioBuffer::layout_t layout, sample_storage_t storage) {
+  static std::map<std::pair<int, int>, AudioBuffer *> buffers;
+  const std::pair<int, int> key(layout, storage);
+  std::map<std::pair<int, int>, AudioBuffer *>::iterator it = buffers.find(key);
+  if (it != buffers.end())
+    return it->second;
+
+  AudioBuffer * buffer = new AudioBuffer(bench_file(), layout, storage);
+  if (!buffer->load()) {
+    std::cerr << "cannot load the benchmark audio" << std::endl;
+    exit(1);
+  }
+  buffers[key] = buffer;
+  return buffer;
+}
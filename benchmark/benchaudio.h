@@ -0,0 +1,12 @@
+#ifndef BENCHAUDIO_H
+#define BENCHAUDIO_H
+
+#include "audiobuffer.hpp"
+
+//a loaded buffer of synthesized stereo audio to benchmark against, shared by the benchmarks and kept for the run
+djaudio::AudioBuffer * bench_audio(djaudio::AudioBuffer::layout_t layout, djaudio::sample_storage_t storage);
+
+//frames in the bench audio
+const unsigned int BENCH_AUDIO_FRAMES = 44100 * 30;
+
+#endif // BENCHAUDIO_H
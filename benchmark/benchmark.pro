@@ -0,0 +1,112 @@
+QT       += core
+QT       -= gui
+
+TARGET = datajockey_benchmark
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG += c++11
+CONFIG += link_pkgconfig
+
+TEMPLATE = app
+
+INCLUDEPATH += /usr/local/include/
+
+macx {
+  INCLUDEPATH += /opt/local/include/
+  LIBS += -lsndfile -lvorbisfile -lmad -lbenchmark
+  LIBS += -L/usr/local/lib/ -L/opt/local/lib/
+  QMAKE_MAC_SDK = macosx10.9
+  QMAKE_MACOSX_DEPLOYMENT_TARGET = 10.9
+}
+
+unix:!macx {
+  PKGCONFIG += sndfile vorbisfile mad
+  PKGCONFIG += jack benchmark
+}
+
+LIBS += -lpthread
+
+#numbers from an optimized build, with the same float flags as the app
+QMAKE_CXXFLAGS += -fexceptions -O2
+DENORMAL_FLAGS = -msse -mfpmath=sse -ffast-math
+_TRAVIS = $$(TRAVIS)
+isEmpty(_TRAVIS) {
+	QMAKE_CXXFLAGS += $$DENORMAL_FLAGS
+}
+
+
+MOC_DIR = moc/
+OBJECTS_DIR = obj/
+
+SOURCES += main.cpp \
+    benchaudio.cpp \
+    audiobench.cpp \
+    enginebench.cpp \
+    ../app/config.cpp \
+    ../app/defines.cpp \
+    ../app/audio/transport.cpp \
+    ../app/audio/timepoint.cpp \
+    ../app/audio/stretcherrate.cpp \
+    ../app/audio/stretcherwsola.cpp \
+    ../app/audio/interpolation.cpp \
+    ../app/audio/simd.cpp \
+    ../app/audio/sampleformat.cpp \
+    ../app/audio/pcmcache.cpp \
+    ../app/audio/mappedfile.cpp \
+    ../app/audio/stretcher.cpp \
+    ../app/audio/soundfile.cpp \
+    ../app/audio/scheduler.cpp \
+    ../app/audio/envelope.cpp \
+    ../app/audio/command.cpp \
+    ../app/audio/commandpool.cpp \
+    ../app/audio/plugin.cpp \
+    ../app/audio/equalizer.cpp \
+    ../app/audio/audiobuffer.cpp \
+    ../app/audio/annotation.cpp \
+    ../app/audio/xing.c
+
+HEADERS += \
+    benchaudio.h \
+    ../app/config.hpp \
+    ../app/defines.hpp \
+    ../app/audio/types.hpp \
+    ../app/audio/transport.hpp \
+    ../app/audio/timepoint.hpp \
+    ../app/audio/stretcherrate.hpp \
+    ../app/audio/stretcherwsola.hpp \
+    ../app/audio/interpolation.hpp \
+    ../app/audio/simd.hpp \
+    ../app/audio/sampleformat.hpp \
+    ../app/audio/pcmcache.hpp \
+    ../app/audio/mappedfile.hpp \
+    ../app/audio/alignedallocator.hpp \
+    ../app/audio/stretcher.hpp \
+    ../app/audio/soundfile.hpp \
+    ../app/audio/scheduler.hpp \
+    ../app/audio/mpscqueue.hpp \
+    ../app/audio/envelope.hpp \
+    ../app/audio/command.hpp \
+    ../app/audio/commandpool.hpp \
+    ../app/audio/equalizer.hpp \
+    ../app/audio/audiobuffer.hpp \
+    ../app/audio/annotation.hpp \
+    ../app/audio/xing.h \
+    ../ext/jackcpp/include/jackringbuffer.hpp
+
+INCLUDEPATH += . \
+  ../app/ \
+  ../app/audio \
+  ../ext/jackcpp/include/
+
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../ext/build-yaml-cpp-default/release/ -lyaml-cpp
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../ext/build-yaml-cpp-default/debug/ -lyaml-cpp
+else:unix: LIBS += -L$$PWD/../ext/build-yaml-cpp-default/ -lyaml-cpp
+
+INCLUDEPATH += $$PWD/../ext/yaml-cpp/include
+DEPENDPATH += $$PWD/../ext/yaml-cpp/include
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/release/libyaml-cpp.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/debug/libyaml-cpp.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/release/yaml-cpp.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/debug/yaml-cpp.lib
+else:unix: PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/libyaml-cpp.a
@@ -0,0 +1,271 @@
+#include <benchmark/benchmark.h>
+#include "annotation.hpp"
+#include "timepoint.hpp"
+#include "envelope.hpp"
+#include "scheduler.hpp"
+#include "transport.hpp"
+#include "plugin.h"
+#include "equalizer.hpp"
+#include <vector>
+
+using namespace djaudio;
+
+namespace {
+  //a small deterministic generator so runs are comparable
+  class Random {
+    public:
+      Random() : mState(12345) { }
+      unsigned int next(unsigned int range) {
+        mState = mState * 1664525u + 1013904223u;
+        return (mState >> 8) % range;
+      }
+    private:
+      uint32_t mState;
+  };
+
+  class NullCommand : public Command {
+    public:
+      virtual void execute(const Transport& /*transport*/) { }
+      virtual bool store(CommandIOData& /*data*/) const { return false; }
+  };
+
+  //a beat every half second at 44.1khz
+  const int BEAT_FRAMES = 22050;
+  const unsigned int LOOKUPS = 1024;
+}
+
+static void BM_BeatIndex(benchmark::State& state) {
+  BeatBuffer beats;
+  for (int i = 0; i < state.range(0); i++)
+    beats.push_back(i * BEAT_FRAMES);
+  beats.update();
+
+  Random random;
+  std::vector<int> frames(LOOKUPS);
+  for (unsigned int i = 0; i < LOOKUPS; i++)
+    frames[i] = random.next(static_cast<unsigned int>(state.range(0) * BEAT_FRAMES));
+
+  for (auto _ : state) {
+    int sum = 0;
+    for (int frame : frames)
+      sum += beats.beat_index(frame);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * LOOKUPS);
+}
+//a short track to a very long one
+BENCHMARK(BM_BeatIndex)->RangeMultiplier(4)->Range(256, 16384);
+
+//the player's lookups, a period at a time through the track starting from the last beat found
+static void BM_BeatIndexCursor(benchmark::State& state) {
+  BeatBuffer beats;
+  for (int i = 0; i < state.range(0); i++)
+    beats.push_back(i * BEAT_FRAMES);
+  beats.update();
+
+  const int period = 256;
+  const int end = static_cast<int>(state.range(0)) * BEAT_FRAMES;
+  int frame = 0;
+  int beat = 0;
+  for (auto _ : state) {
+    int sum = 0;
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+      frame += period;
+      if (frame >= end)
+        frame = 0;
+      beat = beats.beat_index(frame, beat);
+      sum += beat;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * LOOKUPS);
+}
+BENCHMARK(BM_BeatIndexCursor)->RangeMultiplier(4)->Range(256, 16384);
+
+namespace {
+  std::vector<TimePoint> time_points(unsigned int count) {
+    Random random;
+    std::vector<TimePoint> points;
+    for (unsigned int i = 0; i < count; i++)
+      points.push_back(TimePoint(random.next(256), random.next(4), static_cast<double>(random.next(1000)) / 1000.0));
+    return points;
+  }
+}
+
+static void BM_TimePointAdd(benchmark::State& state) {
+  std::vector<TimePoint> points = time_points(LOOKUPS);
+  for (auto _ : state) {
+    TimePoint sum(0, 0);
+    for (const TimePoint& p : points)
+      sum += p;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * LOOKUPS);
+}
+BENCHMARK(BM_TimePointAdd);
+
+static void BM_TimePointSubtract(benchmark::State& state) {
+  std::vector<TimePoint> points = time_points(LOOKUPS);
+  for (auto _ : state) {
+    for (unsigned int i = 1; i < points.size(); i++) {
+      TimePoint diff = points[i] - points[i - 1];
+      benchmark::DoNotOptimize(diff);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (LOOKUPS - 1));
+}
+BENCHMARK(BM_TimePointSubtract);
+
+static void BM_TimePointCompare(benchmark::State& state) {
+  std::vector<TimePoint> points = time_points(LOOKUPS);
+  for (auto _ : state) {
+    unsigned int count = 0;
+    for (unsigned int i = 1; i < points.size(); i++) {
+      count += points[i] < points[i - 1];
+      count += points[i] == points[i - 1];
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * (LOOKUPS - 1) * 2);
+}
+BENCHMARK(BM_TimePointCompare);
+
+static void BM_EnvelopeValueStep(benchmark::State& state) {
+  //the player's fade envelope at 44.1khz
+  Envelope envelope(quarter_sin, 4410);
+  for (auto _ : state) {
+    double sum = 0.0;
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+      sum += envelope.value_step();
+      if (envelope.at_end())
+        envelope.reset();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * LOOKUPS);
+}
+BENCHMARK(BM_EnvelopeValueStep);
+
+namespace {
+  //run the audio side of the scheduler so it takes in what was sent and hands back what it is done with
+  void drain(Scheduler& scheduler, const Transport& transport) {
+    scheduler.execute_schedule(transport);
+    scheduler.execute_done_actions();
+  }
+
+  //fill a schedule with count commands spread over bars
+  std::vector<Scheduler::node_id_t> fill_schedule(Scheduler& scheduler, const Transport& transport, unsigned int count, unsigned int bars) {
+    Random random;
+    std::vector<Scheduler::node_id_t> ids;
+    for (unsigned int i = 0; i < count; i++) {
+      ids.push_back(scheduler.schedule(TimePoint(1 + random.next(bars), random.next(4), static_cast<double>(random.next(64)) / 64.0), new NullCommand));
+      //keep within the command queues
+      if (i % 256 == 255)
+        drain(scheduler, transport);
+    }
+    drain(scheduler, transport);
+    return ids;
+  }
+
+  //the scheduler doesn't clean up after itself, so give the commands back for the next run
+  void clear_schedule(Scheduler& scheduler, const Transport& transport, const std::vector<Scheduler::node_id_t>& ids) {
+    for (unsigned int i = 0; i < ids.size(); i++) {
+      scheduler.remove(ids[i]);
+      if (i % 256 == 255)
+        drain(scheduler, transport);
+    }
+    drain(scheduler, transport);
+  }
+}
+
+//add and remove one command in a schedule of a given size, each goes through the audio side
+static void BM_SchedulerAdd(benchmark::State& state) {
+  Scheduler scheduler;
+  Transport transport;
+  transport.setup(44100);
+  const unsigned int bars = 1024;
+  const std::vector<Scheduler::node_id_t> ids = fill_schedule(scheduler, transport, static_cast<unsigned int>(state.range(0)), bars);
+
+  Random random;
+  for (auto _ : state) {
+    Scheduler::node_id_t id = scheduler.schedule(TimePoint(1 + random.next(bars), random.next(4)), new NullCommand);
+    scheduler.execute_schedule(transport);
+    scheduler.remove(id);
+    drain(scheduler, transport);
+  }
+  clear_schedule(scheduler, transport, ids);
+}
+BENCHMARK(BM_SchedulerAdd)->RangeMultiplier(8)->Range(64, 32768);
+
+//run a large schedule block by block as the transport moves through it, as the audio thread does
+static void BM_SchedulerExecute(benchmark::State& state) {
+  Scheduler scheduler;
+  Transport transport;
+  transport.setup(44100);
+  transport.bpm(128.0);
+  const unsigned int bars = 256;
+  const std::vector<Scheduler::node_id_t> ids = fill_schedule(scheduler, transport, static_cast<unsigned int>(state.range(0)), bars);
+
+  const unsigned int block = 64;
+  for (auto _ : state) {
+    transport.tick(block);
+    if (transport.position().bar() > static_cast<int>(bars)) {
+      //jump back to the start
+      transport.position(TimePoint(0, 0));
+      scheduler.invalidate_schedule_pointers();
+    }
+    scheduler.execute_schedule(transport);
+  }
+  state.SetItemsProcessed(state.iterations() * block);
+  clear_schedule(scheduler, transport, ids);
+}
+BENCHMARK(BM_SchedulerExecute)->RangeMultiplier(8)->Range(64, 32768);
+
+namespace {
+  class NullPlugin : public AudioPlugin {
+    public:
+      virtual void setup(unsigned int /*sample_rate*/, unsigned int /*max_buffer_length*/) { }
+      virtual void compute(unsigned int nframes, float ** mixBuffer) { benchmark::DoNotOptimize(mixBuffer[0][nframes - 1]); }
+  };
+}
+
+//the cost of a send's chain around the plugins themselves
+static void BM_PluginChainCompute(benchmark::State& state) {
+  AudioPluginCollection collection;
+  for (int i = 0; i < state.range(0); i++) {
+    AudioPluginChainPtr chain(new AudioPluginChain(static_cast<unsigned int>(i + 1)));
+    chain->insert(collection.running(), i, AudioPluginPtr(new NullPlugin));
+    collection.swap(chain);
+  }
+
+  const unsigned int frames = 256;
+  std::vector<float> left(frames), right(frames);
+  float * buffers[2] = {&left.front(), &right.front()};
+  for (auto _ : state)
+    collection.compute(frames, buffers);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+//a send's plugin chain is a handful of plugins, the long chains show the cost per plugin
+BENCHMARK(BM_PluginChainCompute)->RangeMultiplier(4)->Range(4, 1024);
+
+//the builtin eq on a block of noise, with the bands moving as they do when a dj rides them
+static void BM_EqualizerCompute(benchmark::State& state) {
+  Equalizer eq;
+  eq.setup(44100, 250.0f, 2500.0f);
+  const unsigned int frames = static_cast<unsigned int>(state.range(0));
+  Random random;
+  std::vector<float> left(frames), right(frames);
+  for (unsigned int i = 0; i < frames; i++) {
+    left[i] = static_cast<float>(random.next(2000)) / 1000.0f - 1.0f;
+    right[i] = static_cast<float>(random.next(2000)) / 1000.0f - 1.0f;
+  }
+  float * buffers[2] = {&left.front(), &right.front()};
+  unsigned int block = 0;
+  for (auto _ : state) {
+    eq.band(dj::LOW, (block % 64) < 32 ? -1.0 : 0.0);
+    eq.compute(frames, buffers);
+    block++;
+  }
+  state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_EqualizerCompute)->Arg(64)->Arg(256)->Arg(1024);
@@ -0,0 +1,5 @@
+#include <benchmark/benchmark.h>
+
+//the benchmarks register themselves, see audiobench.cpp and enginebench.cpp
+//run with --benchmark_filter=<regex> to pick some, --benchmark_format=json to compare runs
+BENCHMARK_MAIN();
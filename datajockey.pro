@@ -1,4 +1,11 @@
 TEMPLATE = subdirs
 SUBDIRS = \
 	app/app.pro \
-	importer/importer.pro
+	importer/importer.pro \
+	offline/offline.pro \
+	test/test.pro
+
+#microbenchmarks of the engine's hot paths, needs google benchmark
+packagesExist(benchmark) {
+	SUBDIRS += benchmark/benchmark.pro
+}
@@ -50,6 +50,11 @@ SOURCES += main.cpp \
     ../app/audio/annotation.cpp \
     ../app/audio/audiobuffer.cpp \
     ../app/audio/soundfile.cpp \
+    ../app/audio/interpolation.cpp \
+    ../app/audio/simd.cpp \
+    ../app/audio/sampleformat.cpp \
+    ../app/audio/pcmcache.cpp \
+    ../app/audio/mappedfile.cpp \
     fileprocessor.cpp \
     ../app/db.cpp \
     ../app/audio/xing.c
@@ -63,6 +68,12 @@ HEADERS += \
     ../app/audio/annotation.hpp \
     ../app/audio/audiobuffer.hpp \
     ../app/audio/soundfile.hpp \
+    ../app/audio/interpolation.hpp \
+    ../app/audio/simd.hpp \
+    ../app/audio/sampleformat.hpp \
+    ../app/audio/pcmcache.hpp \
+    ../app/audio/mappedfile.hpp \
+    ../app/audio/alignedallocator.hpp \
     fileprocessor.h \
     ../app/db.h \
     ../app/audio/xing.h
@@ -0,0 +1,130 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include "offlinerenderer.h"
+#include "master.hpp"
+#include "config.hpp"
+
+#include <iostream>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace {
+  //two synthesized decks, a mix from one to the other with syncs, loops and eq moves
+  const char * default_script =
+    "0 load 0 synth 124\n"
+    "0 load 1 synth 128\n"
+    "0 xfade_players 0 1\n"
+    "0 xfade_on\n"
+    "0 xfade 0\n"
+    "0 master_sync 0\n"
+    "0 sync 0\n"
+    "0 play 0\n"
+    "4 sync 1\n"
+    "4 play 1\n"
+    "4 eq_low 1 -1\n"
+    "8 loop 0 4\n"
+    "10 xfade 0.5\n"
+    "12 eq_low 0 -1\n"
+    "12 eq_low 1 0\n"
+    "14 noloop 0\n"
+    "16 xfade 1\n"
+    "16 eq_high 0 -0.5\n"
+    "18 cue 0\n"
+    "20 loop 1 0.5\n"
+    "21 noloop 1\n"
+    "24 pause 0\n";
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication a(argc, argv);
+  QCoreApplication::setApplicationName("datajockey_offline");
+  QCoreApplication::setApplicationVersion("1.0git");
+  QCoreApplication::setOrganizationName("xnor");
+  QCoreApplication::setOrganizationDomain("x37v.info");
+
+  QCommandLineOption rateOption(QStringList() << "r" << "rate", "Sample rate.", "hz", "44100");
+  QCommandLineOption bufferOption(QStringList() << "b" << "buffer", "Frames per period.", "frames", "256");
+  QCommandLineOption secondsOption(QStringList() << "s" << "seconds", "Seconds of audio to render.", "seconds", "30");
+  QCommandLineOption decksOption(QStringList() << "d" << "decks", "Number of players, the configured number by default.", "count");
+  QCommandLineOption scriptOption(QStringList() << "t" << "timeline",
+      "Timeline script, one event per line: <seconds> <action> [player] [arguments..], a built in mix by default.\n"
+      "player actions: load <player> (synth [bpm] [seconds] | <audio file> [annotation file]), "
+      "play, pause, sync, nosync, mute, unmute, main, cue, keylock, nokeylock, noloop, loop <beats>, seek_beat <beat>, "
+      "volume, speed, eq_low, eq_mid, eq_high <value>, master_sync, xfade_players <right player>\n"
+      "master actions: xfade_on, xfade_off, xfade <position>, master_volume <value>, cue_volume <value>",
+      "file");
+  QCommandLineOption outputOption(QStringList() << "o" << "output", "Write the main mix to this wav file.", "file");
+  QCommandLineOption cueOutputOption(QStringList() << "c" << "cue-output", "Write the cue mix to this wav file.", "file");
+  QCommandLineOption configOption("config", "Configuration file, the default search locations otherwise.", "file");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("DataJockey offline renderer, runs the audio engine without jack and reports how long it took");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addOption(rateOption);
+  parser.addOption(bufferOption);
+  parser.addOption(secondsOption);
+  parser.addOption(decksOption);
+  parser.addOption(scriptOption);
+  parser.addOption(outputOption);
+  parser.addOption(cueOutputOption);
+  parser.addOption(configOption);
+
+  parser.process(a);
+
+  dj::Configuration * config = dj::Configuration::instance();
+  if (parser.isSet(configOption)) {
+    try {
+      config->load_file(parser.value(configOption));
+    } catch (std::runtime_error& e) {
+      cerr << "cannot load the configuration: " << e.what() << endl;
+      return 1;
+    }
+  } else {
+    config->load_default();
+  }
+
+  bool ok_rate = false, ok_buffer = false, ok_seconds = false, ok_decks = true;
+  const unsigned int rate = parser.value(rateOption).toUInt(&ok_rate);
+  const unsigned int buffer = parser.value(bufferOption).toUInt(&ok_buffer);
+  const double seconds = parser.value(secondsOption).toDouble(&ok_seconds);
+  unsigned int decks = config->engine_decks();
+  if (parser.isSet(decksOption))
+    decks = parser.value(decksOption).toUInt(&ok_decks);
+  if (!ok_rate || !ok_buffer || !ok_seconds || !ok_decks || rate == 0 || buffer == 0 || seconds <= 0 || decks == 0) {
+    cerr << "rate, buffer, seconds and decks must be positive numbers" << endl;
+    return 1;
+  }
+
+  QString script(default_script);
+  if (parser.isSet(scriptOption)) {
+    QFile file(parser.value(scriptOption));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      cerr << "cannot read " << qPrintable(file.fileName()) << endl;
+      return 1;
+    }
+    script = QTextStream(&file).readAll();
+  }
+
+  djaudio::Master * master = djaudio::Master::instance();
+  for (unsigned int i = 0; i < decks; i++)
+    master->add_player();
+
+  OfflineRenderer renderer(rate, buffer);
+  QString error;
+  if (!renderer.addScript(script, error)) {
+    cerr << "timeline: " << qPrintable(error) << endl;
+    return 1;
+  }
+  if (!renderer.render(seconds, parser.value(outputOption), parser.value(cueOutputOption), error)) {
+    cerr << qPrintable(error) << endl;
+    return 1;
+  }
+  renderer.report(cout);
+  return 0;
+}
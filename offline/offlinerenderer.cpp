@@ -0,0 +1,378 @@
+#include "offlinerenderer.h"
+#include "master.hpp"
+#include "player.hpp"
+#include "config.hpp"
+#include <sndfile.hh>
+#include <QTemporaryFile>
+#include <QRegularExpression>
+#include <QFile>
+#include <QDir>
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+using namespace djaudio;
+
+namespace {
+  const unsigned int OUTPUT_CHANNELS = 4; //main and cue, stereo
+  const double SYNTH_DEFAULT_BPM = 120.0;
+  const double SYNTH_DEFAULT_SECONDS = 120.0;
+
+  //whitespace separated, double quotes group
+  QStringList tokenize(const QString& line) {
+    QStringList tokens;
+    QRegularExpression re("\"([^\"]*)\"|(\\S+)");
+    QRegularExpressionMatchIterator it = re.globalMatch(line);
+    while (it.hasNext()) {
+      QRegularExpressionMatch match = it.next();
+      tokens << (match.capturedStart(1) >= 0 ? match.captured(1) : match.captured(2));
+    }
+    return tokens;
+  }
+
+  bool to_double(const QString& s, double& v) {
+    bool ok = false;
+    v = s.toDouble(&ok);
+    return ok;
+  }
+}
+
+OfflineRenderer::OfflineRenderer(unsigned int sampleRate, unsigned int bufferFrames) :
+  mMaster(Master::instance()),
+  mSampleRate(sampleRate),
+  mBufferFrames(bufferFrames),
+  mNextEvent(0),
+  mFrames(0),
+  mPeriods(0),
+  mOverruns(0),
+  mComputeNanos(0)
+{
+  mMaster->setup_audio(sampleRate, bufferFrames);
+}
+
+OfflineRenderer::~OfflineRenderer() {
+  //the commands that never ran are still ours
+  for (std::size_t i = mNextEvent; i < mEvents.size(); i++)
+    delete mEvents[i].command;
+}
+
+bool OfflineRenderer::addScript(const QString& script, QString& error) {
+  QStringList lines = script.split('\n');
+  for (int i = 0; i < lines.size(); i++) {
+    QString line = lines[i];
+    int comment = line.indexOf('#');
+    if (comment >= 0)
+      line.truncate(comment);
+    QStringList args = tokenize(line);
+    if (args.isEmpty())
+      continue;
+
+    double seconds = 0;
+    if (!to_double(args.takeFirst(), seconds) || seconds < 0 || args.isEmpty()) {
+      error = QString("line %1: expected <seconds> <action> [arguments..]").arg(i + 1);
+      return false;
+    }
+    if (!addEvent(seconds, args, error)) {
+      error = QString("line %1: %2").arg(i + 1).arg(error);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OfflineRenderer::addEvent(double seconds, const QStringList& args, QString& error) {
+  const unsigned int frame = static_cast<unsigned int>(seconds * mSampleRate + 0.5);
+  const QString action = args[0];
+  std::vector<Command *> commands;
+
+  //master actions
+  double value = 0;
+  if (action == "xfade_on" || action == "xfade_off") {
+    commands.push_back(new MasterBoolCommand(action == "xfade_on" ? MasterBoolCommand::XFADE : MasterBoolCommand::NO_XFADE));
+  } else if (action == "xfade" || action == "master_volume" || action == "cue_volume") {
+    if (args.size() != 2 || !to_double(args[1], value)) {
+      error = action + " expects a value";
+      return false;
+    }
+    MasterDoubleCommand::action_t a = MasterDoubleCommand::XFADE_POSITION;
+    if (action == "master_volume")
+      a = MasterDoubleCommand::MAIN_VOLUME;
+    else if (action == "cue_volume")
+      a = MasterDoubleCommand::CUE_VOLUME;
+    commands.push_back(new MasterDoubleCommand(a, value));
+  } else {
+    //player actions, the first argument is the player
+    bool ok = false;
+    const unsigned int player = args.size() > 1 ? args[1].toUInt(&ok) : 0;
+    if (!ok || player >= mMaster->players().size()) {
+      error = QString("%1 expects a player index below %2").arg(action).arg(mMaster->players().size());
+      return false;
+    }
+
+    const QStringList rest = args.mid(2);
+    if (action == "load") {
+      if (!load(rest, error))
+        return false;
+      commands.push_back(new PlayerSetAudioBufferCommand(player, mAudioBuffers.back().data()));
+      if (mBeatBuffers.back())
+        commands.push_back(new PlayerSetBeatBufferCommand(player, mBeatBuffers.back().data()));
+    } else if (action == "master_sync") {
+      commands.push_back(new MasterIntCommand(MasterIntCommand::SYNC_TO_PLAYER, player));
+    } else if (action == "xfade_players") {
+      unsigned int right = rest.size() == 1 ? rest[0].toUInt(&ok) : 0;
+      if (!ok || rest.size() != 1) {
+        error = "xfade_players expects a left and a right player";
+        return false;
+      }
+      commands.push_back(new MasterXFadeSelectCommand(player, right));
+    } else {
+      struct state_action_t { const char * name; PlayerStateCommand::action_t action; };
+      static const state_action_t state_actions[] = {
+        {"play", PlayerStateCommand::PLAY}, {"pause", PlayerStateCommand::PAUSE},
+        {"main", PlayerStateCommand::OUT_MAIN}, {"cue", PlayerStateCommand::OUT_CUE},
+        {"sync", PlayerStateCommand::SYNC}, {"nosync", PlayerStateCommand::NO_SYNC},
+        {"mute", PlayerStateCommand::MUTE}, {"unmute", PlayerStateCommand::NO_MUTE},
+        {"noloop", PlayerStateCommand::NO_LOOP},
+        {"keylock", PlayerStateCommand::KEYLOCK}, {"nokeylock", PlayerStateCommand::NO_KEYLOCK}
+      };
+      struct double_action_t { const char * name; PlayerDoubleCommand::action_t action; };
+      static const double_action_t double_actions[] = {
+        {"volume", PlayerDoubleCommand::VOLUME}, {"speed", PlayerDoubleCommand::PLAY_SPEED},
+        {"eq_low", PlayerDoubleCommand::EQ_LOW}, {"eq_mid", PlayerDoubleCommand::EQ_MID}, {"eq_high", PlayerDoubleCommand::EQ_HIGH}
+      };
+
+      for (const state_action_t& s : state_actions) {
+        if (action == s.name)
+          commands.push_back(new PlayerStateCommand(player, s.action));
+      }
+      if (commands.empty()) {
+        const bool has_value = rest.size() == 1 && to_double(rest[0], value);
+        for (const double_action_t& d : double_actions) {
+          if (action == d.name && has_value)
+            commands.push_back(new PlayerDoubleCommand(player, d.action, value));
+        }
+        if (action == "loop" && has_value && value > 0)
+          commands.push_back(new PlayerLoopCommand(player, value));
+        else if (action == "seek_beat" && has_value && value >= 0)
+          commands.push_back(new PlayerPositionCommand(player, PlayerPositionCommand::PLAY_BEAT, static_cast<int>(value)));
+        if (commands.empty()) {
+          bool takes_value = action == "loop" || action == "seek_beat";
+          for (const double_action_t& d : double_actions)
+            takes_value |= action == d.name;
+          error = takes_value ? QString("%1 expects a player and a value").arg(action) : QString("unknown action %1").arg(action);
+          return false;
+        }
+      }
+    }
+  }
+
+  //keep the events in time order, events at the same time in the order given
+  event_t e;
+  e.frame = frame;
+  std::vector<event_t>::iterator pos = std::upper_bound(mEvents.begin(), mEvents.end(), frame,
+      [](unsigned int f, const event_t& other) { return f < other.frame; });
+  for (Command * cmd : commands) {
+    e.command = cmd;
+    pos = mEvents.insert(pos, e) + 1;
+  }
+  return true;
+}
+
+bool OfflineRenderer::load(const QStringList& args, QString& error) {
+  if (args.isEmpty()) {
+    error = "load expects a player and a file or synth";
+    return false;
+  }
+
+  QString audio_file = args[0];
+  QString annotation_file = args.size() > 1 ? args[1] : QString();
+  bool temporary = false;
+  BeatBufferPtr beats;
+  if (audio_file == "synth") {
+    double bpm = SYNTH_DEFAULT_BPM;
+    double seconds = SYNTH_DEFAULT_SECONDS;
+    if ((args.size() > 1 && !to_double(args[1], bpm)) || (args.size() > 2 && !to_double(args[2], seconds)) || bpm < 20.0 || seconds <= 0) {
+      error = "load <player> synth [bpm] [seconds]";
+      return false;
+    }
+    audio_file = synthesize(bpm, seconds);
+    if (audio_file.isEmpty()) {
+      error = "cannot write a temporary file for the synthesized audio";
+      return false;
+    }
+    temporary = true;
+    annotation_file.clear();
+
+    beats = BeatBufferPtr(new BeatBuffer);
+    const double beat_frames = 60.0 * mSampleRate / bpm;
+    const double frames = seconds * mSampleRate;
+    for (double f = 0; f < frames; f += beat_frames)
+      beats->push_back(static_cast<int>(f + 0.5));
+    beats->update();
+  } else if (!annotation_file.isEmpty()) {
+    Annotation annotation;
+    if (!annotation.loadFile(annotation_file)) {
+      error = QString("cannot load the annotation %1").arg(annotation_file);
+      return false;
+    }
+    beats = annotation.beatBuffer();
+  }
+
+  AudioBufferPtr audio;
+  try {
+    audio = AudioBufferPtr(new AudioBuffer(audio_file, AudioBuffer::PLANAR, dj::Configuration::instance()->playback_storage()));
+    if (!audio->load())
+      audio.reset();
+  } catch (std::runtime_error& e) {
+    audio.reset();
+  }
+  //the samples are in memory now
+  if (temporary)
+    QFile::remove(audio_file);
+  if (!audio) {
+    error = QString("cannot load the audio file %1").arg(args[0]);
+    return false;
+  }
+
+  mAudioBuffers << audio;
+  mBeatBuffers << beats;
+  return true;
+}
+
+QString OfflineRenderer::synthesize(double bpm, double seconds) {
+  QTemporaryFile file(QDir::tempPath() + "/datajockey_offline_XXXXXX.wav");
+  file.setAutoRemove(false);
+  if (!file.open())
+    return QString();
+  const QString path = file.fileName();
+  file.close();
+
+  SndfileHandle sndfile(QFile::encodeName(path).constData(), SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_FLOAT, 2, mSampleRate);
+  if (sndfile.error() != SF_ERR_NO_ERROR) {
+    QFile::remove(path);
+    return QString();
+  }
+
+  //a pitched down kick on the beat, a noise hat on the off beat and a quiet saw bass, the hat off to one side
+  const double sr = mSampleRate;
+  const unsigned int frames = static_cast<unsigned int>(seconds * sr);
+  const double beat_frames = 60.0 * sr / bpm;
+  const unsigned int chunk = 4096;
+  std::vector<float> interleaved(2 * chunk);
+  uint32_t noise = 22222;
+  for (unsigned int start = 0; start < frames; start += chunk) {
+    const unsigned int count = std::min(chunk, frames - start);
+    for (unsigned int i = 0; i < count; i++) {
+      const double frame = start + i;
+      const double t = fmod(frame, beat_frames) / sr;
+      const double kick = 0.8 * sin(2.0 * M_PI * (50.0 * t + (100.0 / 30.0) * (1.0 - exp(-30.0 * t)))) * exp(-8.0 * t);
+
+      noise = noise * 1664525u + 1013904223u;
+      const double white = static_cast<double>(noise >> 8) / static_cast<double>(1 << 23) - 1.0;
+      const double off = fmod(frame + beat_frames / 2.0, beat_frames) / sr;
+      const double hat = 0.2 * white * exp(-60.0 * off);
+
+      const double phase = fmod(frame * 55.0 / sr, 1.0);
+      const double bass = 0.1 * (2.0 * phase - 1.0);
+
+      interleaved[2 * i] = static_cast<float>(kick + bass + 0.4 * hat);
+      interleaved[2 * i + 1] = static_cast<float>(kick + bass + hat);
+    }
+    sndfile.writef(&interleaved.front(), count);
+  }
+  return path;
+}
+
+bool OfflineRenderer::render(double seconds, const QString& outputFile, const QString& cueOutputFile, QString& error) {
+  std::vector<float> outputs[OUTPUT_CHANNELS];
+  JackCpp::AudioIO::audioBufVector buffers;
+  for (unsigned int i = 0; i < OUTPUT_CHANNELS; i++) {
+    outputs[i].resize(mBufferFrames);
+    buffers.push_back(&outputs[i].front());
+  }
+  std::vector<float> interleaved(2 * mBufferFrames);
+
+  SndfileHandle files[2];
+  const QString paths[2] = {outputFile, cueOutputFile};
+  for (unsigned int i = 0; i < 2; i++) {
+    if (paths[i].isEmpty())
+      continue;
+    files[i] = SndfileHandle(QFile::encodeName(paths[i]).constData(), SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_FLOAT, 2, mSampleRate);
+    if (files[i].error() != SF_ERR_NO_ERROR) {
+      error = QString("cannot write %1: %2").arg(paths[i]).arg(files[i].strError());
+      return false;
+    }
+  }
+
+  Scheduler * scheduler = mMaster->scheduler();
+  Profiler * profiler = mMaster->profiler();
+  const unsigned long total = static_cast<unsigned long>(seconds * mSampleRate);
+  unsigned long frame = 0;
+  while (frame < total) {
+    const unsigned int frames = static_cast<unsigned int>(std::min<unsigned long>(mBufferFrames, total - frame));
+
+    //hand over the events due this period, stamped so that they run at their frame, not at the period start
+    while (mNextEvent < mEvents.size() && mEvents[mNextEvent].frame < frame + frames) {
+      Command * cmd = mEvents[mNextEvent].command;
+      cmd->frame_stamp(mEvents[mNextEvent].frame - frames);
+      //the scheduler owns it now either way
+      mNextEvent++;
+      if (!scheduler->execute(cmd)) {
+        error = QString("command queue full at frame %1, the render would not match the script").arg(mEvents[mNextEvent - 1].frame);
+        return false;
+      }
+    }
+
+    scheduler->period_start(static_cast<unsigned int>(frame), frames);
+    const uint64_t start = Profiler::now();
+    mMaster->audio_compute_and_fill(buffers, frames);
+    const uint64_t nanos = Profiler::now() - start;
+
+    mComputeNanos += nanos;
+    if (static_cast<double>(nanos) > 1e9 * frames / mSampleRate)
+      mOverruns++;
+    mPeriods++;
+    frame += frames;
+
+    //what the consumer thread would do
+    scheduler->execute_done_actions();
+    while (Command * cmd = scheduler->pop_complete_command())
+      delete cmd;
+    mStats.update(profiler);
+
+    for (unsigned int i = 0; i < 2; i++) {
+      if (!files[i])
+        continue;
+      for (unsigned int j = 0; j < frames; j++) {
+        interleaved[2 * j] = outputs[2 * i][j];
+        interleaved[2 * j + 1] = outputs[2 * i + 1][j];
+      }
+      files[i].writef(&interleaved.front(), frames);
+    }
+  }
+  mFrames += total;
+  return true;
+}
+
+void OfflineRenderer::report(std::ostream& out) const {
+  const double compute_seconds = static_cast<double>(mComputeNanos) / 1e9;
+  const double audio_seconds = static_cast<double>(mFrames) / mSampleRate;
+  out << std::fixed << std::setprecision(2);
+  out << "rendered: " << audio_seconds << " seconds, " << mPeriods << " periods of " << mBufferFrames
+    << " frames at " << mSampleRate << "hz, " << mMaster->players().size() << " players" << std::endl;
+  if (compute_seconds > 0) {
+    out << "compute: " << compute_seconds << " seconds, " << static_cast<double>(mFrames) / compute_seconds
+      << " frames/second, " << audio_seconds / compute_seconds << "x realtime" << std::endl;
+  }
+  out << "over budget: " << mOverruns << " periods, budget " << 1e6 * mBufferFrames / mSampleRate << "us" << std::endl;
+  if (mMaster->profiler()->dropped())
+    out << "dropped profile samples: " << mMaster->profiler()->dropped() << std::endl;
+
+  out << std::endl << std::left << std::setw(12) << "stage" << std::right
+    << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::setw(12) << "count" << std::endl;
+  std::vector<ProfileStats::stage_stats_t> stats = mStats.stats();
+  for (const ProfileStats::stage_stats_t& s : stats) {
+    out << std::left << std::setw(12) << s.name << std::right
+      << std::setw(12) << s.p50 << std::setw(12) << s.p99 << std::setw(12) << s.max << std::setw(12) << s.count << std::endl;
+  }
+}
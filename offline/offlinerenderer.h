@@ -0,0 +1,65 @@
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include "audiobuffer.hpp"
+#include "annotation.hpp"
+#include "profiler.hpp"
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <vector>
+#include <ostream>
+
+namespace djaudio {
+  class Master;
+  class Command;
+}
+
+//drives the engine without jack, computing periods back to back from a scripted timeline
+//and timing each one, so the engine can be benchmarked and listened to on a machine without a sound card
+class OfflineRenderer {
+  public:
+    //the master must already have its players added
+    OfflineRenderer(unsigned int sampleRate, unsigned int bufferFrames);
+    ~OfflineRenderer();
+
+    //parse a timeline, one event per line: <seconds> <action> [arguments..]
+    //audio is loaded and the commands created here, so rendering only times the engine
+    //returns false and fills in error on a bad line
+    bool addScript(const QString& script, QString& error);
+
+    //compute seconds of audio, writing the main and cue outputs as wav files if the paths aren't empty
+    bool render(double seconds, const QString& outputFile, const QString& cueOutputFile, QString& error);
+
+    //frames per second, the per stage and per period time distributions
+    void report(std::ostream& out) const;
+  private:
+    struct event_t {
+      unsigned int frame;
+      djaudio::Command * command;
+    };
+
+    bool addEvent(double seconds, const QStringList& args, QString& error);
+    bool load(const QStringList& args, QString& error);
+    //write a stereo click and bass loop at bpm, returns the path of the temporary wav
+    QString synthesize(double bpm, double seconds);
+
+    djaudio::Master * mMaster;
+    unsigned int mSampleRate;
+    unsigned int mBufferFrames;
+
+    //sorted by frame, the order added within a frame
+    std::vector<event_t> mEvents;
+    std::size_t mNextEvent;
+
+    QList<djaudio::AudioBufferPtr> mAudioBuffers;
+    QList<djaudio::BeatBufferPtr> mBeatBuffers;
+
+    djaudio::ProfileStats mStats;
+    unsigned long mFrames;
+    unsigned long mPeriods;
+    unsigned long mOverruns;
+    uint64_t mComputeNanos;
+};
+
+#endif // OFFLINERENDERER_H
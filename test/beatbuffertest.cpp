@@ -0,0 +1,115 @@
+#include "test.h"
+#include "annotation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace djaudio;
+
+namespace {
+  //the lookup the hinted walk replaced
+  int search_index(const BeatBuffer& beats, int frame) {
+    BeatBuffer::const_iterator it = std::upper_bound(beats.begin(), beats.end(), frame);
+    if (it == beats.end())
+      return beats.size() - 1;
+    if (it == beats.begin())
+      return 0;
+    return it - beats.begin() - 1;
+  }
+
+  int search_closest(const BeatBuffer& beats, int frame) {
+    int beat = search_index(beats, frame);
+    if (beat + 1 == static_cast<int>(beats.size()))
+      return beat;
+    return frame - beats[beat] < beats[beat + 1] - frame ? beat : beat + 1;
+  }
+
+  int check(const BeatBuffer& beats, int frame, int hint, const char * what) {
+    int failures = 0;
+    const int index = beats.beat_index(frame, hint);
+    if (index != search_index(beats, frame)) {
+      std::cout << "beat_index " << what << " frame " << frame << " hint " << hint << " got " << index << " expected " << search_index(beats, frame) << std::endl;
+      failures++;
+    }
+    const int closest = beats.closest_index(frame, hint);
+    if (closest != search_closest(beats, frame)) {
+      std::cout << "closest_index " << what << " frame " << frame << " hint " << hint << " got " << closest << " expected " << search_closest(beats, frame) << std::endl;
+      failures++;
+    }
+    return failures;
+  }
+
+  int check_value(double got, double expected, const char * what, unsigned int beat) {
+    if (fabs(got - expected) <= 1e-9 * std::max(1.0, fabs(expected)))
+      return 0;
+    std::cout << what << " at beat " << beat << " got " << got << " expected " << expected << std::endl;
+    return 1;
+  }
+}
+
+int beat_buffer_test() {
+  //uneven beats, like a track with a drifting tempo
+  BeatBuffer beats;
+  unsigned int seed = 1;
+  int frame = 1000;
+  for (unsigned int i = 0; i < 400; i++) {
+    beats.push_back(frame);
+    seed = seed * 1664525u + 1013904223u;
+    frame += 20000 + static_cast<int>(seed >> 20);
+  }
+  beats.update();
+  const int first = beats.front();
+  const int last = beats.back();
+
+  int failures = 0;
+  //outside the beats, with and without hints
+  const int outside[] = {0, first - 1, first, last, last + 1, last + 100000};
+  for (int f : outside) {
+    failures += check(beats, f, -1, "outside");
+    failures += check(beats, f, 0, "outside");
+    failures += check(beats, f, beats.size() - 1, "outside");
+    failures += check(beats, f, beats.size(), "outside");
+  }
+
+  //playing forward and backward a block at a time from the last result, the player's pattern
+  int hint = -1;
+  for (int f = 0; f < last + 50000; f += 512) {
+    failures += check(beats, f, hint, "forward");
+    hint = beats.beat_index(f, hint);
+  }
+  for (int f = last + 50000; f >= 0; f -= 512) {
+    failures += check(beats, f, hint, "backward");
+    hint = beats.beat_index(f, hint);
+  }
+
+  //jumps of up to a few beats, right at the walk's limit, and across the track
+  for (unsigned int i = 0; i < 4000; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    const int h = static_cast<int>((seed >> 8) % beats.size());
+    seed = seed * 1664525u + 1013904223u;
+    const int distance = static_cast<int>((seed >> 8) % 9) - 4;
+    const int target = std::min(std::max(h + distance, 0), static_cast<int>(beats.size()) - 1);
+    seed = seed * 1664525u + 1013904223u;
+    const int within = static_cast<int>((seed >> 8) % 20000);
+    failures += check(beats, beats[target] + within - 1, h, "near");
+    failures += check(beats, beats[target], h, "near");
+    seed = seed * 1664525u + 1013904223u;
+    failures += check(beats, static_cast<int>((seed >> 8) % static_cast<unsigned int>(last + 50000)), h, "far");
+  }
+
+  //move beats without an update, the same size, the lengths must follow the beats not the stale values
+  const unsigned int moved[] = {0, 10, 200, static_cast<unsigned int>(beats.size()) - 1};
+  for (unsigned int beat : moved)
+    beats[beat] += 777;
+  for (unsigned int beat : moved) {
+    for (unsigned int b = beat > 0 ? beat - 1 : 0; b <= beat + 1 && b < beats.size(); b++) {
+      const unsigned int length_beat = b + 1 < beats.size() ? b : b - 1;
+      const int length = beats[length_beat + 1] - beats[length_beat];
+      failures += check_value(beats.beat_frames(b), length, "beat_frames after a move", b);
+      failures += check_value(beats.bpm(b, 44100), 60.0 * 44100.0 / length, "bpm after a move", b);
+      if (b + 1 < beats.size())
+        failures += check_value(beats.pos_in_beat(beats[b] + length / 2, b), static_cast<double>(length / 2) / length, "pos_in_beat after a move", b);
+    }
+  }
+  return failures;
+}
@@ -0,0 +1,119 @@
+#include "test.h"
+#include "equalizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace djaudio;
+
+namespace {
+  const unsigned int SAMPLE_RATE = 44100;
+  const unsigned int BLOCK = 256;
+  //long enough for the gains and the filters to settle, then measured over the rest
+  const unsigned int SETTLE_FRAMES = SAMPLE_RATE / 2;
+  const unsigned int MEASURE_FRAMES = SAMPLE_RATE / 4;
+
+  double rms_db(const std::vector<float>& out, const std::vector<float>& in) {
+    double o = 0.0, i = 0.0;
+    for (unsigned int f = SETTLE_FRAMES; f < out.size(); f++) {
+      o += static_cast<double>(out[f]) * out[f];
+      i += static_cast<double>(in[f]) * in[f];
+    }
+    if (i <= 0.0)
+      return o > 0.0 ? 100.0 : 0.0;
+    return 10.0 * log10(std::max(o, 1e-30) / i);
+  }
+
+  //the gain of a sine at frequency through an eq with the given band settings, in db, per channel,
+  //the right channel gets the sine a quarter turn later so the lanes are told apart
+  void response(double frequency, const double * bands, double * db) {
+    Equalizer eq;
+    eq.setup(SAMPLE_RATE, 250.0f, 2500.0f);
+    for (unsigned int b = 0; b < 3; b++)
+      eq.band(static_cast<dj::eq_band_t>(b), bands[b]);
+
+    const unsigned int frames = SETTLE_FRAMES + MEASURE_FRAMES;
+    std::vector<float> in[2], out[2];
+    for (unsigned int c = 0; c < 2; c++) {
+      in[c].resize(frames);
+      for (unsigned int f = 0; f < frames; f++)
+        in[c][f] = static_cast<float>(0.5 * sin(2.0 * M_PI * frequency * f / SAMPLE_RATE + c * M_PI / 2.0));
+      out[c] = in[c];
+    }
+    for (unsigned int f = 0; f < frames; f += BLOCK) {
+      float * buffer[2] = {&out[0][f], &out[1][f]};
+      eq.compute(std::min(BLOCK, frames - f), buffer);
+    }
+    for (unsigned int c = 0; c < 2; c++)
+      db[c] = rms_db(out[c], in[c]);
+  }
+
+  //expect the gain between low and high db
+  int check(const char * what, double frequency, const double * bands, double low, double high) {
+    double db[2];
+    response(frequency, bands, db);
+    int failures = 0;
+    for (unsigned int c = 0; c < 2; c++) {
+      if (db[c] >= low && db[c] <= high)
+        continue;
+      std::cout << "equalizer " << what << " at " << frequency << "hz channel " << c << " got " << db[c] << "db expected " << low << ".." << high << std::endl;
+      failures++;
+    }
+    return failures;
+  }
+
+  //a left only impulse stays out of the right channel
+  int check_channels() {
+    Equalizer eq;
+    eq.setup(SAMPLE_RATE, 250.0f, 2500.0f);
+    eq.band(dj::MID, 1.0);
+    std::vector<float> left(BLOCK * 16, 0.0f), right(BLOCK * 16, 0.0f);
+    left[10] = 1.0f;
+    for (unsigned int f = 0; f < left.size(); f += BLOCK) {
+      float * buffer[2] = {&left[f], &right[f]};
+      eq.compute(BLOCK, buffer);
+    }
+    for (float v : right) {
+      if (v != 0.0f) {
+        std::cout << "equalizer left impulse leaked into the right channel: " << v << std::endl;
+        return 1;
+      }
+    }
+    return 0;
+  }
+}
+
+int equalizer_test() {
+  int failures = 0;
+  //at unity the bands sum back to an allpass, flat everywhere including at the crossovers
+  const double unity[3] = {0.0, 0.0, 0.0};
+  const double frequencies[] = {30.0, 250.0, 790.0, 2500.0, 12000.0};
+  for (double f : frequencies)
+    failures += check("unity", f, unity, -0.05, 0.05);
+
+  //a killed band is gone in its middle and the others are untouched
+  const double low_kill[3] = {-1.0, 0.0, 0.0};
+  failures += check("low kill", 30.0, low_kill, -200.0, -40.0);
+  failures += check("low kill", 790.0, low_kill, -0.5, 0.5);
+  failures += check("low kill", 12000.0, low_kill, -0.05, 0.05);
+  const double mid_kill[3] = {0.0, -1.0, 0.0};
+  failures += check("mid kill", 790.0, mid_kill, -200.0, -25.0);
+  failures += check("mid kill", 30.0, mid_kill, -0.1, 0.1);
+  failures += check("mid kill", 12000.0, mid_kill, -0.1, 0.1);
+  const double high_kill[3] = {0.0, 0.0, -1.0};
+  failures += check("high kill", 12000.0, high_kill, -200.0, -40.0);
+  failures += check("high kill", 30.0, high_kill, -0.05, 0.05);
+  failures += check("high kill", 790.0, high_kill, -0.5, 0.5);
+
+  //a full boost is 6db
+  const double low_boost[3] = {1.0, 0.0, 0.0};
+  failures += check("low boost", 30.0, low_boost, 5.9, 6.1);
+  const double mid_boost[3] = {0.0, 1.0, 0.0};
+  failures += check("mid boost", 790.0, mid_boost, 5.5, 6.5);
+  const double high_boost[3] = {0.0, 0.0, 1.0};
+  failures += check("high boost", 12000.0, high_boost, 5.9, 6.1);
+
+  failures += check_channels();
+  return failures;
+}
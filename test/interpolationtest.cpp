@@ -0,0 +1,65 @@
+#include "test.h"
+#include "interpolation.hpp"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace djaudio;
+
+namespace {
+  const unsigned int FRAMES = 256;
+  //a slow sine, each mode should come close to it anywhere between frames
+  float source_at(double pos) { return static_cast<float>(sin(pos * 0.05)); }
+
+  const char * name(interpolation_t mode) {
+    switch (mode) {
+      case INTERPOLATE_LINEAR: return "linear";
+      case INTERPOLATE_CUBIC: return "cubic";
+      default: return "sinc";
+    }
+  }
+
+  //interpolate frames from index + subsample, step apart, and compare to the sine
+  int check(interpolation_t mode, const SampleSource& source, unsigned int frames, unsigned int index, double subsample, double step) {
+    std::vector<float> left(frames), right(frames);
+    float * out[2] = {&left.front(), &right.front()};
+    interpolate_block(mode, source, out, frames, index, subsample, step);
+    int failures = 0;
+    for (unsigned int i = 0; i < frames; i++) {
+      const double pos = static_cast<double>(index) + subsample + static_cast<double>(i) * step;
+      const float expected = source_at(pos);
+      for (unsigned int c = 0; c < 2; c++) {
+        if (std::isfinite(out[c][i]) && fabsf(out[c][i] - expected) < 0.01f)
+          continue;
+        std::cout << "interpolation " << name(mode) << " at " << pos << " got " << out[c][i] << " expected " << expected << std::endl;
+        failures++;
+      }
+    }
+    return failures;
+  }
+}
+
+int interpolation_test() {
+  std::vector<float> interleaved(2 * FRAMES);
+  for (unsigned int i = 0; i < FRAMES; i++)
+    interleaved[2 * i] = interleaved[2 * i + 1] = source_at(i);
+  SampleSource source;
+  source.channel[0] = &interleaved.front();
+  source.channel[1] = &interleaved.front() + 1;
+  source.stride = 2;
+  source.frames = FRAMES;
+
+  //just below a whole frame rounds up to 1 as a float, it must still read inside the tables and the source
+  const double below_one = 1.0 - 1e-9;
+  int failures = 0;
+  const interpolation_t modes[] = {INTERPOLATE_LINEAR, INTERPOLATE_CUBIC, INTERPOLATE_SINC};
+  for (interpolation_t mode : modes) {
+    //in the middle with the vector kernels, standing still and moving
+    failures += check(mode, source, 32, FRAMES / 2, below_one, 0.0);
+    failures += check(mode, source, 32, FRAMES / 2, below_one, 1.0);
+    failures += check(mode, source, 32, FRAMES / 2, 0.5, 1.0 - 1e-9);
+    //each frame lands just below a whole one
+    failures += check(mode, source, 32, FRAMES / 2, 0.0, 2.0 - 1e-9);
+  }
+  return failures;
+}
@@ -0,0 +1,12 @@
+#include "test.h"
+#include <iostream>
+
+//regression checks for the engine, exits non zero if any fail
+int main() {
+  int failures = 0;
+  failures += interpolation_test();
+  failures += beat_buffer_test();
+  failures += equalizer_test();
+  std::cout << (failures ? "FAILED: " : "passed") << (failures ? std::to_string(failures) : std::string()) << std::endl;
+  return failures ? 1 : 0;
+}
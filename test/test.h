@@ -0,0 +1,9 @@
+#ifndef DATAJOCKEY_TEST_H
+#define DATAJOCKEY_TEST_H
+
+//the checks return the number of failures, printing each one
+int interpolation_test();
+int beat_buffer_test();
+int equalizer_test();
+
+#endif // DATAJOCKEY_TEST_H
@@ -0,0 +1,59 @@
+QT       += core
+QT       -= gui
+
+TARGET = datajockey_test
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG += c++11
+
+TEMPLATE = app
+
+#the same float flags as the app
+QMAKE_CXXFLAGS += -fexceptions
+DENORMAL_FLAGS = -msse -mfpmath=sse -ffast-math
+_TRAVIS = $$(TRAVIS)
+isEmpty(_TRAVIS) {
+	QMAKE_CXXFLAGS += $$DENORMAL_FLAGS
+}
+
+MOC_DIR = moc/
+OBJECTS_DIR = obj/
+
+INCLUDEPATH += ../app/ \
+  ../app/audio/
+
+SOURCES += main.cpp \
+    interpolationtest.cpp \
+    beatbuffertest.cpp \
+    equalizertest.cpp \
+    ../app/config.cpp \
+    ../app/defines.cpp \
+    ../app/audio/annotation.cpp \
+    ../app/audio/equalizer.cpp \
+    ../app/audio/interpolation.cpp \
+    ../app/audio/sampleformat.cpp \
+    ../app/audio/simd.cpp
+
+HEADERS += \
+    test.h \
+    ../app/config.hpp \
+    ../app/defines.hpp \
+    ../app/audio/annotation.hpp \
+    ../app/audio/equalizer.hpp \
+    ../app/audio/interpolation.hpp \
+    ../app/audio/sampleformat.hpp \
+    ../app/audio/simd.hpp
+
+#the annotation reads and writes yaml
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../ext/build-yaml-cpp-default/release/ -lyaml-cpp
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../ext/build-yaml-cpp-default/debug/ -lyaml-cpp
+else:unix: LIBS += -L$$PWD/../ext/build-yaml-cpp-default/ -lyaml-cpp
+
+INCLUDEPATH += $$PWD/../ext/yaml-cpp/include
+DEPENDPATH += $$PWD/../ext/yaml-cpp/include
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/release/libyaml-cpp.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/debug/libyaml-cpp.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/release/yaml-cpp.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/debug/yaml-cpp.lib
+else:unix: PRE_TARGETDEPS += $$PWD/../ext/build-yaml-cpp-default/libyaml-cpp.a